@@ -10,8 +10,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "Precompiled.h"
 #include "CApplicationSettings.h"
+#include "CFileDataSourcesReciever.h"
 #include <DaggyCore/CDataSourcesFabric.h>
 
+#include <limits>
+
 using namespace daggycore;
 
 CApplicationSettings::CApplicationSettings()
@@ -28,10 +31,58 @@ CApplicationSettings::CApplicationSettings()
     const QCommandLineOption output_folder_option({"o", "output"}, "Set output folder", "folder", "");
     const QCommandLineOption input_format_option({"f", "format"}, "Source format", "format", data_sources_fabric.inputTypeName(CDataSourcesFabric::json));
     const QCommandLineOption input_from_stdin_option({"i", "stdin"}, "Read data sources from stdin");
+    const QCommandLineOption flush_size_option("flush-size", "Flush output file buffer after it reaches size", "bytes",
+                                               QString::number(COutputFilesWriter::default_flush_bytes_global));
+    const QCommandLineOption flush_interval_option("flush-interval", "Flush output file buffer not later than interval", "milliseconds",
+                                                   QString::number(COutputFilesWriter::default_flush_milliseconds_global));
+    const QCommandLineOption write_queue_size_option("write-queue-size", "Maximum size of data waiting for write to output files", "bytes",
+                                                     QString::number(COutputFilesWriter::default_max_queued_bytes_global));
+    const QCommandLineOption rotate_size_option("rotate-size", "Start new output file segment after the current one reaches size. 0 - unlimited", "bytes", "0");
+    const QCommandLineOption rotate_interval_option("rotate-interval", "Start new output file segment every interval, aligned to the wall clock. 0 - never", "seconds", "0");
+    const QCommandLineOption rotate_naming_option("rotate-naming", "Suffix of closed output file segments: number, time", "naming", "number");
+    const QCommandLineOption rotate_keep_option("rotate-keep", "Maximum number of closed segments kept per output file. 0 - unlimited", "count", "0");
+    const QCommandLineOption rotate_compress_option("rotate-compress", "Gzip closed output file segments in background");
+    const QCommandLineOption compression_option("compression", "Compress output files of commands without own compression field: none, gzip", "method", "none");
+    const QCommandLineOption compression_level_option("compression-level", "Output files compression level, from 1 (fastest) to 9 (smallest)", "level",
+                                                      QString::number(COutputFilesWriter::default_compression_level_global));
+    const QCommandLineOption merge_option("merge", "Also write lines of all commands ordered by receive time to file in output folder", "file", "");
+    const QCommandLineOption merge_window_option("merge-window", "How long lines are held to be ordered in merged file", "milliseconds",
+                                                 QString::number(COutputFilesWriter::default_merge_window_milliseconds_global));
+    const QCommandLineOption output_format_option("output-format", "Output files format of commands without own outputFormat field: raw, records (lines with receive time and sequence number), frames (the same as binary length-prefixed frames)", "format", "raw");
+    const QCommandLineOption std_error_rate_option("stderr-rate", "Maximum number of stderr messages printed per second for each command, the rest is summarized. 0 - unlimited", "count",
+                                                   QString::number(CFileDataSourcesReciever::default_std_error_rate_global));
+    const QCommandLineOption max_handshakes_option("max-handshakes", "Maximum number of connections in handshake at the same time. 0 - unlimited", "count",
+                                                   QString::number(CConnectionScheduler::default_max_in_flight_global));
+    const QCommandLineOption start_rate_option("start-rate", "Maximum number of connections started per second. 0 - unlimited", "rate",
+                                               QString::number(CConnectionScheduler::default_start_rate_global));
+    const QCommandLineOption stats_interval_option("stats-interval", "Print stream, connection and write statistics every interval. 0 - never", "seconds", "0");
+    const QCommandLineOption metrics_port_option("metrics-port", "Serve metrics in Prometheus text format on localhost port. 0 - disabled", "port", "0");
+    const QCommandLineOption trace_option("trace", "Record hot path trace points, write them as Chrome trace to file on SIGUSR1 and at exit", "file", "");
+    const QCommandLineOption threads_option("threads", "Number of worker threads for data sources connections. 0 - thread per CPU core", "count", "1");
 
     command_line_parser.addOption(output_folder_option);
     command_line_parser.addOption(input_format_option);
     command_line_parser.addOption(input_from_stdin_option);
+    command_line_parser.addOption(flush_size_option);
+    command_line_parser.addOption(flush_interval_option);
+    command_line_parser.addOption(write_queue_size_option);
+    command_line_parser.addOption(rotate_size_option);
+    command_line_parser.addOption(rotate_interval_option);
+    command_line_parser.addOption(rotate_naming_option);
+    command_line_parser.addOption(rotate_keep_option);
+    command_line_parser.addOption(rotate_compress_option);
+    command_line_parser.addOption(compression_option);
+    command_line_parser.addOption(compression_level_option);
+    command_line_parser.addOption(output_format_option);
+    command_line_parser.addOption(merge_option);
+    command_line_parser.addOption(merge_window_option);
+    command_line_parser.addOption(std_error_rate_option);
+    command_line_parser.addOption(stats_interval_option);
+    command_line_parser.addOption(metrics_port_option);
+    command_line_parser.addOption(trace_option);
+    command_line_parser.addOption(threads_option);
+    command_line_parser.addOption(max_handshakes_option);
+    command_line_parser.addOption(start_rate_option);
 
     command_line_parser.setApplicationDescription(APP_DESCRIPTION);
     command_line_parser.addHelpOption();
@@ -69,6 +120,57 @@ CApplicationSettings::CApplicationSettings()
 
     if (output_folder_.isEmpty())
         output_folder_ = getOutputFolderPath(data_source_name);
+
+    flush_policy_.bytes = getNumberOption("flush-size", command_line_parser.value(flush_size_option));
+    flush_policy_.milliseconds = static_cast<int>(getNumberOption("flush-interval", command_line_parser.value(flush_interval_option)));
+    max_queued_bytes_ = getNumberOption("write-queue-size", command_line_parser.value(write_queue_size_option));
+    rotation_policy_.bytes = getNumberOption("rotate-size", command_line_parser.value(rotate_size_option));
+    rotation_policy_.seconds = static_cast<int>(getNumberOption("rotate-interval", command_line_parser.value(rotate_interval_option)));
+    bool is_naming_ok = false;
+    rotation_policy_.naming = COutputFilesWriter::segmentNaming(command_line_parser.value(rotate_naming_option), &is_naming_ok);
+    if (!is_naming_ok) {
+        throw std::invalid_argument(QString("Invalid rotate-naming value: %1")
+                                    .arg(command_line_parser.value(rotate_naming_option))
+                                    .toStdString());
+    }
+    rotation_policy_.keep = static_cast<int>(getNumberOption("rotate-keep", command_line_parser.value(rotate_keep_option)));
+    rotation_policy_.compress = command_line_parser.isSet(rotate_compress_option);
+#ifndef DAGGY_ZLIB
+    if (rotation_policy_.compress)
+        throw std::invalid_argument("Invalid rotate-compress value: daggy is built without zlib");
+#endif
+    compression_ = getCompressionOption("compression", command_line_parser.value(compression_option));
+    compression_level_ = static_cast<int>(getNumberOption("compression-level", command_line_parser.value(compression_level_option)));
+    if (compression_level_ < 1 || compression_level_ > 9) {
+        throw std::invalid_argument(QString("Invalid compression-level value: %1")
+                                    .arg(compression_level_)
+                                    .toStdString());
+    }
+    merge_policy_.file_path = command_line_parser.value(merge_option);
+    merge_policy_.window_milliseconds = static_cast<int>(getNumberOption("merge-window", command_line_parser.value(merge_window_option)));
+    merge_policy_.compression = compression_;
+    output_format_ = getFormatOption("output-format", command_line_parser.value(output_format_option));
+    std_error_rate_ = static_cast<int>(getNumberOption("stderr-rate", command_line_parser.value(std_error_rate_option)));
+    for (const DataSource& data_source : data_sources_) {
+        for (const RemoteCommand& remote_command : data_source.remote_commands) {
+            getCompressionOption(QString("%1 compression for %2").arg(data_source.server_name, remote_command.command_name),
+                                 remote_command.output_compression);
+            getFormatOption(QString("%1 outputFormat for %2").arg(data_source.server_name, remote_command.command_name),
+                            remote_command.output_format);
+        }
+    }
+    stats_interval_ = static_cast<int>(getNumberOption("stats-interval", command_line_parser.value(stats_interval_option)));
+    const qint64 metrics_port = getNumberOption("metrics-port", command_line_parser.value(metrics_port_option));
+    if (metrics_port > std::numeric_limits<quint16>::max()) {
+        throw std::invalid_argument(QString("Invalid metrics-port value: %1")
+                                    .arg(metrics_port)
+                                    .toStdString());
+    }
+    metrics_port_ = static_cast<int>(metrics_port);
+    trace_file_ = command_line_parser.value(trace_option);
+    threads_count_ = static_cast<int>(getNumberOption("threads", command_line_parser.value(threads_option)));
+    connection_policy_.max_in_flight = static_cast<int>(getNumberOption("max-handshakes", command_line_parser.value(max_handshakes_option)));
+    connection_policy_.start_rate = getRateOption("start-rate", command_line_parser.value(start_rate_option));
 }
 
 const QString& CApplicationSettings::outputFolder() const
@@ -81,6 +183,71 @@ const DataSources& CApplicationSettings::dataSources() const
     return data_sources_;
 }
 
+const COutputFilesWriter::FlushPolicy& CApplicationSettings::flushPolicy() const
+{
+    return flush_policy_;
+}
+
+const COutputFilesWriter::RotationPolicy& CApplicationSettings::rotationPolicy() const
+{
+    return rotation_policy_;
+}
+
+const COutputFilesWriter::MergePolicy& CApplicationSettings::mergePolicy() const
+{
+    return merge_policy_;
+}
+
+qint64 CApplicationSettings::maxQueuedBytes() const
+{
+    return max_queued_bytes_;
+}
+
+COutputFilesWriter::Compression CApplicationSettings::compression() const
+{
+    return compression_;
+}
+
+int CApplicationSettings::compressionLevel() const
+{
+    return compression_level_;
+}
+
+COutputFilesWriter::Format CApplicationSettings::outputFormat() const
+{
+    return output_format_;
+}
+
+int CApplicationSettings::stdErrorRate() const
+{
+    return std_error_rate_;
+}
+
+int CApplicationSettings::statsInterval() const
+{
+    return stats_interval_;
+}
+
+int CApplicationSettings::metricsPort() const
+{
+    return metrics_port_;
+}
+
+const QString& CApplicationSettings::traceFile() const
+{
+    return trace_file_;
+}
+
+int CApplicationSettings::threadsCount() const
+{
+    return threads_count_;
+}
+
+const CConnectionScheduler::Policy& CApplicationSettings::connectionPolicy() const
+{
+    return connection_policy_;
+}
+
 QString CApplicationSettings::getOutputFolderPath(const QString& data_source_name) const
 {
     const QString& current_date = QDateTime::currentDateTime().toString("dd-MM-yy_hh-mm-ss");
@@ -106,3 +273,51 @@ QString CApplicationSettings::getTextFromFile(QString file_path) const
 
     return result;
 }
+
+qint64 CApplicationSettings::getNumberOption(const QString& option_name, const QString& value) const
+{
+    bool is_ok = false;
+    const qint64 result = value.toLongLong(&is_ok);
+    if (!is_ok || result < 0) {
+        throw std::invalid_argument(QString("Invalid %1 value: %2")
+                                    .arg(option_name, value)
+                                    .toStdString());
+    }
+    return result;
+}
+
+COutputFilesWriter::Compression CApplicationSettings::getCompressionOption(const QString& option_name, const QString& value) const
+{
+    bool is_ok = false;
+    const COutputFilesWriter::Compression result = COutputFilesWriter::compression(value, &is_ok);
+    if (!is_ok) {
+        throw std::invalid_argument(QString("Invalid %1 value: %2")
+                                    .arg(option_name, value)
+                                    .toStdString());
+    }
+    return result;
+}
+
+COutputFilesWriter::Format CApplicationSettings::getFormatOption(const QString& option_name, const QString& value) const
+{
+    bool is_ok = false;
+    const COutputFilesWriter::Format result = COutputFilesWriter::format(value, &is_ok);
+    if (!is_ok) {
+        throw std::invalid_argument(QString("Invalid %1 value: %2")
+                                    .arg(option_name, value)
+                                    .toStdString());
+    }
+    return result;
+}
+
+double CApplicationSettings::getRateOption(const QString& option_name, const QString& value) const
+{
+    bool is_ok = false;
+    const double result = value.toDouble(&is_ok);
+    if (!is_ok || result < 0) {
+        throw std::invalid_argument(QString("Invalid %1 value: %2")
+                                    .arg(option_name, value)
+                                    .toStdString());
+    }
+    return result;
+}
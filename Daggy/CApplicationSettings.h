@@ -15,6 +15,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <QVariantMap>
 
 #include <DaggyCore/DataSource.h>
+#include <DaggyCore/CConnectionScheduler.h>
+
+#include "COutputFilesWriter.h"
 
 class QCoreApplication;
 
@@ -27,15 +30,52 @@ public:
 
     const daggycore::DataSources& dataSources() const;
 
+    const COutputFilesWriter::FlushPolicy& flushPolicy() const;
+    const COutputFilesWriter::RotationPolicy& rotationPolicy() const;
+    // File path is relative to output folder
+    const COutputFilesWriter::MergePolicy& mergePolicy() const;
+    qint64 maxQueuedBytes() const;
+    COutputFilesWriter::Compression compression() const;
+    int compressionLevel() const;
+    COutputFilesWriter::Format outputFormat() const;
+    int stdErrorRate() const;
+    // Seconds, 0 - no periodic statistics
+    int statsInterval() const;
+    // 0 - no metrics endpoint
+    int metricsPort() const;
+    // Empty - tracing is disabled
+    const QString& traceFile() const;
+
+    int threadsCount() const;
+    const daggycore::CConnectionScheduler::Policy& connectionPolicy() const;
+
 private:
     QString getOutputFolderPath(const QString& data_source_name) const;
     QString getTextFromFile(QString file_path) const;
+    qint64 getNumberOption(const QString& option_name, const QString& value) const;
+    double getRateOption(const QString& option_name, const QString& value) const;
     daggycore::DataSources dataSources(const QString& data_sources_text) const;
+    COutputFilesWriter::Compression getCompressionOption(const QString& option_name, const QString& value) const;
+    COutputFilesWriter::Format getFormatOption(const QString& option_name, const QString& value) const;
 
 
     QString output_folder_;
 
     daggycore::DataSources data_sources_;
+
+    COutputFilesWriter::FlushPolicy flush_policy_;
+    COutputFilesWriter::RotationPolicy rotation_policy_;
+    COutputFilesWriter::MergePolicy merge_policy_;
+    qint64 max_queued_bytes_;
+    COutputFilesWriter::Compression compression_;
+    int compression_level_;
+    COutputFilesWriter::Format output_format_;
+    int std_error_rate_;
+    int stats_interval_;
+    int metrics_port_;
+    QString trace_file_;
+    int threads_count_;
+    daggycore::CConnectionScheduler::Policy connection_policy_;
 };
 
 #endif // CAPPLICATIONSETTINGS_H
@@ -20,24 +20,50 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "CApplicationSettings.h"
 
 #include <DaggyCore/CDaggy.h>
+#include <ssh/sshtrace.h>
 
 using namespace daggycore;
 
-CConsoleDaggy::CConsoleDaggy( const DataSources& data_sources, const QString& output_folder, QObject* parent_ptr )
+CConsoleDaggy::CConsoleDaggy( const CApplicationSettings& settings, QObject* parent_ptr )
   : QObject( parent_ptr )
-  , file_remote_agregator_reciever_( output_folder )
-  , data_agregator_( data_sources )
+  , ISystemSignalHandler( settings.traceFile().isEmpty() ? DEFAULT_SIGNALS : DEFAULT_SIGNALS | SIG_DUMP )
+  , file_remote_agregator_reciever_( settings.outputFolder(), settings.flushPolicy(), settings.rotationPolicy(), settings.mergePolicy(), settings.maxQueuedBytes(),
+                                     settings.compression(), settings.compressionLevel(), settings.outputFormat(),
+                                     settings.stdErrorRate() )
+  , data_agregator_( settings.dataSources() )
+  , metrics_port_( settings.metricsPort() )
+  , trace_file_( settings.traceFile() )
+  , last_totals_( CMetrics::instance().totals() )
   , stopped_( false )
   , interruption_count_( 0 )
 {
+     data_agregator_.setThreadsCount( settings.threadsCount() );
+     data_agregator_.setConnectionPolicy( settings.connectionPolicy() );
      data_agregator_.connectRemoteAgregatorReciever( &file_remote_agregator_reciever_ );
 
      connect( this, &CConsoleDaggy::interrupted, this, &CConsoleDaggy::handleInterruption );
+     // Emitted from the signal handler, the trace is written later by the event loop
+     connect( this, &CConsoleDaggy::traceDumpRequested, this, &CConsoleDaggy::writeTrace, Qt::QueuedConnection );
      connect( &data_agregator_, &CDaggy::stateChanged, this, &CConsoleDaggy::onDaggyStateChange );
+
+     stats_timer_.setInterval( settings.statsInterval() * 1000 );
+     connect( &stats_timer_, &QTimer::timeout, this, &CConsoleDaggy::printStats );
 }
 
 void CConsoleDaggy::start()
 {
+     if ( metrics_port_ > 0 && !metrics_server_.listen( static_cast<quint16>( metrics_port_ ) ) )
+          throw std::runtime_error( QString( "Cannot serve metrics on port %1: %2" )
+                                      .arg( metrics_port_ )
+                                      .arg( metrics_server_.errorString() )
+                                      .toStdString() );
+     QSsh::SshTrace::setEnabled( !trace_file_.isEmpty() );
+     performance_monitor_.start();
+     if ( stats_timer_.interval() > 0 )
+     {
+          stats_elapsed_.start();
+          stats_timer_.start();
+     }
      data_agregator_.start();
 }
 
@@ -49,6 +75,11 @@ bool CConsoleDaggy::handleSystemSignal( const int signal )
           emit interrupted();
           result = true;
      }
+     else if ( signal & SIG_DUMP )
+     {
+          emit traceDumpRequested();
+          result = true;
+     }
      return result;
 }
 
@@ -62,11 +93,100 @@ void CConsoleDaggy::onDaggyStateChange( const IRemoteAgregator::State state )
 {
      if ( state == IRemoteAgregator::State::Stopped )
      {
+          stats_timer_.stop();
+          printStreamStatistics();
+          printStreamChunkSizes();
+          printPerformanceReport();
+          if ( !trace_file_.isEmpty() )
+               writeTrace();
           stopped_ = true;
           qApp->quit();
      }
 }
 
+void CConsoleDaggy::printStreamStatistics()
+{
+     const quint64 delivered_bytes = data_agregator_.deliveredStreamBytes();
+     const quint64 copied_bytes = data_agregator_.copiedStreamBytes();
+     const double copies_per_byte = delivered_bytes > 0 ? static_cast<double>( copied_bytes ) / delivered_bytes : 0;
+     file_remote_agregator_reciever_.printAppStatus( QString( "Stream bytes delivered: %1, copied: %2 (%3 per byte)" )
+                                                       .arg( delivered_bytes )
+                                                       .arg( copied_bytes )
+                                                       .arg( copies_per_byte, 0, 'f', 2 ) );
+
+     const CConnectionScheduler::Statistics& connection_statistics = data_agregator_.connectionStatistics();
+     const qint64 average_wait = connection_statistics.admitted > 0
+                                   ? connection_statistics.total_wait_milliseconds / static_cast<qint64>( connection_statistics.admitted )
+                                   : 0;
+     file_remote_agregator_reciever_.printAppStatus( QString( "Connections started: %1 of %2, queue wait average: %3 ms, max: %4 ms" )
+                                                       .arg( connection_statistics.admitted )
+                                                       .arg( connection_statistics.queued )
+                                                       .arg( average_wait )
+                                                       .arg( connection_statistics.max_wait_milliseconds ) );
+}
+
+void CConsoleDaggy::printStats()
+{
+     const CMetrics::Totals totals = CMetrics::instance().totals();
+     const double seconds = stats_elapsed_.restart() / 1000.0;
+     const quint64 handshakes = totals.handshakes - last_totals_.handshakes;
+     const quint64 writes = totals.writes - last_totals_.writes;
+     const quint64 first_bytes = totals.first_bytes - last_totals_.first_bytes;
+     file_remote_agregator_reciever_.printAppStatus(
+       QString( "Stats: %1 MB/s, %2 chunks/s, commands running: %3, started: %4, reconnects: %5, errors: %6, handshake average: %7 ms, first output average: %8 us, write average: %9 us" )
+         .arg( seconds > 0 ? ( totals.stream_bytes - last_totals_.stream_bytes ) / ( 1024.0 * 1024.0 ) / seconds : 0, 0, 'f', 2 )
+         .arg( seconds > 0 ? ( totals.chunks - last_totals_.chunks ) / seconds : 0, 0, 'f', 0 )
+         .arg( data_agregator_.runingRemoteCommandsCount() )
+         .arg( totals.command_starts - last_totals_.command_starts )
+         .arg( totals.reconnects - last_totals_.reconnects )
+         .arg( totals.connection_errors - last_totals_.connection_errors )
+         .arg( handshakes > 0 ? ( totals.handshake_microseconds - last_totals_.handshake_microseconds ) / handshakes / 1000 : 0 )
+         .arg( first_bytes > 0 ? ( totals.first_byte_microseconds - last_totals_.first_byte_microseconds ) / first_bytes : 0 )
+         .arg( writes > 0 ? ( totals.write_microseconds - last_totals_.write_microseconds ) / writes : 0 ) );
+     last_totals_ = totals;
+}
+
+void CConsoleDaggy::writeTrace()
+{
+     QString error_string;
+     if ( QSsh::SshTrace::writeChromeTrace( trace_file_, &error_string ) )
+          file_remote_agregator_reciever_.printAppStatus( QString( "Trace written to %1" ).arg( trace_file_ ) );
+     else
+          file_remote_agregator_reciever_.printAppStatus( QString( "Cannot write trace to %1: %2" ).arg( trace_file_, error_string ) );
+}
+
+void CConsoleDaggy::printStreamChunkSizes()
+{
+     QStringList buckets;
+     const std::vector<quint64>& chunk_sizes = data_agregator_.streamChunkSizes();
+     for ( size_t bucket = 0; bucket < chunk_sizes.size(); bucket++ )
+     {
+          if ( chunk_sizes[bucket] == 0 )
+               continue;
+          const quint64 bucket_bytes = IRemoteAgregator::streamChunkBucketBytes( static_cast<int>( bucket ) );
+          const QString& bucket_name = bucket == 0 ? QString( "<256B" )
+                                                   : bucket_bytes >= 1024 * 1024 ? QString( "%1M" ).arg( bucket_bytes / ( 1024 * 1024 ) )
+                                                                                 : bucket_bytes >= 1024 ? QString( "%1K" ).arg( bucket_bytes / 1024 )
+                                                                                                        : QString( "%1B" ).arg( bucket_bytes );
+          buckets << QString( "%1: %2" ).arg( bucket_name ).arg( chunk_sizes[bucket] );
+     }
+     file_remote_agregator_reciever_.printAppStatus( QString( "Stream chunks by size: %1" ).arg( buckets.join( ", " ) ) );
+}
+
+void CConsoleDaggy::printPerformanceReport()
+{
+     const CPerformanceMonitor::Report& report = performance_monitor_.report();
+     const double megabytes = data_agregator_.deliveredStreamBytes() / ( 1024.0 * 1024.0 );
+     const double seconds = report.elapsed_milliseconds / 1000.0;
+     file_remote_agregator_reciever_.printAppStatus( QString( "Throughput: %1 MB/s, CPU: %2 ms per MB, peak memory: %3 MB" )
+                                                       .arg( seconds > 0 ? megabytes / seconds : 0, 0, 'f', 2 )
+                                                       .arg( megabytes > 0 ? report.cpu_milliseconds / megabytes : 0, 0, 'f', 2 )
+                                                       .arg( report.peak_memory_bytes / ( 1024 * 1024 ) ) );
+     file_remote_agregator_reciever_.printAppStatus( QString( "Event loop latency average: %1 us, max: %2 us" )
+                                                       .arg( report.average_latency_microseconds )
+                                                       .arg( report.max_latency_microseconds ) );
+}
+
 bool CConsoleDaggy::stopped() const
 {
      return stopped_;
@@ -15,20 +15,25 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "ISystemSignalsHandler.h"
 
 #include "CFileDataSourcesReciever.h"
+#include "CPerformanceMonitor.h"
+#include "CMetricsHttpServer.h"
 
 #include <QStringList>
 #include <QVariantMap>
+#include <QTimer>
+#include <QElapsedTimer>
 
 #include <DaggyCore/CDaggy.h>
+#include <DaggyCore/CMetrics.h>
 
+class CApplicationSettings;
 
 class CConsoleDaggy : public QObject, public ISystemSignalHandler
 {
   Q_OBJECT
 public:
-  CConsoleDaggy(const daggycore::DataSources& data_sources,
-                        const QString& output_folder,
-                        QObject* parent_ptr = nullptr);
+  CConsoleDaggy(const CApplicationSettings& settings,
+                QObject* parent_ptr = nullptr);
 
   void start();
 
@@ -36,6 +41,7 @@ public:
 
 signals:
   void interrupted();
+  void traceDumpRequested();
 
 protected:
   bool handleSystemSignal(const int signal) override;
@@ -43,11 +49,23 @@ protected:
 private slots:
   void handleInterruption();
   void onDaggyStateChange(const daggycore::IRemoteAgregator::State state);
+  void printStats();
+  void writeTrace();
 
 private:
+  void printStreamStatistics();
+  void printPerformanceReport();
+  void printStreamChunkSizes();
 
   CFileDataSourcesReciever file_remote_agregator_reciever_;
   daggycore::CDaggy data_agregator_;
+  CPerformanceMonitor performance_monitor_;
+  const int metrics_port_;
+  const QString trace_file_;
+  CMetricsHttpServer metrics_server_;
+  QTimer stats_timer_;
+  QElapsedTimer stats_elapsed_;
+  daggycore::CMetrics::Totals last_totals_;
   bool stopped_;
   int interruption_count_;
 };
@@ -0,0 +1,84 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "Precompiled.h"
+#include "CConsolePrinter.h"
+
+#include <utility>
+
+CConsolePrinter::CConsolePrinter( const qint64 max_queued_bytes, QObject* parent_ptr )
+  : QThread( parent_ptr )
+  , max_queued_bytes_( max_queued_bytes )
+  , dropped_messages_( 0 )
+  , stopping_( false )
+{
+}
+
+CConsolePrinter::~CConsolePrinter()
+{
+     stop();
+}
+
+void CConsolePrinter::print( const QByteArray& message )
+{
+     {
+          QMutexLocker locker( &mutex_ );
+          if ( isRunning() && !stopping_ )
+          {
+               if ( queue_.size() + message.size() > max_queued_bytes_ )
+                    dropped_messages_++;
+               else
+                    queue_.append( message );
+               queue_not_empty_.wakeOne();
+               return;
+          }
+     }
+
+     // Before start and after stop messages are printed synchronously
+     fwrite( message.constData(), 1, static_cast<size_t>( message.size() ), stdout );
+     fflush( stdout );
+}
+
+void CConsolePrinter::stop()
+{
+     {
+          QMutexLocker locker( &mutex_ );
+          stopping_ = true;
+          queue_not_empty_.wakeAll();
+     }
+     wait();
+}
+
+void CConsolePrinter::run()
+{
+     bool stopped = false;
+     while ( !stopped )
+     {
+          QByteArray batch;
+          quint64 dropped_messages = 0;
+          {
+               QMutexLocker locker( &mutex_ );
+               if ( queue_.isEmpty() && dropped_messages_ == 0 && !stopping_ )
+                    queue_not_empty_.wait( &mutex_ );
+               batch.swap( queue_ );
+               std::swap( dropped_messages, dropped_messages_ );
+               stopped = stopping_ && batch.isEmpty() && dropped_messages == 0;
+          }
+
+          if ( dropped_messages > 0 )
+               batch.append( QString( "... %1 console messages dropped, terminal is too slow\n" ).arg( dropped_messages ).toLocal8Bit() );
+          if ( !batch.isEmpty() )
+          {
+               fwrite( batch.constData(), 1, static_cast<size_t>( batch.size() ), stdout );
+               fflush( stdout );
+          }
+     }
+}
@@ -0,0 +1,52 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef CCONSOLEPRINTER_H
+#define CCONSOLEPRINTER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+
+// Writes console messages to stdout on a dedicated thread, so a slow terminal does
+// not block the event loop. Messages queued while the previous batch is written are
+// printed with one write. If the queue is full, messages are dropped and the number
+// of dropped messages is printed instead.
+class CConsolePrinter : public QThread
+{
+     Q_OBJECT
+public:
+     static constexpr qint64 default_max_queued_bytes_global = 4 * 1024 * 1024;
+
+     explicit CConsolePrinter( const qint64 max_queued_bytes = default_max_queued_bytes_global,
+                               QObject* parent_ptr = nullptr );
+     ~CConsolePrinter() override;
+
+     void print( const QByteArray& message );
+
+     // Prints all queued messages and stops the thread
+     void stop();
+
+protected:
+     void run() override;
+
+private:
+     const qint64 max_queued_bytes_;
+
+     QMutex mutex_;
+     QWaitCondition queue_not_empty_;
+     QByteArray queue_;
+     quint64 dropped_messages_;
+     bool stopping_;
+};
+
+#endif // CCONSOLEPRINTER_H
@@ -12,13 +12,34 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "CFileDataSourcesReciever.h"
 #include "CApplicationSettings.h"
 
+#include <ssh/sshtrace.h>
+
 using namespace daggycore;
 
-CFileDataSourcesReciever::CFileDataSourcesReciever(const QString& output_folder, QObject* parent_ptr)
+CFileDataSourcesReciever::CFileDataSourcesReciever(const QString& output_folder,
+                                                   const COutputFilesWriter::FlushPolicy& flush_policy,
+                                                   const COutputFilesWriter::RotationPolicy& rotation_policy,
+                                                   const COutputFilesWriter::MergePolicy& merge_policy,
+                                                   const qint64 max_queued_bytes,
+                                                   const COutputFilesWriter::Compression compression,
+                                                   const int compression_level,
+                                                   const COutputFilesWriter::Format format,
+                                                   const int std_error_rate,
+                                                   QObject* parent_ptr)
     : IRemoteAgregatorReciever(parent_ptr)
     , output_folder_path_(createOutputFolder(output_folder))
+    , compression_(compression)
+    , format_(format)
+    , std_error_rate_(std_error_rate)
+    , console_time_second_(-1)
+    , output_files_writer_(flush_policy, rotation_policy, mergedOutputPolicy(merge_policy), max_queued_bytes, compression_level)
 {
     console_message_type_ = QMetaEnum::fromType<CFileDataSourcesReciever::ConsoleMessageType>();
+    console_printer_.start();
+    std_errors_timer_.setInterval(1000);
+    connect(&std_errors_timer_, &QTimer::timeout, this, &CFileDataSourcesReciever::printSuppressedStdErrors);
+    std_errors_timer_.start();
+    output_files_writer_.start();
     printAppStatus("Start receiver");
 }
 
@@ -27,7 +48,16 @@ CFileDataSourcesReciever::~CFileDataSourcesReciever()
     for (const QString& serverId : output_files_.keys())
         for (const QString& commandId : output_files_[serverId].keys())
             closeOutputFile(serverId, commandId);
+    output_files_writer_.stop();
+    std_errors_timer_.stop();
+    for (const QString& server_name : std_errors_.keys())
+        for (const QString& command_name : std_errors_[server_name].keys())
+            printSuppressedStdError(server_name, command_name, std_errors_[server_name][command_name]);
+    printCompressionStatistics();
+    printMergeStatistics();
+    printWriteQueueStatistics();
     printAppStatus("Stop receiver");
+    console_printer_.stop();
 }
 
 void CFileDataSourcesReciever::onConnectionStatusChanged(const QString server_name,
@@ -58,7 +88,7 @@ void CFileDataSourcesReciever::onRemoteCommandStatusChanged(const QString server
     QString print_message;
 
     if (status == RemoteCommand::Status::Started) {
-        createOutputFile(server_name, remote_command.command_name, remote_command.output_extension);
+        createOutputFile(server_name, remote_command);
     } else {
         closeOutputFile(server_name, remote_command.command_name);
     }
@@ -85,26 +115,81 @@ void CFileDataSourcesReciever::onRemoteCommandStatusChanged(const QString server
 void CFileDataSourcesReciever::onNewRemoteCommandStream(const QString server_name,
                                                         const RemoteCommand::Stream stream)
 {
+    QSSH_TRACE_SCOPE("CFileDataSourcesReciever::onNewRemoteCommandStream");
     switch (stream.type)
     {
     case RemoteCommand::Stream::Type::Standard:
-        writeToFile(server_name, stream.command_name, stream.data);
+        writeToFile(server_name, stream.command_name, stream.data, stream.receive_time);
         break;
     case RemoteCommand::Stream::Type::Error:
-        printCommandMessage(StdError, server_name, stream.command_name, stream.data);
+        printStdError(server_name, stream.command_name, stream.data);
         break;
     }
 }
 
-void CFileDataSourcesReciever::writeToFile(const QString server_name, QString command_name, const QByteArray& data)
+void CFileDataSourcesReciever::printSuppressedStdErrors()
 {
-    if (output_files_[server_name].contains(command_name)) {
-        QFile* pOutputFile = output_files_[server_name][command_name];
-        if (pOutputFile) {
-            pOutputFile->write(data);
-            pOutputFile->flush();
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+    for (auto server_errors = std_errors_.begin(); server_errors != std_errors_.end(); server_errors++) {
+        for (auto state = server_errors->begin(); state != server_errors->end(); state++) {
+            if (now - state->window_start >= 1000)
+                printSuppressedStdError(server_errors.key(), state.key(), *state);
+        }
+    }
+}
+
+void CFileDataSourcesReciever::printStdError(const QString& server_name, const QString& command_name, const QByteArray& data)
+{
+    if (std_error_rate_ > 0) {
+        // A noisy command gets std_error_rate_ messages per second, the rest is summarized
+        const qint64 now = QDateTime::currentMSecsSinceEpoch();
+        StdErrorState& state = std_errors_[server_name][command_name];
+        if (now - state.window_start >= 1000) {
+            printSuppressedStdError(server_name, command_name, state);
+            state.window_start = now;
+            state.printed_messages = 0;
+        }
+        if (state.printed_messages >= std_error_rate_) {
+            state.suppressed_messages++;
+            state.suppressed_bytes += data.size();
+            return;
         }
+        state.printed_messages++;
     }
+
+    if (data.size() > max_std_error_message_bytes_global) {
+        printCommandMessage(StdError, server_name, command_name,
+                            QString("%1 ... (%2 bytes)")
+                            .arg(QString::fromLocal8Bit(data.constData(), max_std_error_message_bytes_global))
+                            .arg(data.size()));
+    } else {
+        printCommandMessage(StdError, server_name, command_name, data);
+    }
+}
+
+void CFileDataSourcesReciever::printSuppressedStdError(const QString& server_name,
+                                                       const QString& command_name,
+                                                       StdErrorState& state)
+{
+    if (state.suppressed_messages == 0)
+        return;
+    printCommandMessage(StdError, server_name, command_name,
+                        QString("... %1 messages (%2 bytes) suppressed")
+                        .arg(state.suppressed_messages)
+                        .arg(state.suppressed_bytes));
+    state.suppressed_messages = 0;
+    state.suppressed_bytes = 0;
+}
+
+void CFileDataSourcesReciever::writeToFile(const QString server_name, QString command_name, const QByteArray& data, const qint64 receive_time)
+{
+    QSSH_TRACE_SCOPE("CFileDataSourcesReciever::writeToFile");
+    const auto server_files = output_files_.constFind(server_name);
+    if (server_files == output_files_.constEnd())
+        return;
+    const auto output_file = server_files->constFind(command_name);
+    if (output_file != server_files->constEnd())
+        output_files_writer_.write(*output_file, data, receive_time);
 }
 
 void CFileDataSourcesReciever::printAppStatus(const QString& message)
@@ -117,7 +202,11 @@ void CFileDataSourcesReciever::printServerMessage(const CFileDataSourcesReciever
                                                   const QString& server_message)
 {
     const char* pMessageTypeString = console_message_type_.valueToKey(message_type);
-    printf("%12s | %-10s | %-15s | %s\n", qPrintable(currentConsoleTime()), pMessageTypeString, qPrintable(server_id), qPrintable(server_message));
+    const QString& message = currentConsoleTime().rightJustified(12) + " | " +
+                             QString(pMessageTypeString).leftJustified(10) + " | " +
+                             server_id.leftJustified(15) + " | " +
+                             server_message + "\n";
+    console_printer_.print(message.toLocal8Bit());
 }
 
 void CFileDataSourcesReciever::printCommandMessage(const CFileDataSourcesReciever::ConsoleMessageType& message_type,
@@ -126,12 +215,24 @@ void CFileDataSourcesReciever::printCommandMessage(const CFileDataSourcesRecieve
                                                    const QString& command_message)
 {
     const char* pMessageTypeString = console_message_type_.valueToKey(message_type);
-    printf("%12s | %-10s | %-15s | %-15s | %s\n", qPrintable(currentConsoleTime()), pMessageTypeString, qPrintable(server_name), qPrintable(command_name), qPrintable(command_message));
+    const QString& message = currentConsoleTime().rightJustified(12) + " | " +
+                             QString(pMessageTypeString).leftJustified(10) + " | " +
+                             server_name.leftJustified(15) + " | " +
+                             command_name.leftJustified(15) + " | " +
+                             command_message + "\n";
+    console_printer_.print(message.toLocal8Bit());
 }
 
-QString CFileDataSourcesReciever::currentConsoleTime() const
+QString CFileDataSourcesReciever::currentConsoleTime()
 {
-    return QDateTime::currentDateTime().toString("hh:mm:ss:zzz");
+    // Formatting the time is costly, it is done once per second
+    const QTime current_time = QTime::currentTime();
+    const int current_second = current_time.msecsSinceStartOfDay() / 1000;
+    if (current_second != console_time_second_) {
+        console_time_second_ = current_second;
+        console_time_prefix_ = current_time.toString("hh:mm:ss:");
+    }
+    return console_time_prefix_ + QString("%1").arg(current_time.msec(), 3, 10, QLatin1Char('0'));
 }
 
 QString CFileDataSourcesReciever::createOutputFolder(const QString& outputFolderPath) const
@@ -162,29 +263,70 @@ void CFileDataSourcesReciever::closeOutputFile(const QString& server_name,
                                                const QString& command_name)
 {
     if (output_files_[server_name].contains(command_name)) {
-        QFile* output_file = output_files_[server_name][command_name];
-        output_files_[server_name].remove(command_name);
+        const COutputFilesWriter::FileId output_file = output_files_[server_name].take(command_name);
         if (output_files_[server_name].isEmpty())
             output_files_.remove(server_name);
-        if (output_file)
-            output_file->close();
-        delete output_file;
+        output_files_writer_.closeFile(output_file);
     }
 }
 
 void CFileDataSourcesReciever::createOutputFile(const QString& server_name,
-                                                const QString& command_name,
-                                                const QString& output_extension)
+                                                const RemoteCommand& remote_command)
 {
+    const QString& command_name = remote_command.command_name;
     if (!output_files_[server_name].contains(command_name)) {
+        const COutputFilesWriter::Compression compression = remote_command.output_compression.isEmpty()
+                                                            ? compression_
+                                                            : COutputFilesWriter::compression(remote_command.output_compression);
+        const COutputFilesWriter::Format format = remote_command.output_format.isEmpty()
+                                                  ? format_
+                                                  : COutputFilesWriter::format(remote_command.output_format);
+        QString output_extension = remote_command.output_extension;
+        if (compression != COutputFilesWriter::Compression::None)
+            output_extension += "." + COutputFilesWriter::compressionExtension(compression);
         const QString& file_path = getOutputFilePath(server_name, command_name, output_extension);
-        QFile* output_file_ptr = new QFile(file_path);
-        if (!output_file_ptr->open(QIODevice::Append)) {
-            qWarning() << QString("Cannot open file %1 for writing").arg(file_path);
-            delete output_file_ptr;
-            output_file_ptr = nullptr;
-        }
-        if (output_file_ptr)
-            output_files_[server_name][command_name] = output_file_ptr;
+        output_files_[server_name][command_name] = output_files_writer_.openFile(file_path, compression, format,
+                                                                                 QString("%1_%2").arg(server_name, command_name));
+    }
+}
+
+void CFileDataSourcesReciever::printWriteQueueStatistics()
+{
+    const COutputFilesWriter::Statistics& statistics = output_files_writer_.statistics();
+    printAppStatus(QString("Write queue full: %1 times, streams stalled for %2 ms")
+                   .arg(statistics.stalled_writes)
+                   .arg(statistics.stalled_nanoseconds / 1000000));
+}
+
+void CFileDataSourcesReciever::printMergeStatistics()
+{
+    const COutputFilesWriter::Statistics& statistics = output_files_writer_.statistics();
+    if (statistics.merged_lines == 0)
+        return;
+    printAppStatus(QString("Merged lines: %1, out of reorder window: %2")
+                   .arg(statistics.merged_lines)
+                   .arg(statistics.late_merged_lines));
+}
+
+COutputFilesWriter::MergePolicy CFileDataSourcesReciever::mergedOutputPolicy(COutputFilesWriter::MergePolicy merge_policy) const
+{
+    if (!merge_policy.file_path.isEmpty()) {
+        merge_policy.file_path = QString("%1/%2").arg(output_folder_path_, merge_policy.file_path);
+        if (merge_policy.compression != COutputFilesWriter::Compression::None)
+            merge_policy.file_path += "." + COutputFilesWriter::compressionExtension(merge_policy.compression);
     }
+    return merge_policy;
+}
+
+void CFileDataSourcesReciever::printCompressionStatistics()
+{
+    const COutputFilesWriter::Statistics& statistics = output_files_writer_.statistics();
+    if (statistics.compression_nanoseconds == 0)
+        return;
+    const double megabytes = statistics.input_bytes / (1024.0 * 1024.0);
+    const double seconds = statistics.compression_nanoseconds / 1e9;
+    printAppStatus(QString("Compressed output: %1 bytes to %2 bytes, %3 MB/s on writer thread")
+                   .arg(statistics.input_bytes)
+                   .arg(statistics.output_bytes)
+                   .arg(megabytes / seconds, 0, 'f', 1));
 }
@@ -12,13 +12,16 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #define CFILEDATASOURCESRECIEVER_H
 
 #include <QObject>
-#include <QMap>
+#include <QHash>
 #include <QMetaEnum>
+#include <QTimer>
 
 #include <DaggyCore/IRemoteAgregatorReciever.h>
 
+#include "COutputFilesWriter.h"
+#include "CConsolePrinter.h"
+
 class CApplicationSettings;
-class QFile;
 
 class CFileDataSourcesReciever : public daggycore::IRemoteAgregatorReciever
 {
@@ -27,10 +30,23 @@ public:
   enum ConsoleMessageType {StdError, ConnStatus, CommStatus, AppStatus};
   Q_ENUM(ConsoleMessageType)
 
+  static constexpr int default_std_error_rate_global = 20;
+  static constexpr int max_std_error_message_bytes_global = 1024;
+
   CFileDataSourcesReciever(const QString& output_folder,
+                           const COutputFilesWriter::FlushPolicy& flush_policy,
+                           const COutputFilesWriter::RotationPolicy& rotation_policy,
+                           const COutputFilesWriter::MergePolicy& merge_policy,
+                           const qint64 max_queued_bytes,
+                           const COutputFilesWriter::Compression compression,
+                           const int compression_level,
+                           const COutputFilesWriter::Format format,
+                           const int std_error_rate,
                            QObject* parent_ptr = nullptr);
   virtual ~CFileDataSourcesReciever() override;
 
+  void printAppStatus(const QString& message);
+
 private slots:
   void onConnectionStatusChanged(const QString server_name,
                                  const daggycore::RemoteConnectionStatus status,
@@ -41,23 +57,45 @@ private slots:
                                     const int exit_code) override final;
   void onNewRemoteCommandStream(const QString server_name,
                                 const daggycore::RemoteCommand::Stream stream) override final;
-
+  void printSuppressedStdErrors();
 
 private:
-  void writeToFile(const QString server_name, QString command_name, const QByteArray& data);
+  // Stderr messages printed and suppressed during the current second of a command
+  struct StdErrorState {
+    qint64 window_start;
+    int printed_messages;
+    int suppressed_messages;
+    qint64 suppressed_bytes;
+  };
+
+  void printStdError(const QString& server_name, const QString& command_name, const QByteArray& data);
+  void printSuppressedStdError(const QString& server_name, const QString& command_name, StdErrorState& state);
+  void writeToFile(const QString server_name, QString command_name, const QByteArray& data, const qint64 receive_time);
   void printServerMessage(const ConsoleMessageType& message_type, const QString& server_id, const QString& server_message);
   void printCommandMessage(const ConsoleMessageType& message_type, const QString& server_name, const QString& command_name, const QString& command_message);
-  void printAppStatus(const QString& message);
-  QString currentConsoleTime() const;
+  QString currentConsoleTime();
 
   QString createOutputFolder(const QString& outputFolderPath) const;
   QString getOutputFilePath(const QString& serverId, const QString& commandId, const QString& outputExtension) const;
-  void createOutputFile(const QString& server_name, const QString& command_name, const QString& output_extension);
+  void createOutputFile(const QString& server_name, const daggycore::RemoteCommand& remote_command);
+  void printCompressionStatistics();
+  void printMergeStatistics();
+  void printWriteQueueStatistics();
+  COutputFilesWriter::MergePolicy mergedOutputPolicy(COutputFilesWriter::MergePolicy merge_policy) const;
   void closeOutputFile(const QString& server_name, const QString& command_name);
 
   const QString output_folder_path_;
-  QMap<QString, QMap<QString, QFile*>> output_files_;
+  const COutputFilesWriter::Compression compression_;
+  const COutputFilesWriter::Format format_;
+  const int std_error_rate_;
+  CConsolePrinter console_printer_;
+  QHash<QString, QHash<QString, StdErrorState>> std_errors_;
+  QTimer std_errors_timer_;
+  int console_time_second_;
+  QString console_time_prefix_;
+  QHash<QString, QHash<QString, COutputFilesWriter::FileId>> output_files_;
   QMetaEnum console_message_type_;
+  COutputFilesWriter output_files_writer_;
 
 };
 
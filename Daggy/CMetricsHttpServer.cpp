@@ -0,0 +1,101 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#include "Precompiled.h"
+#include "CMetricsHttpServer.h"
+
+#include <QTcpSocket>
+
+#include <DaggyCore/CMetrics.h>
+
+namespace {
+constexpr const char* g_metricsPath = "/metrics";
+constexpr const char* g_prometheusContentType = "text/plain; version=0.0.4; charset=utf-8";
+}
+
+CMetricsHttpServer::CMetricsHttpServer( QObject* parent_ptr )
+  : QObject( parent_ptr )
+{
+     connect( &tcp_server_, &QTcpServer::newConnection, this, &CMetricsHttpServer::onNewConnection );
+}
+
+bool CMetricsHttpServer::listen( const quint16 port )
+{
+     return tcp_server_.listen( QHostAddress::LocalHost, port );
+}
+
+QString CMetricsHttpServer::errorString() const
+{
+     return tcp_server_.errorString();
+}
+
+void CMetricsHttpServer::onNewConnection()
+{
+     while ( QTcpSocket* socket_ptr = tcp_server_.nextPendingConnection() )
+     {
+          requests_.insert( socket_ptr, QByteArray() );
+          connect( socket_ptr, &QTcpSocket::readyRead, this, &CMetricsHttpServer::onReadyRead );
+          connect( socket_ptr, &QTcpSocket::disconnected, this, &CMetricsHttpServer::onDisconnected );
+     }
+}
+
+void CMetricsHttpServer::onReadyRead()
+{
+     QTcpSocket* const socket_ptr = qobject_cast<QTcpSocket*>( sender() );
+     if ( !socket_ptr || !requests_.contains( socket_ptr ) )
+          return;
+
+     QByteArray& request = requests_[socket_ptr];
+     request += socket_ptr->readAll();
+     const int header_end = request.indexOf( "\r\n\r\n" );
+     if ( header_end < 0 )
+     {
+          if ( request.size() > max_request_bytes_global )
+               reply( socket_ptr, "431 Request Header Fields Too Large", QByteArray() );
+          return;
+     }
+
+     // Request line: method, target and protocol version
+     const QList<QByteArray>& request_line = request.left( request.indexOf( "\r\n" ) ).split( ' ' );
+     if ( request_line.size() != 3 )
+          reply( socket_ptr, "400 Bad Request", QByteArray() );
+     else if ( request_line[0] != "GET" )
+          reply( socket_ptr, "405 Method Not Allowed", QByteArray() );
+     else if ( request_line[1] != g_metricsPath )
+          reply( socket_ptr, "404 Not Found", QByteArray() );
+     else
+          reply( socket_ptr, "200 OK", daggycore::CMetrics::instance().prometheusText() );
+}
+
+void CMetricsHttpServer::onDisconnected()
+{
+     QTcpSocket* const socket_ptr = qobject_cast<QTcpSocket*>( sender() );
+     if ( !socket_ptr )
+          return;
+     requests_.remove( socket_ptr );
+     socket_ptr->deleteLater();
+}
+
+void CMetricsHttpServer::reply( QTcpSocket* socket_ptr, const QByteArray& status, const QByteArray& body )
+{
+     requests_.remove( socket_ptr );
+     disconnect( socket_ptr, &QTcpSocket::readyRead, this, &CMetricsHttpServer::onReadyRead );
+
+     QByteArray response = "HTTP/1.1 " + status + "\r\n";
+     response += QByteArray( "Content-Type: " ) + g_prometheusContentType + "\r\n";
+     response += "Content-Length: " + QByteArray::number( body.size() ) + "\r\n";
+     response += "Connection: close\r\n\r\n";
+     response += body;
+     socket_ptr->write( response );
+     // Disconnected signal deletes the socket after the response is sent
+     socket_ptr->disconnectFromHost();
+}
@@ -0,0 +1,47 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+#ifndef CMETRICSHTTPSERVER_H
+#define CMETRICSHTTPSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+#include <QHash>
+#include <QByteArray>
+
+class QTcpSocket;
+
+// Minimal HTTP server on localhost, answers GET /metrics with daggycore::CMetrics in Prometheus text format
+class CMetricsHttpServer : public QObject
+{
+     Q_OBJECT
+public:
+     static constexpr int max_request_bytes_global = 8 * 1024;
+
+     explicit CMetricsHttpServer( QObject* parent_ptr = nullptr );
+
+     bool listen( const quint16 port );
+     QString errorString() const;
+
+private slots:
+     void onNewConnection();
+     void onReadyRead();
+     void onDisconnected();
+
+private:
+     void reply( QTcpSocket* socket_ptr, const QByteArray& status, const QByteArray& body );
+
+     QTcpServer tcp_server_;
+     QHash<QTcpSocket*, QByteArray> requests_;
+};
+
+#endif // CMETRICSHTTPSERVER_H
@@ -0,0 +1,724 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "Precompiled.h"
+#include "COutputFilesWriter.h"
+
+#include <DaggyCore/CMetrics.h>
+#include <ssh/sshtrace.h>
+
+#include <QtEndian>
+
+#ifdef DAGGY_ZLIB
+#include <zlib.h>
+#endif
+
+#include <cstring>
+
+#ifndef Q_OS_WIN
+#include <time.h>
+#endif
+
+namespace {
+constexpr const char* g_noCompression = "none";
+constexpr const char* g_gzipCompression = "gzip";
+constexpr int g_gzipWindowBits = 15 + 16; // Maximum window, gzip wrapper
+constexpr int g_compressChunkSize = 64 * 1024;
+
+constexpr const char* g_rawFormat = "raw";
+constexpr const char* g_recordsFormat = "records";
+constexpr const char* g_framesFormat = "frames";
+
+// Frame header: receive time, line sequence number and line size, little-endian
+constexpr int g_frameHeaderSize = 8 + 8 + 4;
+
+constexpr const char* g_numberSegmentNaming = "number";
+constexpr const char* g_timestampSegmentNaming = "time";
+constexpr const char* g_segmentTimestampFormat = "yyyyMMdd-hhmmss";
+constexpr qint64 g_segmentReadSize = 1024 * 1024;
+
+// CPU time of the calling thread
+qint64 threadCpuNanoseconds()
+{
+#ifdef Q_OS_WIN
+     FILETIME creation_time, exit_time, kernel_time, user_time;
+     if ( !GetThreadTimes( GetCurrentThread(), &creation_time, &exit_time, &kernel_time, &user_time ) )
+          return 0;
+     const auto to_100ns = []( const FILETIME& time ) {
+          return ( static_cast<qint64>( time.dwHighDateTime ) << 32 ) | time.dwLowDateTime;
+     };
+     return ( to_100ns( kernel_time ) + to_100ns( user_time ) ) * 100;
+#else
+     timespec time;
+     if ( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &time ) != 0 )
+          return 0;
+     return static_cast<qint64>( time.tv_sec ) * 1000000000 + time.tv_nsec;
+#endif
+}
+
+#ifdef DAGGY_ZLIB
+// Gzips a closed segment into <segment>.gz and removes the original
+class SegmentCompressor : public QRunnable
+{
+public:
+     SegmentCompressor( const QString& segment_path, const int compression_level )
+       : segment_path_( segment_path )
+       , compression_level_( compression_level )
+     {
+     }
+
+     void run() override
+     {
+          QFile segment( segment_path_ );
+          if ( !segment.open( QIODevice::ReadOnly ) )
+               return; // Already removed by retention
+          const QString& compressed_path = segment_path_ + ".gz";
+          const QByteArray& mode = "wb" + QByteArray::number( compression_level_ );
+          gzFile compressed = gzopen( QFile::encodeName( compressed_path ).constData(), mode.constData() );
+          if ( !compressed )
+          {
+               qWarning() << QString( "Cannot create file %1" ).arg( compressed_path );
+               return;
+          }
+
+          bool is_ok = true;
+          while ( is_ok && !segment.atEnd() )
+          {
+               const QByteArray& data = segment.read( g_segmentReadSize );
+               is_ok = !data.isEmpty() && gzwrite( compressed, data.constData(), static_cast<unsigned>( data.size() ) ) == data.size();
+          }
+          is_ok = gzclose( compressed ) == Z_OK && is_ok;
+          segment.close();
+
+          // The segment may have been removed by retention while it was compressed
+          if ( !is_ok || !segment.exists() )
+          {
+               if ( !is_ok )
+                    qWarning() << QString( "Cannot compress segment %1" ).arg( segment_path_ );
+               QFile::remove( compressed_path );
+               return;
+          }
+          segment.remove();
+     }
+
+private:
+     const QString segment_path_;
+     const int compression_level_;
+};
+#endif
+}
+
+constexpr COutputFilesWriter::FileId COutputFilesWriter::merged_file_id_global;
+
+COutputFilesWriter::COutputFilesWriter( const FlushPolicy& flush_policy,
+                                        const RotationPolicy& rotation_policy,
+                                        const MergePolicy& merge_policy,
+                                        const qint64 max_queued_bytes,
+                                        const int compression_level,
+                                        QObject* parent_ptr )
+  : QThread( parent_ptr )
+  , flush_policy_( flush_policy )
+  , rotation_policy_( rotation_policy )
+  , merge_policy_( merge_policy )
+  , max_queued_bytes_( max_queued_bytes )
+  , compression_level_( compression_level )
+  , queued_bytes_( 0 )
+  , stopping_( false )
+  , next_file_id_( 0 )
+  , stalled_writes_( 0 )
+  , stalled_nanoseconds_( 0 )
+  , statistics_( {0, 0, 0, 0, 0, 0, 0, 0} )
+  , merged_queued_bytes_( 0 )
+  , last_merged_time_( 0 )
+{
+     setObjectName( "daggy-writer" );
+     // Segments are compressed one by one, in the order they were closed
+     segments_compressor_.setMaxThreadCount( 1 );
+}
+
+COutputFilesWriter::~COutputFilesWriter()
+{
+     stop();
+}
+
+COutputFilesWriter::Compression COutputFilesWriter::compression( const QString& name, bool* ok )
+{
+     const QString& compression_name = name.toLower();
+     if ( ok )
+          *ok = true;
+     if ( compression_name.isEmpty() || compression_name == g_noCompression )
+          return Compression::None;
+#ifdef DAGGY_ZLIB
+     if ( compression_name == g_gzipCompression )
+          return Compression::Gzip;
+#endif
+     if ( ok )
+          *ok = false;
+     return Compression::None;
+}
+
+QString COutputFilesWriter::compressionExtension( const Compression compression )
+{
+     switch ( compression )
+     {
+          case Compression::Gzip:
+               return "gz";
+          case Compression::None:
+               break;
+     }
+     return QString();
+}
+
+COutputFilesWriter::Format COutputFilesWriter::format( const QString& name, bool* ok )
+{
+     const QString& format_name = name.toLower();
+     if ( ok )
+          *ok = format_name.isEmpty() || format_name == g_rawFormat || format_name == g_recordsFormat || format_name == g_framesFormat;
+     if ( format_name == g_recordsFormat )
+          return Format::Records;
+     if ( format_name == g_framesFormat )
+          return Format::Frames;
+     return Format::Raw;
+}
+
+COutputFilesWriter::SegmentNaming COutputFilesWriter::segmentNaming( const QString& name, bool* ok )
+{
+     const QString& naming_name = name.toLower();
+     if ( ok )
+          *ok = naming_name == g_numberSegmentNaming || naming_name == g_timestampSegmentNaming;
+     return naming_name == g_timestampSegmentNaming ? SegmentNaming::Timestamp : SegmentNaming::Number;
+}
+
+COutputFilesWriter::FileId COutputFilesWriter::openFile( const QString& file_path,
+                                                        const Compression compression,
+                                                        const Format format,
+                                                        const QString& stream_name )
+{
+     FileId file_id = 0;
+     {
+          QMutexLocker locker( &mutex_ );
+          file_id = next_file_id_++;
+     }
+     enqueue( {Task::Type::Open, file_id, file_path, QByteArray(), compression, format, 0, stream_name} );
+     return file_id;
+}
+
+void COutputFilesWriter::write( const FileId file_id, const QByteArray& data, const qint64 receive_time )
+{
+     if ( !data.isEmpty() )
+          enqueue( {Task::Type::Write, file_id, QString(), data, Compression::None, Format::Raw, receive_time, QString()} );
+}
+
+void COutputFilesWriter::closeFile( const FileId file_id )
+{
+     enqueue( {Task::Type::Close, file_id, QString(), QByteArray(), Compression::None, Format::Raw, 0, QString()} );
+}
+
+void COutputFilesWriter::stop()
+{
+     {
+          QMutexLocker locker( &mutex_ );
+          stopping_ = true;
+          queue_not_empty_.wakeAll();
+          queue_not_full_.wakeAll();
+     }
+     wait();
+}
+
+COutputFilesWriter::Statistics COutputFilesWriter::statistics() const
+{
+     Statistics result = statistics_;
+     result.stalled_writes = stalled_writes_;
+     result.stalled_nanoseconds = stalled_nanoseconds_;
+     return result;
+}
+
+void COutputFilesWriter::enqueue( Task&& task )
+{
+     QMutexLocker locker( &mutex_ );
+     // Bounded queue: the producer waits until the writer thread catches up
+     if ( !stopping_ && queued_bytes_ > 0 && queued_bytes_ + task.data.size() > max_queued_bytes_ )
+     {
+          QElapsedTimer stall_timer;
+          stall_timer.start();
+          while ( !stopping_ && queued_bytes_ > 0 && queued_bytes_ + task.data.size() > max_queued_bytes_ )
+               queue_not_full_.wait( &mutex_ );
+          // Guarded by mutex_, unlike the writer thread statistics
+          stalled_writes_++;
+          stalled_nanoseconds_ += stall_timer.nsecsElapsed();
+     }
+
+     queued_bytes_ += task.data.size();
+     tasks_.enqueue( std::move( task ) );
+     queue_not_empty_.wakeOne();
+}
+
+void COutputFilesWriter::run()
+{
+     if ( isMerging() )
+          openOutputFile( merged_file_id_global, merge_policy_.file_path, merge_policy_.compression, Format::Raw );
+
+     bool stopped = false;
+     while ( !stopped )
+     {
+          QQueue<Task> tasks;
+          {
+               QMutexLocker locker( &mutex_ );
+               if ( tasks_.isEmpty() && !stopping_ )
+               {
+                    if ( hasPendingBuffers() )
+                         queue_not_empty_.wait( &mutex_, static_cast<unsigned long>( flush_policy_.milliseconds ) );
+                    else
+                         queue_not_empty_.wait( &mutex_ );
+               }
+               // Queued bytes are released by flushBuffer() once they reach the file
+               tasks.swap( tasks_ );
+               stopped = stopping_ && tasks.isEmpty();
+          }
+
+          for ( const Task& task : tasks )
+               processTask( task );
+          writeMergedLines( false );
+          flushExpiredBuffers();
+     }
+
+     for ( const FileId file_id : output_files_.keys() )
+     {
+          if ( file_id != merged_file_id_global )
+               closeOutputFile( file_id );
+     }
+     writeMergedLines( true );
+     closeOutputFile( merged_file_id_global );
+     statistics_.writer_cpu_nanoseconds = threadCpuNanoseconds();
+     segments_compressor_.waitForDone();
+}
+
+void COutputFilesWriter::processTask( const Task& task )
+{
+     switch ( task.type )
+     {
+          case Task::Type::Open:
+               openOutputFile( task.file_id, task.file_path, task.compression, task.format );
+               if ( isMerging() )
+                    merged_streams_.insert( task.file_id, {task.stream_name.toUtf8(), QQueue<MergedLine>(), false} );
+               break;
+          case Task::Type::Write:
+          {
+               auto output_file = output_files_.find( task.file_id );
+               if ( output_file == output_files_.end() )
+               {
+                    releaseQueuedBytes( task.data.size() );
+                    break;
+               }
+               if ( output_file->buffer.isEmpty() )
+                    output_file->buffer_age.start();
+               output_file->unwritten_bytes += task.data.size();
+               if ( output_file->format != Format::Raw || isMerging() )
+                    appendLines( task.file_id, *output_file, task.data, task.receive_time );
+               if ( output_file->format == Format::Raw )
+                    output_file->buffer.append( task.data );
+               if ( output_file->buffer.size() >= flush_policy_.bytes )
+                    flushBuffer( *output_file );
+               else if ( output_file->buffer.isEmpty() )
+               {
+                    // Everything went to the partial line, nothing is left for a flush to release
+                    releaseQueuedBytes( output_file->unwritten_bytes );
+                    output_file->unwritten_bytes = 0;
+               }
+               break;
+          }
+          case Task::Type::Close:
+               closeOutputFile( task.file_id );
+               break;
+     }
+}
+
+void COutputFilesWriter::releaseQueuedBytes( const qint64 bytes )
+{
+     if ( bytes == 0 )
+          return;
+     QMutexLocker locker( &mutex_ );
+     queued_bytes_ -= bytes;
+     queue_not_full_.wakeAll();
+}
+
+void COutputFilesWriter::flushExpiredBuffers()
+{
+     for ( OutputFile& output_file : output_files_ )
+     {
+          if ( !output_file.buffer.isEmpty() && output_file.buffer_age.elapsed() >= flush_policy_.milliseconds )
+               flushBuffer( output_file );
+     }
+}
+
+void COutputFilesWriter::appendLines( const FileId file_id, OutputFile& output_file, const QByteArray& data, const qint64 receive_time )
+{
+     const char* begin = data.constData();
+     const char* const end = begin + data.size();
+     while ( begin < end )
+     {
+          const char* newline = static_cast<const char*>( memchr( begin, '\n', static_cast<size_t>( end - begin ) ) );
+          if ( !newline )
+          {
+               // Line continues in the next chunk
+               if ( output_file.partial_line.isEmpty() )
+                    output_file.partial_line_time = receive_time;
+               output_file.partial_line.append( begin, static_cast<int>( end - begin ) );
+               if ( output_file.partial_line.size() >= max_record_bytes_global )
+               {
+                    appendLine( file_id, output_file, output_file.partial_line.constData(), output_file.partial_line.size(), output_file.partial_line_time );
+                    output_file.partial_line.clear();
+               }
+               break;
+          }
+
+          const int size = static_cast<int>( newline - begin );
+          if ( output_file.partial_line.isEmpty() )
+          {
+               appendLine( file_id, output_file, begin, size, receive_time );
+          }
+          else
+          {
+               output_file.partial_line.append( begin, size );
+               appendLine( file_id, output_file, output_file.partial_line.constData(), output_file.partial_line.size(), receive_time );
+               output_file.partial_line.clear();
+          }
+          begin = newline + 1;
+     }
+}
+
+void COutputFilesWriter::appendLine( const FileId file_id, OutputFile& output_file, const char* line, const int size, const qint64 receive_time )
+{
+     const quint64 number = output_file.record_number++;
+     QByteArray& buffer = output_file.buffer;
+     switch ( output_file.format )
+     {
+          case Format::Records:
+               buffer.append( QByteArray::number( receive_time ) );
+               buffer.append( '\t' );
+               buffer.append( QByteArray::number( number ) );
+               buffer.append( '\t' );
+               buffer.append( line, size );
+               buffer.append( '\n' );
+               break;
+          case Format::Frames:
+          {
+               uchar header[g_frameHeaderSize];
+               qToLittleEndian<qint64>( receive_time, header );
+               qToLittleEndian<quint64>( number, header + 8 );
+               qToLittleEndian<quint32>( static_cast<quint32>( size ), header + 16 );
+               buffer.append( reinterpret_cast<const char*>( header ), g_frameHeaderSize );
+               buffer.append( line, size );
+               break;
+          }
+          case Format::Raw:
+               break;
+     }
+     if ( isMerging() )
+          mergeLine( file_id, number, line, size, receive_time );
+}
+
+bool COutputFilesWriter::isMerging() const
+{
+     return !merge_policy_.file_path.isEmpty();
+}
+
+void COutputFilesWriter::mergeLine( const FileId file_id, const quint64 number, const char* line, const int size, const qint64 receive_time )
+{
+     const auto stream = merged_streams_.find( file_id );
+     if ( stream == merged_streams_.end() )
+          return;
+     if ( stream->lines.isEmpty() )
+          merge_heap_.push( {receive_time, file_id} );
+     stream->lines.enqueue( {receive_time, number, QByteArray( line, size )} );
+     merged_queued_bytes_ += size;
+}
+
+void COutputFilesWriter::writeMergedLines( const bool drain )
+{
+     const auto merged_file = output_files_.find( merged_file_id_global );
+     const qint64 window_end = QDateTime::currentMSecsSinceEpoch() - merge_policy_.window_milliseconds;
+     while ( !merge_heap_.empty() )
+     {
+          // Lines are held for the reorder window, or less if they take too much memory
+          const MergeHeapEntry oldest = merge_heap_.top();
+          if ( !drain && oldest.first > window_end && merged_queued_bytes_ <= max_queued_bytes_ )
+               break;
+          merge_heap_.pop();
+
+          const auto stream = merged_streams_.find( oldest.second );
+          const MergedLine merged_line = stream->lines.dequeue();
+          merged_queued_bytes_ -= merged_line.line.size();
+
+          if ( merged_line.receive_time < last_merged_time_ )
+               statistics_.late_merged_lines++;
+          else
+               last_merged_time_ = merged_line.receive_time;
+          statistics_.merged_lines++;
+
+          if ( merged_file != output_files_.end() )
+          {
+               QByteArray& buffer = merged_file->buffer;
+               if ( buffer.isEmpty() )
+                    merged_file->buffer_age.start();
+               buffer.append( QByteArray::number( merged_line.receive_time ) );
+               buffer.append( '\t' );
+               buffer.append( stream->name );
+               buffer.append( '\t' );
+               buffer.append( QByteArray::number( merged_line.number ) );
+               buffer.append( '\t' );
+               buffer.append( merged_line.line );
+               buffer.append( '\n' );
+          }
+
+          if ( !stream->lines.isEmpty() )
+               merge_heap_.push( {stream->lines.head().receive_time, oldest.second} );
+          else if ( stream->closed )
+               merged_streams_.erase( stream );
+     }
+
+     if ( merged_file != output_files_.end() && merged_file->buffer.size() >= flush_policy_.bytes )
+          flushBuffer( *merged_file );
+}
+
+void COutputFilesWriter::flushBuffer( OutputFile& output_file, const bool finish )
+{
+     // Closing a compressed file also ends its last gzip member
+     const bool finish_member = finish && output_file.zstream && output_file.member_bytes > 0;
+     if ( output_file.buffer.isEmpty() && !finish_member )
+     {
+          releaseQueuedBytes( output_file.unwritten_bytes );
+          output_file.unwritten_bytes = 0;
+          return;
+     }
+     QSSH_TRACE_SCOPE( "COutputFilesWriter::flushBuffer" );
+     const QByteArray& data = output_file.zstream ? compress( output_file, finish ) : output_file.buffer;
+     QElapsedTimer write_timer;
+     write_timer.start();
+     if ( output_file.file->write( data ) != data.size() )
+          qWarning() << QString( "Cannot write to file %1: %2" )
+                          .arg( output_file.file->fileName(), output_file.file->errorString() );
+     daggycore::CMetrics& metrics = daggycore::CMetrics::instance();
+     metrics.writeLatency().observe( static_cast<quint64>( write_timer.nsecsElapsed() / 1000 ) );
+     metrics.writtenBytes().add( static_cast<quint64>( data.size() ) );
+     output_file.segment_bytes += data.size();
+     output_file.buffer.clear();
+     releaseQueuedBytes( output_file.unwritten_bytes );
+     output_file.unwritten_bytes = 0;
+
+     if ( !finish && isRotationNeeded( output_file ) )
+          rotateOutputFile( output_file );
+}
+
+QByteArray COutputFilesWriter::compress( OutputFile& output_file, const bool finish )
+{
+#ifdef DAGGY_ZLIB
+     QSSH_TRACE_SCOPE( "COutputFilesWriter::compress" );
+     QElapsedTimer compression_timer;
+     compression_timer.start();
+
+     z_stream* zstream = output_file.zstream;
+     statistics_.input_bytes += output_file.buffer.size();
+     output_file.member_bytes += output_file.buffer.size();
+     const bool finish_member = finish || output_file.member_bytes >= compression_member_bytes_global;
+     const int flush = finish_member ? Z_FINISH : Z_SYNC_FLUSH;
+
+     zstream->next_in = reinterpret_cast<Bytef*>( output_file.buffer.data() );
+     zstream->avail_in = static_cast<uInt>( output_file.buffer.size() );
+
+     QByteArray result;
+     int status = Z_OK;
+     do
+     {
+          const int offset = result.size();
+          result.resize( offset + g_compressChunkSize );
+          zstream->next_out = reinterpret_cast<Bytef*>( result.data() + offset );
+          zstream->avail_out = g_compressChunkSize;
+          status = deflate( zstream, flush );
+          result.resize( offset + g_compressChunkSize - static_cast<int>( zstream->avail_out ) );
+     } while ( status == Z_OK && ( zstream->avail_out == 0 || ( finish_member && status != Z_STREAM_END ) ) );
+
+     if ( status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR )
+          qWarning() << QString( "Cannot compress data for file %1: %2" )
+                          .arg( output_file.file->fileName(), QString::fromLatin1( zstream->msg ? zstream->msg : "" ) );
+
+     if ( finish_member )
+     {
+          // Next data starts a new gzip member, concatenated members are a valid gzip file
+          deflateReset( zstream );
+          output_file.member_bytes = 0;
+     }
+
+     statistics_.output_bytes += result.size();
+     statistics_.compression_nanoseconds += compression_timer.nsecsElapsed();
+     return result;
+#else
+     // Files are not opened with a zstream without zlib
+     Q_UNUSED( finish );
+     return output_file.buffer;
+#endif
+}
+
+bool COutputFilesWriter::hasPendingBuffers() const
+{
+     if ( !merge_heap_.empty() )
+          return true;
+     for ( const OutputFile& output_file : output_files_ )
+     {
+          if ( !output_file.buffer.isEmpty() )
+               return true;
+     }
+     return false;
+}
+
+bool COutputFilesWriter::isRotationNeeded( const OutputFile& output_file ) const
+{
+     if ( output_file.segment_bytes == 0 )
+          return false;
+     return ( rotation_policy_.bytes > 0 && output_file.segment_bytes >= rotation_policy_.bytes ) ||
+            ( rotation_policy_.seconds > 0 && output_file.segment_period != currentRotationPeriod() );
+}
+
+qint64 COutputFilesWriter::currentRotationPeriod() const
+{
+     // Periods are aligned to the wall clock, e.g. hourly segments start at hh:00:00 UTC
+     if ( rotation_policy_.seconds <= 0 )
+          return 0;
+     return QDateTime::currentMSecsSinceEpoch() / 1000 / rotation_policy_.seconds;
+}
+
+void COutputFilesWriter::rotateOutputFile( OutputFile& output_file )
+{
+     flushBuffer( output_file, true );
+     output_file.file->close();
+
+     const QString& file_path = output_file.file->fileName();
+     const QString& segment_path = segmentPath( output_file );
+     if ( QFile::rename( file_path, segment_path ) )
+     {
+          output_file.segments.enqueue( segment_path );
+#ifdef DAGGY_ZLIB
+          if ( rotation_policy_.compress && output_file.compression == Compression::None )
+               segments_compressor_.start( new SegmentCompressor( segment_path, compression_level_ ) );
+#endif
+          removeExpiredSegments( output_file );
+     }
+     else
+     {
+          qWarning() << QString( "Cannot rename file %1 to %2" ).arg( file_path, segment_path );
+     }
+
+     if ( !output_file.file->open( QIODevice::Append | QIODevice::Unbuffered ) )
+          qWarning() << QString( "Cannot open file %1 for writing" ).arg( file_path );
+     output_file.segment_bytes = output_file.file->size();
+     output_file.segment_period = currentRotationPeriod();
+}
+
+QString COutputFilesWriter::segmentPath( OutputFile& output_file ) const
+{
+     // <name>.<extension>[.gz] -> <name>.<extension>.<segment>[.gz]
+     QString stem = output_file.file->fileName();
+     QString suffix;
+     if ( output_file.compression != Compression::None )
+     {
+          suffix = "." + compressionExtension( output_file.compression );
+          if ( stem.endsWith( suffix ) )
+               stem.chop( suffix.size() );
+     }
+
+     const bool is_timestamp = rotation_policy_.naming == SegmentNaming::Timestamp;
+     const QString& timestamp = QDateTime::currentDateTime().toString( g_segmentTimestampFormat );
+     QString segment_path;
+     for ( int collision = 0; segment_path.isEmpty() || QFile::exists( segment_path ) || QFile::exists( segment_path + ".gz" ); collision++ )
+     {
+          QString segment_id = is_timestamp ? timestamp : QString::number( ++output_file.segment_number );
+          if ( is_timestamp && collision > 0 )
+               segment_id += QString( "-%1" ).arg( collision );
+          segment_path = QString( "%1.%2%3" ).arg( stem, segment_id, suffix );
+     }
+     return segment_path;
+}
+
+void COutputFilesWriter::removeExpiredSegments( OutputFile& output_file )
+{
+     if ( rotation_policy_.keep <= 0 )
+          return;
+     while ( output_file.segments.size() > rotation_policy_.keep )
+     {
+          const QString& segment_path = output_file.segments.dequeue();
+          QFile::remove( segment_path );
+          QFile::remove( segment_path + ".gz" );
+     }
+}
+
+void COutputFilesWriter::openOutputFile( const FileId file_id, const QString& file_path, const Compression compression, const Format format )
+{
+     QFile* file_ptr = new QFile( file_path );
+     // Data is already buffered here, so QFile's own write buffer would only add a copy
+     if ( !file_ptr->open( QIODevice::Append | QIODevice::Unbuffered ) )
+     {
+          qWarning() << QString( "Cannot open file %1 for writing" ).arg( file_path );
+          delete file_ptr;
+          return;
+     }
+
+     z_stream_s* zstream = nullptr;
+#ifdef DAGGY_ZLIB
+     if ( compression == Compression::Gzip )
+     {
+          zstream = new z_stream();
+          if ( deflateInit2( zstream, compression_level_, Z_DEFLATED, g_gzipWindowBits, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+          {
+               qWarning() << QString( "Cannot initialize compression for file %1, writing it uncompressed" ).arg( file_path );
+               delete zstream;
+               zstream = nullptr;
+          }
+     }
+#endif
+     output_files_.insert( file_id, {file_ptr, QByteArray(), QElapsedTimer(), zstream, 0,
+                                     compression, file_ptr->size(), currentRotationPeriod(), 0, QQueue<QString>(),
+                                     format, QByteArray(), 0, 0, 0} );
+}
+
+void COutputFilesWriter::closeOutputFile( const FileId file_id )
+{
+     auto output_file = output_files_.find( file_id );
+     if ( output_file != output_files_.end() && !output_file->partial_line.isEmpty() )
+     {
+          // Output ended without a final newline
+          appendLine( file_id, *output_file, output_file->partial_line.constData(), output_file->partial_line.size(), output_file->partial_line_time );
+          output_file->partial_line.clear();
+     }
+
+     // Queued lines of the stream are still written to merged file
+     const auto merged_stream = merged_streams_.find( file_id );
+     if ( merged_stream != merged_streams_.end() )
+     {
+          if ( merged_stream->lines.isEmpty() )
+               merged_streams_.erase( merged_stream );
+          else
+               merged_stream->closed = true;
+     }
+
+     if ( output_file == output_files_.end() )
+          return;
+     flushBuffer( *output_file, true );
+#ifdef DAGGY_ZLIB
+     if ( output_file->zstream )
+     {
+          deflateEnd( output_file->zstream );
+          delete output_file->zstream;
+     }
+#endif
+     output_file->file->close();
+     delete output_file->file;
+     output_files_.erase( output_file );
+}
@@ -0,0 +1,251 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef COUTPUTFILESWRITER_H
+#define COUTPUTFILESWRITER_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QHash>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QThreadPool>
+
+#include <functional>
+#include <queue>
+#include <utility>
+#include <vector>
+
+class QFile;
+struct z_stream_s;
+
+// Writes output files on a dedicated thread. Callers only enqueue data and return;
+// chunks are collected into per-file append buffers which are flushed to disk
+// according to the flush policy or when the file is closed.
+// Compressed files are gzip streams: each flush ends on a deflate sync point, so
+// everything flushed so far can be read while the file is still being written, and
+// a new gzip member is started every compression_member_bytes_global of input.
+// In records format chunks are reassembled into lines, each written as
+// "<receive time, ms since epoch>\t<line sequence number>\t<line>\n".
+// Frames format writes the same lines as binary frames: 8-byte receive time,
+// 8-byte line sequence number and 4-byte line size, all little-endian, then the
+// line without its newline. Lines may contain any bytes, tabs included.
+// Files are rotated by size and/or wall-clock interval according to the rotation
+// policy: the active segment keeps the original name, closed segments are renamed
+// with a number or timestamp suffix and optionally gzipped in the background.
+// With a merge policy, lines of all files are also written to one merged file
+// ordered by receive time: each file's lines are held for the reorder window and
+// the oldest heads are taken from a k-way heap over the per-file line queues.
+class COutputFilesWriter : public QThread
+{
+     Q_OBJECT
+public:
+     using FileId = quint64;
+
+     struct FlushPolicy {
+          qint64 bytes;
+          int milliseconds;
+     };
+
+     enum class Compression {
+          None,
+          Gzip
+     };
+
+     enum class Format {
+          Raw,
+          Records,
+          Frames
+     };
+
+     enum class SegmentNaming {
+          Number,
+          Timestamp
+     };
+
+     // Zero bytes/seconds/keep - no rotation by size/no rotation by time/keep all segments
+     struct RotationPolicy {
+          qint64 bytes;
+          int seconds;
+          SegmentNaming naming;
+          int keep;
+          bool compress;
+     };
+
+     // Empty file_path - no merged output
+     struct MergePolicy {
+          QString file_path;
+          int window_milliseconds;
+          Compression compression;
+     };
+
+     // Valid after stop()
+     struct Statistics {
+          // Compressed files only
+          qint64 input_bytes;
+          qint64 output_bytes;
+          qint64 compression_nanoseconds;
+          // Lines written to merged file, out of order because they arrived after the reorder window
+          qint64 merged_lines;
+          qint64 late_merged_lines;
+          // Writes that waited for free space in the write queue and the time they waited
+          qint64 stalled_writes;
+          qint64 stalled_nanoseconds;
+          // CPU time of the writer thread, compression of all files included
+          qint64 writer_cpu_nanoseconds;
+     };
+
+     static constexpr qint64 default_flush_bytes_global = 64 * 1024;
+     static constexpr int default_flush_milliseconds_global = 500;
+     static constexpr qint64 default_max_queued_bytes_global = 64 * 1024 * 1024;
+     static constexpr int default_compression_level_global = 1;
+     static constexpr qint64 compression_member_bytes_global = 64 * 1024 * 1024;
+     static constexpr int default_merge_window_milliseconds_global = 1000;
+     // Longer lines are split into several records
+     static constexpr int max_record_bytes_global = 1024 * 1024;
+
+     COutputFilesWriter( const FlushPolicy& flush_policy,
+                         const RotationPolicy& rotation_policy,
+                         const MergePolicy& merge_policy,
+                         const qint64 max_queued_bytes,
+                         const int compression_level = default_compression_level_global,
+                         QObject* parent_ptr = nullptr );
+     ~COutputFilesWriter() override;
+
+     // Returns Compression::None and sets ok to false for unknown names
+     static Compression compression( const QString& name, bool* ok = nullptr );
+     static QString compressionExtension( const Compression compression );
+     // Returns Format::Raw and sets ok to false for unknown names
+     static Format format( const QString& name, bool* ok = nullptr );
+     // Returns SegmentNaming::Number and sets ok to false for unknown names
+     static SegmentNaming segmentNaming( const QString& name, bool* ok = nullptr );
+
+     // stream_name prefixes lines of the file in merged output
+     FileId openFile( const QString& file_path,
+                      const Compression compression = Compression::None,
+                      const Format format = Format::Raw,
+                      const QString& stream_name = QString() );
+     // receive_time - ms since epoch, when the data source got the data; lines are stamped and merged by it
+     void write( const FileId file_id, const QByteArray& data, const qint64 receive_time );
+     void closeFile( const FileId file_id );
+
+     void stop();
+
+     Statistics statistics() const;
+
+protected:
+     void run() override;
+
+private:
+     struct Task {
+          enum class Type {
+               Open,
+               Write,
+               Close
+          };
+
+          Type type;
+          FileId file_id;
+          QString file_path;
+          QByteArray data;
+          Compression compression;
+          Format format;
+          qint64 receive_time;
+          QString stream_name;
+     };
+
+     struct OutputFile {
+          QFile* file;
+          QByteArray buffer;
+          QElapsedTimer buffer_age;
+          z_stream_s* zstream;
+          qint64 member_bytes;
+          Compression compression;
+          qint64 segment_bytes;
+          qint64 segment_period;
+          int segment_number;
+          QQueue<QString> segments;
+          Format format;
+          QByteArray partial_line;
+          qint64 partial_line_time;
+          quint64 record_number;
+          // Queued bytes of this file not written yet, see releaseQueuedBytes()
+          qint64 unwritten_bytes;
+     };
+
+     struct MergedLine {
+          qint64 receive_time;
+          quint64 number;
+          QByteArray line;
+     };
+
+     struct MergedStream {
+          QByteArray name;
+          QQueue<MergedLine> lines;
+          bool closed;
+     };
+
+     // Receive time of the stream's oldest line
+     using MergeHeapEntry = std::pair<qint64, FileId>;
+
+     static constexpr FileId merged_file_id_global = ~FileId( 0 );
+
+     void enqueue( Task&& task );
+     void processTask( const Task& task );
+     void releaseQueuedBytes( const qint64 bytes );
+     void flushExpiredBuffers();
+     void appendLines( const FileId file_id, OutputFile& output_file, const QByteArray& data, const qint64 receive_time );
+     void appendLine( const FileId file_id, OutputFile& output_file, const char* line, const int size, const qint64 receive_time );
+     bool isMerging() const;
+     void mergeLine( const FileId file_id, const quint64 number, const char* line, const int size, const qint64 receive_time );
+     void writeMergedLines( const bool drain );
+     void flushBuffer( OutputFile& output_file, const bool finish = false );
+     QByteArray compress( OutputFile& output_file, const bool finish );
+     bool hasPendingBuffers() const;
+
+     bool isRotationNeeded( const OutputFile& output_file ) const;
+     qint64 currentRotationPeriod() const;
+     void rotateOutputFile( OutputFile& output_file );
+     QString segmentPath( OutputFile& output_file ) const;
+     void removeExpiredSegments( OutputFile& output_file );
+
+     void openOutputFile( const FileId file_id, const QString& file_path, const Compression compression, const Format format );
+     void closeOutputFile( const FileId file_id );
+
+     const FlushPolicy flush_policy_;
+     const RotationPolicy rotation_policy_;
+     const MergePolicy merge_policy_;
+     const qint64 max_queued_bytes_;
+     const int compression_level_;
+
+     QMutex mutex_;
+     QWaitCondition queue_not_empty_;
+     QWaitCondition queue_not_full_;
+     QQueue<Task> tasks_;
+     qint64 queued_bytes_;
+     bool stopping_;
+     FileId next_file_id_;
+     qint64 stalled_writes_;
+     qint64 stalled_nanoseconds_;
+
+     // Accessed only from the writer thread
+     QHash<FileId, OutputFile> output_files_;
+     Statistics statistics_;
+     QThreadPool segments_compressor_;
+     QHash<FileId, MergedStream> merged_streams_;
+     std::priority_queue<MergeHeapEntry, std::vector<MergeHeapEntry>, std::greater<MergeHeapEntry>> merge_heap_;
+     qint64 merged_queued_bytes_;
+     qint64 last_merged_time_;
+};
+
+#endif // COUTPUTFILESWRITER_H
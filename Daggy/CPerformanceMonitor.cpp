@@ -0,0 +1,99 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "Precompiled.h"
+#include "CPerformanceMonitor.h"
+
+#ifdef Q_OS_WIN
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+CPerformanceMonitor::CPerformanceMonitor( QObject* parent_ptr )
+  : QObject( parent_ptr )
+  , last_probe_nanoseconds_( 0 )
+  , latency_probes_( 0 )
+  , total_latency_microseconds_( 0 )
+  , max_latency_microseconds_( 0 )
+{
+     latency_probe_.setInterval( latency_probe_milliseconds_global );
+     latency_probe_.setTimerType( Qt::PreciseTimer );
+     connect( &latency_probe_, &QTimer::timeout, this, &CPerformanceMonitor::onLatencyProbe );
+}
+
+void CPerformanceMonitor::start()
+{
+     elapsed_.start();
+     last_probe_nanoseconds_ = 0;
+     latency_probe_.start();
+}
+
+CPerformanceMonitor::Report CPerformanceMonitor::report() const
+{
+     return {
+          elapsed_.isValid() ? elapsed_.elapsed() : 0,
+          processCpuMilliseconds(),
+          processPeakMemoryBytes(),
+          latency_probes_ > 0 ? total_latency_microseconds_ / latency_probes_ : 0,
+          max_latency_microseconds_
+     };
+}
+
+void CPerformanceMonitor::onLatencyProbe()
+{
+     const qint64 now = elapsed_.nsecsElapsed();
+     const qint64 latency = ( now - last_probe_nanoseconds_ ) / 1000 - latency_probe_milliseconds_global * 1000;
+     last_probe_nanoseconds_ = now;
+     if ( latency < 0 )
+          return;
+     latency_probes_++;
+     total_latency_microseconds_ += latency;
+     max_latency_microseconds_ = qMax( max_latency_microseconds_, latency );
+}
+
+qint64 CPerformanceMonitor::processCpuMilliseconds()
+{
+#ifdef Q_OS_WIN
+     FILETIME creation_time, exit_time, kernel_time, user_time;
+     if ( !GetProcessTimes( GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time ) )
+          return 0;
+     const auto to_100ns = []( const FILETIME& time ) {
+          return ( static_cast<qint64>( time.dwHighDateTime ) << 32 ) | time.dwLowDateTime;
+     };
+     return ( to_100ns( kernel_time ) + to_100ns( user_time ) ) / 10000;
+#else
+     rusage usage;
+     if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+          return 0;
+     return ( usage.ru_utime.tv_sec + usage.ru_stime.tv_sec ) * 1000 +
+            ( usage.ru_utime.tv_usec + usage.ru_stime.tv_usec ) / 1000;
+#endif
+}
+
+qint64 CPerformanceMonitor::processPeakMemoryBytes()
+{
+#ifdef Q_OS_WIN
+     PROCESS_MEMORY_COUNTERS counters;
+     if ( !GetProcessMemoryInfo( GetCurrentProcess(), &counters, sizeof( counters ) ) )
+          return 0;
+     return static_cast<qint64>( counters.PeakWorkingSetSize );
+#else
+     rusage usage;
+     if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+          return 0;
+#ifdef Q_OS_MAC
+     return usage.ru_maxrss; // Bytes on macOS
+#else
+     return static_cast<qint64>( usage.ru_maxrss ) * 1024;
+#endif
+#endif
+}
@@ -0,0 +1,56 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef CPERFORMANCEMONITOR_H
+#define CPERFORMANCEMONITOR_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+// Collects process level numbers for comparing daggy runs: wall time, CPU time,
+// peak memory and latency of the event loop the monitor lives in. Latency is how
+// late a periodic timer fires compared to its interval.
+class CPerformanceMonitor : public QObject
+{
+     Q_OBJECT
+public:
+     struct Report {
+          qint64 elapsed_milliseconds;
+          qint64 cpu_milliseconds;
+          qint64 peak_memory_bytes;
+          qint64 average_latency_microseconds;
+          qint64 max_latency_microseconds;
+     };
+
+     static constexpr int latency_probe_milliseconds_global = 100;
+
+     explicit CPerformanceMonitor( QObject* parent_ptr = nullptr );
+
+     void start();
+     Report report() const;
+
+private slots:
+     void onLatencyProbe();
+
+private:
+     static qint64 processCpuMilliseconds();
+     static qint64 processPeakMemoryBytes();
+
+     QTimer latency_probe_;
+     QElapsedTimer elapsed_;
+     qint64 last_probe_nanoseconds_;
+     qint64 latency_probes_;
+     qint64 total_latency_microseconds_;
+     qint64 max_latency_microseconds_;
+};
+
+#endif // CPERFORMANCEMONITOR_H
@@ -12,7 +12,11 @@ include(../GeneralSettings.pri)
 SOURCES += main.cpp \
     CApplicationSettings.cpp \
     CConsoleDaggy.cpp \
-    CFileDataSourcesReciever.cpp
+    CFileDataSourcesReciever.cpp \
+    COutputFilesWriter.cpp \
+    CConsolePrinter.cpp \
+    CPerformanceMonitor.cpp \
+    CMetricsHttpServer.cpp
 
 
 HEADERS += \
@@ -20,7 +24,11 @@ HEADERS += \
     CApplicationSettings.h \
     ISystemSignalsHandler.h \
     CConsoleDaggy.h \
-    CFileDataSourcesReciever.h
+    CFileDataSourcesReciever.h \
+    COutputFilesWriter.h \
+    CConsolePrinter.h \
+    CPerformanceMonitor.h \
+    CMetricsHttpServer.h
 
 
 LIBS += -lDaggyCore -lqssh
@@ -29,7 +37,7 @@ DAGGY_DESCRIPTION = "Daggy - Data Aggregation Utility. Application that can run
 
 win32: {
     SOURCES += ISystemSignalsHandlerWin32.cpp
-    LIBS += -ladvapi32 -luser32 -lws2_32 -lbotan -lyaml-cpp
+    LIBS += -ladvapi32 -luser32 -lpsapi -lws2_32 -lbotan -lyaml-cpp
 
     RC_ICONS = daggy.ico
     QMAKE_TARGET_DESCRIPTION = $$DAGGY_DESCRIPTION
@@ -26,6 +26,7 @@ public:
         SIG_TERM        = 4,    // Control+Break (should terminate now without regarding the consquences)
         SIG_CLOSE       = 8,    // Container window closed (should perform normal termination, like Ctrl^C) [Windows only; on Linux it maps to SIG_TERM]
         SIG_RELOAD      = 16,   // Reload the configuration [Linux only, physical signal is SIGHUP; on Windows it maps to SIG_NOOP]
+        SIG_DUMP        = 32,   // Dump diagnostics without stopping [Linux only, physical signal is SIGUSR1; not raised on Windows]
         DEFAULT_SIGNALS = SIG_INT | SIG_TERM | SIG_CLOSE,
     };
     static constexpr int num_signals = 6;
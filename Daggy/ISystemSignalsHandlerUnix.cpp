@@ -65,6 +65,9 @@ int POSIX_logicalToPhysical(int signal)
   case ISystemSignalHandler::SIG_RELOAD:
     result = SIGHUP;
     break;
+  case ISystemSignalHandler::SIG_DUMP:
+    result = SIGUSR1;
+    break;
   default:;
   }
   return result;
@@ -84,6 +87,9 @@ int POSIX_physicalToLogical(int signal)
   case SIGHUP:
     result = ISystemSignalHandler::SIG_RELOAD;
     break;
+  case SIGUSR1:
+    result = ISystemSignalHandler::SIG_DUMP;
+    break;
   default:;
   }
   return result;
@@ -24,8 +24,7 @@ try {
     QCoreApplication application(argc, argv);
 
     CApplicationSettings applicationSettings;
-    CConsoleDaggy consoleDaggy(applicationSettings.dataSources(),
-                               applicationSettings.outputFolder());
+    CConsoleDaggy consoleDaggy(applicationSettings);
     consoleDaggy.start();
 
     return consoleDaggy.stopped() ? 0 : application.exec();
@@ -0,0 +1,139 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "Precompiled.h"
+#include "CConnectionScheduler.h"
+
+#include "IRemoteAgregator.h"
+
+using namespace daggycore;
+
+CConnectionScheduler::CConnectionScheduler( QObject* parent_ptr )
+  : QObject( parent_ptr )
+  , policy_( {default_max_in_flight_global, default_start_rate_global} )
+  , rate_timer_( this )
+  , next_start_time_( 0 )
+  , admitting_( false )
+  , admitted_( 0 )
+  , queued_( 0 )
+  , total_wait_milliseconds_( 0 )
+  , max_wait_milliseconds_( 0 )
+{
+     clock_.start();
+     rate_timer_.setSingleShot( true );
+     connect( &rate_timer_, &QTimer::timeout, this, &CConnectionScheduler::admit );
+}
+
+void CConnectionScheduler::setPolicy( const Policy& policy )
+{
+     if ( policy.max_in_flight < 0 || policy.start_rate < 0 )
+          throw std::invalid_argument( "Invalid connection scheduler policy" );
+     policy_ = policy;
+}
+
+const CConnectionScheduler::Policy& CConnectionScheduler::policy() const
+{
+     return policy_;
+}
+
+void CConnectionScheduler::enqueue( IRemoteAgregator* const remote_agregator_ptr )
+{
+     queue_.enqueue( {remote_agregator_ptr, clock_.elapsed()} );
+     queued_++;
+     admit();
+}
+
+void CConnectionScheduler::clear()
+{
+     queue_.clear();
+     rate_timer_.stop();
+}
+
+int CConnectionScheduler::queuedCount() const
+{
+     return queue_.size();
+}
+
+int CConnectionScheduler::inFlightCount() const
+{
+     return in_flight_.size();
+}
+
+CConnectionScheduler::Statistics CConnectionScheduler::statistics() const
+{
+     return {admitted_, queued_, total_wait_milliseconds_, max_wait_milliseconds_};
+}
+
+void CConnectionScheduler::admit()
+{
+     // Local agregators report their connection status from start(), which
+     // lands here again; the loop below already takes care of the queue.
+     if ( admitting_ )
+          return;
+     admitting_ = true;
+     while ( !queue_.isEmpty() && hasFreeSlot() )
+     {
+          const qint64 now = clock_.elapsed();
+          if ( now < next_start_time_ )
+          {
+               if ( !rate_timer_.isActive() )
+                    rate_timer_.start( static_cast<int>( next_start_time_ - now ) );
+               break;
+          }
+          next_start_time_ = now + startInterval();
+          start( queue_.dequeue() );
+     }
+     admitting_ = false;
+}
+
+void CConnectionScheduler::start( const PendingStart& pending_start )
+{
+     IRemoteAgregator* const remote_agregator_ptr = pending_start.remote_agregator_ptr;
+
+     const qint64 wait_milliseconds = clock_.elapsed() - pending_start.enqueue_time;
+     admitted_++;
+     total_wait_milliseconds_ += wait_milliseconds;
+     if ( wait_milliseconds > max_wait_milliseconds_ )
+          max_wait_milliseconds_ = wait_milliseconds;
+
+     in_flight_.insert( remote_agregator_ptr );
+     connect( remote_agregator_ptr,
+              &IRemoteAgregator::connectionStatusChanged,
+              this,
+              [this, remote_agregator_ptr]() { onHandshakeFinished( remote_agregator_ptr ); } );
+     connect( remote_agregator_ptr,
+              &IRemoteAgregator::stateChanged,
+              this,
+              [this, remote_agregator_ptr]( const IRemoteAgregator::State state ) {
+                   if ( state == IRemoteAgregator::State::Stopped )
+                        onHandshakeFinished( remote_agregator_ptr );
+              } );
+     remote_agregator_ptr->start();
+}
+
+void CConnectionScheduler::onHandshakeFinished( IRemoteAgregator* const remote_agregator_ptr )
+{
+     // Only the first status after start matters; reconnects are not scheduled
+     if ( !in_flight_.remove( remote_agregator_ptr ) )
+          return;
+     disconnect( remote_agregator_ptr, nullptr, this, nullptr );
+     admit();
+}
+
+bool CConnectionScheduler::hasFreeSlot() const
+{
+     return policy_.max_in_flight == 0 || in_flight_.size() < policy_.max_in_flight;
+}
+
+qint64 CConnectionScheduler::startInterval() const
+{
+     return policy_.start_rate > 0 ? static_cast<qint64>( 1000 / policy_.start_rate ) : 0;
+}
@@ -0,0 +1,98 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#ifndef CCONNECTIONSCHEDULER_H
+#define CCONNECTIONSCHEDULER_H
+
+#include "daggycore_global.h"
+
+#include <QObject>
+#include <QQueue>
+#include <QSet>
+#include <QTimer>
+#include <QElapsedTimer>
+
+#include <atomic>
+
+#include "RemoteConnectionStatus.h"
+
+namespace daggycore {
+
+class IRemoteAgregator;
+
+// Starts remote agregators in the order they were enqueued, keeping at most
+// max_in_flight of them between start and the first connection status
+// (a finished or failed handshake) and no more than start_rate starts per second.
+class DAGGYCORESHARED_EXPORT CConnectionScheduler : public QObject
+{
+     Q_OBJECT
+public:
+     struct Policy {
+          int max_in_flight; // 0 - unlimited
+          double start_rate; // starts per second, 0 - unlimited
+     };
+
+     struct Statistics {
+          quint64 admitted;
+          quint64 queued;
+          qint64 total_wait_milliseconds;
+          qint64 max_wait_milliseconds;
+     };
+
+     static constexpr int default_max_in_flight_global = 64;
+     static constexpr double default_start_rate_global = 0;
+
+     explicit CConnectionScheduler( QObject* parent_ptr = nullptr );
+
+     void setPolicy( const Policy& policy );
+     const Policy& policy() const;
+
+     void enqueue( IRemoteAgregator* const remote_agregator_ptr );
+     // Forgets agregators that were not started yet
+     void clear();
+
+     int queuedCount() const;
+     int inFlightCount() const;
+
+     // Safe to call from any thread
+     Statistics statistics() const;
+
+private:
+     struct PendingStart {
+          IRemoteAgregator* remote_agregator_ptr;
+          qint64 enqueue_time;
+     };
+
+     void admit();
+     void start( const PendingStart& pending_start );
+     void onHandshakeFinished( IRemoteAgregator* const remote_agregator_ptr );
+     bool hasFreeSlot() const;
+     qint64 startInterval() const;
+
+     Policy policy_;
+
+     QQueue<PendingStart> queue_;
+     QSet<IRemoteAgregator*> in_flight_;
+     QElapsedTimer clock_;
+     // Child, so that it follows the scheduler to a worker thread
+     QTimer rate_timer_;
+     qint64 next_start_time_;
+     bool admitting_;
+
+     std::atomic<quint64> admitted_;
+     std::atomic<quint64> queued_;
+     std::atomic<qint64> total_wait_milliseconds_;
+     std::atomic<qint64> max_wait_milliseconds_;
+};
+
+}
+
+#endif // CCONNECTIONSCHEDULER_H
@@ -11,6 +11,11 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "Precompiled.h"
 #include "CDaggy.h"
 
+#include <QSet>
+#include <QThread>
+
+#include <algorithm>
+
 #include <ssh/sshconnection.h>
 
 #include "CDefaultRemoteServersFabric.h"
@@ -18,18 +23,76 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 using namespace daggycore;
 
+namespace {
+
+void registerMetaTypes()
+{
+    qRegisterMetaType<RemoteConnectionStatus>();
+    qRegisterMetaType<RemoteCommand>();
+    qRegisterMetaType<RemoteCommand::Status>();
+    qRegisterMetaType<RemoteCommand::Stream>();
+    qRegisterMetaType<IRemoteAgregator::State>();
+}
+
+}
+
 CDaggy::CDaggy(const DataSources& data_sources,
                                IRemoteServersFabric* const remote_servers_fabric,
                                QObject* const pParent)
+    : CDaggy(data_sources,
+             std::shared_ptr<IRemoteServersFabric>(remote_servers_fabric == nullptr ? new CDefaultRemoteServersFabric : remote_servers_fabric),
+             pParent)
+{
+    registerMetaTypes();
+}
+
+CDaggy::CDaggy(const DataSources& data_sources,
+               const std::shared_ptr<IRemoteServersFabric>& remote_servers_fabric,
+               QObject* const pParent)
     : IRemoteAgregator(pParent)
     , data_sources_(data_sources)
-    , remote_servers_fabric_(remote_servers_fabric == nullptr ? new CDefaultRemoteServersFabric : remote_servers_fabric)
+    , remote_servers_fabric_(remote_servers_fabric)
+    , threads_count_(1)
+    , connection_policy_({CConnectionScheduler::default_max_in_flight_global, CConnectionScheduler::default_start_rate_global})
+    , connection_scheduler_(new CConnectionScheduler(this))
+    , not_stopped_agregators_count_(0)
 {
 }
 
 CDaggy::~CDaggy()
 {
-    delete remote_servers_fabric_;
+    stopWorkerThreads();
+}
+
+void CDaggy::setThreadsCount(const int threads_count)
+{
+    if (threads_count < 0)
+        throw std::invalid_argument(QString("Invalid threads count: %1").arg(threads_count).toStdString());
+    threads_count_ = threads_count;
+}
+
+int CDaggy::threadsCount() const
+{
+    return threads_count_;
+}
+
+void CDaggy::setConnectionPolicy(const CConnectionScheduler::Policy& connection_policy)
+{
+    connection_scheduler_->setPolicy(connection_policy);
+    connection_policy_ = connection_policy;
+}
+
+CConnectionScheduler::Statistics CDaggy::connectionStatistics() const
+{
+    CConnectionScheduler::Statistics result = connection_scheduler_->statistics();
+    for (const CDaggy* const shard_ptr : shards_) {
+        const CConnectionScheduler::Statistics& shard_statistics = shard_ptr->connectionStatistics();
+        result.admitted += shard_statistics.admitted;
+        result.queued += shard_statistics.queued;
+        result.total_wait_milliseconds += shard_statistics.total_wait_milliseconds;
+        result.max_wait_milliseconds = std::max(result.max_wait_milliseconds, shard_statistics.max_wait_milliseconds);
+    }
+    return result;
 }
 
 void CDaggy::connectRemoteAgregatorReciever(IRemoteAgregatorReciever* const remote_agregator_ptr)
@@ -52,17 +115,58 @@ size_t CDaggy::runingRemoteCommandsCount() const
     return result;
 }
 
+quint64 CDaggy::deliveredStreamBytes() const
+{
+    quint64 result = 0;
+    for (const IRemoteAgregator* const remote_agregator_ptr : remoteAgregators())
+        result += remote_agregator_ptr->deliveredStreamBytes();
+    return result;
+}
+
+quint64 CDaggy::copiedStreamBytes() const
+{
+    quint64 result = 0;
+    for (const IRemoteAgregator* const remote_agregator_ptr : remoteAgregators())
+        result += remote_agregator_ptr->copiedStreamBytes();
+    return result;
+}
+
+std::vector<quint64> CDaggy::streamChunkSizes() const
+{
+    std::vector<quint64> result(stream_chunk_buckets_global, 0);
+    for (const IRemoteAgregator* const remote_agregator_ptr : remoteAgregators()) {
+        const std::vector<quint64>& chunk_sizes = remote_agregator_ptr->streamChunkSizes();
+        for (size_t bucket = 0; bucket < chunk_sizes.size() && bucket < result.size(); bucket++)
+            result[bucket] += chunk_sizes[bucket];
+    }
+    return result;
+}
+
 void CDaggy::startAgregator()
 {
-    for (const DataSource& data_source : data_sources_) {
-        if (!isExistsRemoteServer(data_source.server_name)) {
-            createRemoteServer(data_source);
+    const int threads_count = threads_count_ == 0 ? QThread::idealThreadCount() : threads_count_;
+    if (threads_count > 1 && data_sources_.size() > 1) {
+        if (shards_.isEmpty()) {
+            createShards(threads_count);
+            remote_agregators_published_.store(true, std::memory_order_release);
         }
+        for (CDaggy* const shard_ptr : shards_)
+            QMetaObject::invokeMethod(shard_ptr, "start", Qt::QueuedConnection);
+        return;
+    }
+
+    if (!remote_agregators_published_.load(std::memory_order_relaxed)) {
+        for (const DataSource& data_source : data_sources_) {
+            if (!isExistsRemoteServer(data_source.server_name)) {
+                createRemoteServer(data_source);
+            }
+        }
+        remote_agregators_published_.store(true, std::memory_order_release);
     }
 
     const QList<IRemoteAgregator*>& remote_agregators = remoteAgregators();
     for (IRemoteAgregator* const remote_server_ptr : remote_agregators)
-        remote_server_ptr->start();
+        connection_scheduler_->enqueue(remote_server_ptr);
 
     if (remote_agregators.size() == 0)
         setStopped();
@@ -70,13 +174,89 @@ void CDaggy::startAgregator()
 
 void CDaggy::stopAgregator(const bool hard_stop)
 {
+    if (!shards_.isEmpty()) {
+        for (CDaggy* const shard_ptr : shards_)
+            QMetaObject::invokeMethod(shard_ptr, "stop", Qt::QueuedConnection, Q_ARG(bool, hard_stop));
+        return;
+    }
+
+    connection_scheduler_->clear();
     for (IRemoteAgregator* const remote_server_ptr : remoteAgregators())
         remote_server_ptr->stop(hard_stop);
+    // Nothing may have been started yet
+    if (notStoppedRemoteAgregatorsCount() == 0)
+        setStopped();
 }
 
-QList<IRemoteAgregator*> CDaggy::remoteAgregators() const
+const QList<IRemoteAgregator*>& CDaggy::remoteAgregators() const
 {
-    return findChildren<IRemoteAgregator*>();
+    // Remote servers of a shard are created once, on its first start in the worker thread.
+    // Statistics may be read from the main thread before that, then the shard has nothing to report yet.
+    static const QList<IRemoteAgregator*> not_published_remote_agregators;
+    return remote_agregators_published_.load(std::memory_order_acquire) ? remote_agregators_ : not_published_remote_agregators;
+}
+
+void CDaggy::createShards(const int threads_count)
+{
+    QSet<QString> server_names;
+    std::vector<DataSources> shards_data_sources(static_cast<size_t>(threads_count));
+    size_t shard_index = 0;
+    for (const DataSource& data_source : data_sources_) {
+        if (server_names.contains(data_source.server_name))
+            continue;
+        server_names.insert(data_source.server_name);
+        shards_data_sources[shard_index].push_back(data_source);
+        shard_index = (shard_index + 1) % shards_data_sources.size();
+    }
+
+    const int shards_count = static_cast<int>(std::count_if(shards_data_sources.begin(), shards_data_sources.end(),
+                                                             [](const DataSources& shard_data_sources) { return !shard_data_sources.empty(); }));
+    CConnectionScheduler::Policy shard_connection_policy = connection_policy_;
+    if (shard_connection_policy.max_in_flight > 0)
+        shard_connection_policy.max_in_flight = std::max(1, (shard_connection_policy.max_in_flight + shards_count - 1) / shards_count);
+    shard_connection_policy.start_rate /= shards_count;
+
+    for (const DataSources& shard_data_sources : shards_data_sources) {
+        if (shard_data_sources.empty())
+            continue;
+
+        QThread* const thread_ptr = new QThread(this);
+        thread_ptr->setObjectName(QString("daggy-worker-%1").arg(worker_threads_.size()));
+
+        CDaggy* const shard_ptr = new CDaggy(shard_data_sources, remote_servers_fabric_, nullptr);
+        shard_ptr->setConnectionPolicy(shard_connection_policy);
+        shard_ptr->moveToThread(thread_ptr);
+        connect(thread_ptr, &QThread::finished, shard_ptr, &QObject::deleteLater);
+        connectRemoteAgregator(shard_ptr);
+
+        worker_threads_.push_back(thread_ptr);
+        shards_.push_back(shard_ptr);
+        remote_agregators_.push_back(shard_ptr);
+        thread_ptr->start();
+    }
+}
+
+void CDaggy::connectRemoteAgregator(IRemoteAgregator* const remote_agregator_ptr)
+{
+    // Signals of agregators from worker threads are queued; stream data is
+    // implicitly shared, so it is not copied on the way.
+    connect(remote_agregator_ptr, &IRemoteAgregator::connectionStatusChanged, this, &IRemoteAgregator::connectionStatusChanged);
+    connect(remote_agregator_ptr, &IRemoteAgregator::remoteCommandStatusChanged, this, &IRemoteAgregator::remoteCommandStatusChanged);
+    connect(remote_agregator_ptr, &IRemoteAgregator::newRemoteCommandStream, this, &IRemoteAgregator::newRemoteCommandStream);
+
+    connect(remote_agregator_ptr, &IRemoteAgregator::stateChanged, this, &CDaggy::onRemoteAgregatorStateChanged);
+}
+
+void CDaggy::stopWorkerThreads()
+{
+    for (QThread* const thread_ptr : worker_threads_) {
+        thread_ptr->quit();
+        thread_ptr->wait();
+    }
+    worker_threads_.clear();
+    remote_agregators_published_.store(false, std::memory_order_release);
+    remote_agregators_.clear();
+    shards_.clear();
 }
 
 void CDaggy::createRemoteServer(const DataSource& data_source)
@@ -84,18 +264,15 @@ void CDaggy::createRemoteServer(const DataSource& data_source)
     IRemoteAgregator* const remote_server_ptr = remote_servers_fabric_->createRemoteServer(data_source, this);
     if (remote_server_ptr) {
         remote_server_ptr->setObjectName(data_source.server_name);
-
-        connect(remote_server_ptr, &IRemoteAgregator::connectionStatusChanged, this, &IRemoteAgregator::connectionStatusChanged);
-        connect(remote_server_ptr, &IRemoteAgregator::remoteCommandStatusChanged, this, &IRemoteAgregator::remoteCommandStatusChanged);
-        connect(remote_server_ptr, &IRemoteAgregator::newRemoteCommandStream, this, &IRemoteAgregator::newRemoteCommandStream);
-
-        connect(remote_server_ptr, &IRemoteAgregator::stateChanged, this, &CDaggy::onRemoteAgregatorStateChanged);
+        connectRemoteAgregator(remote_server_ptr);
+        remote_agregators_.push_back(remote_server_ptr);
+        remote_servers_.insert(data_source.server_name, remote_server_ptr);
     }
 }
 
 IRemoteAgregator* CDaggy::getRemoteServer(const QString& server_name) const
 {
-    return findChild<IRemoteAgregator*>(server_name);
+    return remote_servers_.value(server_name, nullptr);
 }
 
 bool CDaggy::isExistsRemoteServer(const QString& server_name) const
@@ -105,17 +282,26 @@ bool CDaggy::isExistsRemoteServer(const QString& server_name) const
 
 size_t CDaggy::notStoppedRemoteAgregatorsCount() const
 {
-    size_t result = 0;
-    for (const IRemoteAgregator* remote_agregator_ptr : remoteAgregators()) {
-        if (remote_agregator_ptr->state() != State::Stopped)
-            result++;
-    }
-    return result;
+    return not_stopped_agregators_count_;
 }
 
 void CDaggy::onRemoteAgregatorStateChanged(const IRemoteAgregator::State agregator_state)
 {
-    if (agregator_state == State::Stopped && notStoppedRemoteAgregatorsCount() == 0) {
+    // Agregators only go from Stopped to Run and back, and signals of one
+    // agregator keep their order even when queued from a worker thread
+    switch (agregator_state) {
+    case State::Run:
+        not_stopped_agregators_count_++;
+        break;
+    case State::Stopped:
+        if (not_stopped_agregators_count_ > 0)
+            not_stopped_agregators_count_--;
+        break;
+    case State::Stopping:
+        break;
+    }
+
+    if (agregator_state == State::Stopped && notStoppedRemoteAgregatorsCount() == 0 && connection_scheduler_->queuedCount() == 0) {
         setStopped();
     }
 }
@@ -16,10 +16,18 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <QString>
 #include <QByteArray>
 #include <QMap>
+#include <QHash>
+#include <QList>
+
+#include <atomic>
+#include <memory>
 
 #include "IRemoteAgregator.h"
+#include "CConnectionScheduler.h"
 #include "DataSource.h"
 
+class QThread;
+
 namespace QSsh {
     class SshConnection;
 }
@@ -41,15 +49,36 @@ public:
     void connectRemoteAgregatorReciever(IRemoteAgregatorReciever* const remote_agregator_ptr);
     void dicsonnectRemoteAgregatorReciever(IRemoteAgregator* const remote_agregator_ptr);
 
+    // Worker threads, each with own event loop, that remote servers are distributed across on start.
+    // 1 keeps all remote servers in the CDaggy thread, 0 uses a thread per CPU core.
+    // Remote servers fabric must be thread safe for more than one thread.
+    void setThreadsCount(const int threads_count);
+    int threadsCount() const;
+
+    // Limits simultaneous handshakes and start rate; with worker threads the limits are split between them
+    void setConnectionPolicy(const CConnectionScheduler::Policy& connection_policy);
+    CConnectionScheduler::Statistics connectionStatistics() const;
+
     size_t runingRemoteCommandsCount() const override final;
 
+    quint64 deliveredStreamBytes() const override final;
+    quint64 copiedStreamBytes() const override final;
+    std::vector<quint64> streamChunkSizes() const override final;
+
 private:
+    CDaggy(const DataSources& data_sources,
+           const std::shared_ptr<IRemoteServersFabric>& remote_servers_fabric,
+           QObject* const pParent);
+
     void startAgregator() override final;
     void stopAgregator(const bool hard_stop) override final;
 
-    QList<IRemoteAgregator*> remoteAgregators() const;
+    const QList<IRemoteAgregator*>& remoteAgregators() const;
 
     void createRemoteServer(const DataSource& data_source);
+    void createShards(const int threads_count);
+    void connectRemoteAgregator(IRemoteAgregator* const remote_agregator_ptr);
+    void stopWorkerThreads();
 
     IRemoteAgregator* getRemoteServer(const QString& server_name) const;
     bool isExistsRemoteServer(const QString& server_name) const;
@@ -61,7 +90,20 @@ private:
     void onRemoteAgregatorStateChanged(const State agregator_state);
 
     const DataSources data_sources_;
-    IRemoteServersFabric* const remote_servers_fabric_;
+    const std::shared_ptr<IRemoteServersFabric> remote_servers_fabric_;
+
+    int threads_count_;
+    CConnectionScheduler::Policy connection_policy_;
+    CConnectionScheduler* const connection_scheduler_;
+    QList<CDaggy*> shards_;
+    QList<QThread*> worker_threads_;
+
+    // Remote servers, or shards with worker threads, in creation order.
+    // The list is filled once, in the thread of this agregator, and read from other threads only after it is published
+    QList<IRemoteAgregator*> remote_agregators_;
+    std::atomic<bool> remote_agregators_published_{false};
+    QHash<QString, IRemoteAgregator*> remote_servers_;
+    size_t not_stopped_agregators_count_;
 
 };
 }
@@ -30,6 +30,8 @@ constexpr const char* g_commandField = "command";
 constexpr const char* g_outputExtensionField = "outputExtension";
 constexpr const char* g_outputExtensionShortField = "extension";
 constexpr const char* g_restart = "restart";
+constexpr const char* g_compressionField = "compression";
+constexpr const char* g_outputFormatField = "outputFormat";
 
 }
 
@@ -247,8 +249,10 @@ std::vector<RemoteCommand> CDataSourcesFabric::getCommands(const QVariantMap& co
                       sourceErrorMessage(serverName, QString("%1 field is absent for %2").arg(g_outputExtensionField).arg(commandName)));
 
         const bool restart = remote_command_parameters.value(g_restart, false).toBool();
+        const QString& output_compression = remote_command_parameters[g_compressionField].toString();
+        const QString& output_format = remote_command_parameters[g_outputFormatField].toString();
 
-        result.push_back({commandName, command, output_extension, restart});
+        result.push_back({commandName, command, output_extension, restart, output_compression, output_format});
     }
     return result;
 }
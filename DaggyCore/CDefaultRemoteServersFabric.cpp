@@ -14,6 +14,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "CSshRemoteServer.h"
 #include "CLocalRemoteServer.h"
 
+#include <ssh/sshconnection.h>
+#include <ssh/sshconnectionmanager.h>
+
 using namespace daggycore;
 
 IRemoteAgregator* CDefaultRemoteServersFabric::createRemoteServer(const DataSource& data_source, QObject* parent_ptr)
@@ -21,7 +24,12 @@ IRemoteAgregator* CDefaultRemoteServersFabric::createRemoteServer(const DataSour
     IRemoteServer* result = nullptr;
 
     if (data_source.connection_type.isEmpty() || data_source.connection_type == CSshRemoteServer::connection_type_global)
-        result = new CSshRemoteServer(data_source, parent_ptr);
+    {
+        // Data sources with the same host, port, login and key share one pooled session
+        QSsh::SshConnection* ssh_connection_pointer =
+                QSsh::acquireConnection(CSshRemoteServer::sshConnectionParameters(data_source));
+        result = new CSshRemoteServer(data_source, ssh_connection_pointer, parent_ptr);
+    }
     else if (data_source.connection_type == CLocalRemoteServer::connection_type_global)
         result = new CLocalRemoteServer(data_source, parent_ptr);
 
@@ -11,27 +11,53 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "Precompiled.h"
 #include "CLocalRemoteServer.h"
 
+#ifdef Q_OS_UNIX
+#include "CSpawnedProcess.h"
+#endif
+
 using namespace daggycore;
 
 CLocalRemoteServer::CLocalRemoteServer(const DataSource& data_source,
                                        QObject* parent_pointer)
     : IRemoteServer(data_source, parent_pointer)
+    , spawn_runner_(isSpawnRunner(data_source))
 {
 
 }
 
+bool CLocalRemoteServer::isSpawnRunner(const DataSource& data_source)
+{
+#ifdef Q_OS_UNIX
+    return data_source.connection_parameters.value(runner_field_global, qprocess_runner_global).toString() == spawn_runner_global;
+#else
+    Q_UNUSED(data_source);
+    return false;
+#endif
+}
+
 void CLocalRemoteServer::startAgregator()
 {
+    setConnecting();
     setConnectionStatus(RemoteConnectionStatus::Connected);
 }
 
 void CLocalRemoteServer::stopAgregator(const bool hard_stop)
 {
     if (!hard_stop) {
-        for (QProcess* process_ptr : processes()) {
+        const QList<QProcess*> processes = processes_.values();
+        processes_.clear();
+        for (QProcess* process_ptr : processes) {
+            process_ptr->close();
+            process_ptr->deleteLater();
+        }
+#ifdef Q_OS_UNIX
+        const QList<CSpawnedProcess*> spawned_processes = spawned_processes_.values();
+        spawned_processes_.clear();
+        for (CSpawnedProcess* process_ptr : spawned_processes) {
             process_ptr->close();
             process_ptr->deleteLater();
         }
+#endif
     }
 
     setConnectionStatus(RemoteConnectionStatus::Disconnected);
@@ -39,7 +65,12 @@ void CLocalRemoteServer::stopAgregator(const bool hard_stop)
 
 void CLocalRemoteServer::restartCommand(const QString& command_name)
 {
-    QProcess* process_ptr = process(command_name);
+    if (spawn_runner_) {
+        restartSpawnedCommand(command_name);
+        return;
+    }
+
+    QProcess* process_ptr = processes_.take(command_name);
     if (process_ptr) {
         process_ptr->close();
         process_ptr->deleteLater();
@@ -47,6 +78,7 @@ void CLocalRemoteServer::restartCommand(const QString& command_name)
 
     process_ptr = new QProcess(this);
     process_ptr->setObjectName(command_name);
+    processes_.insert(command_name, process_ptr);
 
     const RemoteCommand& remote_command = getRemoteCommand(command_name);
 
@@ -68,6 +100,39 @@ void CLocalRemoteServer::restartCommand(const QString& command_name)
     process_ptr->start(remote_command.command, QIODevice::ReadOnly);
 }
 
+void CLocalRemoteServer::restartSpawnedCommand(const QString& command_name)
+{
+#ifdef Q_OS_UNIX
+    CSpawnedProcess* process_ptr = spawned_processes_.take(command_name);
+    if (process_ptr) {
+        // The previous process has already finished or is replaced, its exit is not reported again
+        disconnect(process_ptr, nullptr, this, nullptr);
+        process_ptr->close();
+        process_ptr->deleteLater();
+    }
+
+    process_ptr = new CSpawnedProcess(this);
+    process_ptr->setObjectName(command_name);
+    spawned_processes_.insert(command_name, process_ptr);
+
+    const RemoteCommand& remote_command = getRemoteCommand(command_name);
+
+    connect(process_ptr, &CSpawnedProcess::failedToStart,
+            this, &CLocalRemoteServer::onSpawnedProcessFailedToStart);
+    connect(process_ptr, &CSpawnedProcess::finished,
+            this, &CLocalRemoteServer::onSpawnedProcessFinished);
+    connect(process_ptr, &CSpawnedProcess::standardOutput,
+            this, &CLocalRemoteServer::onSpawnedStandardOutput);
+    connect(process_ptr, &CSpawnedProcess::standardError,
+            this, &CLocalRemoteServer::onSpawnedStandardError);
+
+    setRemoteCommandStatus(command_name, RemoteCommand::Status::Started);
+    process_ptr->start(remote_command.command);
+#else
+    Q_UNUSED(command_name);
+#endif
+}
+
 void CLocalRemoteServer::reconnect()
 {
 
@@ -99,35 +164,53 @@ void CLocalRemoteServer::onProcessFinished(const int exit_code, const QProcess::
     setRemoteCommandStatus(command_name, command_status, exit_code);
 }
 
-QList<QProcess*> CLocalRemoteServer::processes() const
+void CLocalRemoteServer::onReadyReadStandardError()
 {
-    return findChildren<QProcess*>();
+    QProcess* const process_ptr = qobject_cast<QProcess*>(sender());
+    if (process_ptr) {
+        const QString& command_name = process_ptr->objectName();
+        // QProcess copies the pipe data out of its internal ring buffer
+        const QByteArray& data = process_ptr->readAllStandardError();
+        setNewRemoteCommandStream(command_name, data, RemoteCommand::Stream::Type::Error, data.size());
+    }
 }
 
-QProcess* CLocalRemoteServer::process(const QString& command_name) const
+void CLocalRemoteServer::onReadyReadStandardOutput()
 {
-    return findChild<QProcess*>(command_name);
+    QProcess* const process_ptr = qobject_cast<QProcess*>(sender());
+    if (process_ptr) {
+        const QString& command_name = process_ptr->objectName();
+        const QByteArray& data = process_ptr->readAllStandardOutput();
+        setNewRemoteCommandStream(command_name, data, RemoteCommand::Stream::Type::Standard, data.size());
+    }
 }
 
-void CLocalRemoteServer::onReadyReadStandardError()
+void CLocalRemoteServer::onProcessStateChanged(const QProcess::ProcessState state)
 {
     const QString& command_name = sender()->objectName();
-    QProcess* const process_ptr = process(command_name);
-    if (process_ptr)
-        setNewRemoteCommandStream(command_name, process_ptr->readAllStandardError(), RemoteCommand::Stream::Type::Error);
+    if (state == QProcess::Running)
+        setRemoteCommandStatus(command_name, RemoteCommand::Status::Started);
 }
 
-void CLocalRemoteServer::onReadyReadStandardOutput()
+void CLocalRemoteServer::onSpawnedProcessFailedToStart()
 {
-    const QString& command_name = sender()->objectName();
-    QProcess* const process_ptr = process(command_name);
-    if (process_ptr)
-        setNewRemoteCommandStream(command_name, process_ptr->readAllStandardOutput(), RemoteCommand::Stream::Type::Standard);
+    setRemoteCommandStatus(sender()->objectName(), RemoteCommand::Status::FailedToStart);
 }
 
-void CLocalRemoteServer::onProcessStateChanged(const QProcess::ProcessState state)
+void CLocalRemoteServer::onSpawnedProcessFinished(const int exit_code, const bool crashed)
 {
-    const QString& command_name = sender()->objectName();
-    if (state == QProcess::Running)
-        setRemoteCommandStatus(command_name, RemoteCommand::Status::Started);
+    setRemoteCommandStatus(sender()->objectName(),
+                           crashed ? RemoteCommand::Status::CrashExit : RemoteCommand::Status::NormalExit,
+                           exit_code);
+}
+
+void CLocalRemoteServer::onSpawnedStandardOutput(const QByteArray data)
+{
+    // read() copies the pipe data once, straight into data
+    setNewRemoteCommandStream(sender()->objectName(), data, RemoteCommand::Stream::Type::Standard, data.size());
+}
+
+void CLocalRemoteServer::onSpawnedStandardError(const QByteArray data)
+{
+    setNewRemoteCommandStream(sender()->objectName(), data, RemoteCommand::Stream::Type::Error, data.size());
 }
@@ -14,10 +14,13 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include "IRemoteServer.h"
 #include "DataSource.h"
 
+#include <QHash>
 #include <QProcess>
 
 namespace daggycore {
 
+class CSpawnedProcess;
+
 class CLocalRemoteServer : public IRemoteServer
 {
     Q_OBJECT
@@ -27,6 +30,11 @@ public:
 
 
     static constexpr const char* connection_type_global = "local";
+    // Commands are run with QProcess, data sources with runner: spawn run them
+    // with posix_spawn through /bin/sh on unix
+    static constexpr const char* runner_field_global = "runner";
+    static constexpr const char* qprocess_runner_global = "qprocess";
+    static constexpr const char* spawn_runner_global = "spawn";
     // IRemoteAgregator interface
 protected:
     void startAgregator() override final;
@@ -42,13 +50,24 @@ private slots:
     void onProcessFinished(const int exit_code,
                            const QProcess::ExitStatus exit_status);
 
-    QList<QProcess*> processes() const;
-    QProcess* process(const QString& command_name) const;
-
     void onReadyReadStandardError();
     void onReadyReadStandardOutput();
 
     void onProcessStateChanged(const QProcess::ProcessState state);
+
+    void onSpawnedProcessFailedToStart();
+    void onSpawnedProcessFinished(const int exit_code, const bool crashed);
+    void onSpawnedStandardOutput(const QByteArray data);
+    void onSpawnedStandardError(const QByteArray data);
+
+private:
+    void restartSpawnedCommand(const QString& command_name);
+    static bool isSpawnRunner(const DataSource& data_source);
+
+    const bool spawn_runner_;
+    // Current process of every command, by command name
+    QHash<QString, QProcess*> processes_;
+    QHash<QString, CSpawnedProcess*> spawned_processes_;
 };
 
 }
@@ -0,0 +1,224 @@
+/*
+Copyright 2017-2018 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Precompiled.h"
+#include "CMetrics.h"
+
+#include <QMutexLocker>
+
+using namespace daggycore;
+
+namespace {
+
+QByteArray labelValue(const QString& value)
+{
+    QByteArray result = value.toUtf8();
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    result.replace('\n', "\\n");
+    return result;
+}
+
+void appendHeader(QByteArray& text, const char* name, const char* type, const char* help)
+{
+    text += QByteArray("# HELP ") + name + ' ' + help + '\n';
+    text += QByteArray("# TYPE ") + name + ' ' + type + '\n';
+}
+
+void appendValue(QByteArray& text, const QByteArray& name, const QByteArray& labels, const QByteArray& value)
+{
+    text += name;
+    if (!labels.isEmpty())
+        text += '{' + labels + '}';
+    text += ' ' + value + '\n';
+}
+
+void appendHistogram(QByteArray& text, const QByteArray& name, const QByteArray& labels, const CMetrics::Histogram& histogram)
+{
+    const QByteArray& separator = labels.isEmpty() ? QByteArray() : QByteArray(",");
+    quint64 cumulative_count = 0;
+    for (int bucket = 0; bucket < CMetrics::Histogram::buckets_global; bucket++) {
+        cumulative_count += histogram.bucketCount(bucket);
+        const QByteArray& bound = bucket == CMetrics::Histogram::buckets_global - 1
+                                  ? QByteArray("+Inf")
+                                  : QByteArray::number(CMetrics::Histogram::bucketBound(bucket) / 1000000.0, 'g', 6);
+        appendValue(text, name + "_bucket", labels + separator + "le=\"" + bound + '"', QByteArray::number(cumulative_count));
+    }
+    appendValue(text, name + "_sum", labels, QByteArray::number(histogram.sum() / 1000000.0, 'f', 6));
+    // Buckets and count are updated separately, the sum of buckets keeps the exposition consistent
+    appendValue(text, name + "_count", labels, QByteArray::number(cumulative_count));
+}
+
+}
+
+void CMetrics::Counter::add(const quint64 value)
+{
+    // Single writer: no read-modify-write instruction is needed
+    value_.store(value_.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+quint64 CMetrics::Counter::value() const
+{
+    return value_.load(std::memory_order_relaxed);
+}
+
+void CMetrics::Histogram::observe(const quint64 microseconds)
+{
+    int bucket = 0;
+    while (bucket < buckets_global - 1 && bucketBound(bucket) < microseconds)
+        bucket++;
+    buckets_[bucket].store(buckets_[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    count_.add();
+    sum_.add(microseconds);
+}
+
+quint64 CMetrics::Histogram::bucketCount(const int bucket) const
+{
+    return buckets_[bucket].load(std::memory_order_relaxed);
+}
+
+quint64 CMetrics::Histogram::bucketBound(const int bucket)
+{
+    return 1ull << bucket;
+}
+
+quint64 CMetrics::Histogram::count() const
+{
+    return count_.value();
+}
+
+quint64 CMetrics::Histogram::sum() const
+{
+    return sum_.value();
+}
+
+CMetrics::ServerMetrics::ServerMetrics(const QString& name)
+    : server_name(name)
+{
+}
+
+CMetrics::CommandMetrics::CommandMetrics(const QString& server, const QString& command)
+    : server_name(server)
+    , command_name(command)
+{
+}
+
+CMetrics& CMetrics::instance()
+{
+    static CMetrics metrics;
+    return metrics;
+}
+
+std::shared_ptr<CMetrics::ServerMetrics> CMetrics::serverMetrics(const QString& server_name)
+{
+    QMutexLocker locker(&mutex_);
+    std::shared_ptr<ServerMetrics>& result = servers_[server_name];
+    if (!result)
+        result = std::make_shared<ServerMetrics>(server_name);
+    return result;
+}
+
+std::shared_ptr<CMetrics::CommandMetrics> CMetrics::commandMetrics(const QString& server_name, const QString& command_name)
+{
+    QMutexLocker locker(&mutex_);
+    std::shared_ptr<CommandMetrics>& result = commands_[{server_name, command_name}];
+    if (!result)
+        result = std::make_shared<CommandMetrics>(server_name, command_name);
+    return result;
+}
+
+CMetrics::Histogram& CMetrics::writeLatency()
+{
+    return write_latency_;
+}
+
+CMetrics::Counter& CMetrics::writtenBytes()
+{
+    return written_bytes_;
+}
+
+CMetrics::Totals CMetrics::totals() const
+{
+    Totals result = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    QMutexLocker locker(&mutex_);
+    for (const auto& pair : commands_) {
+        const CommandMetrics& command = *pair.second;
+        result.stream_bytes += command.standard_bytes.value() + command.error_bytes.value();
+        result.chunks += command.chunks.value();
+        result.command_starts += command.starts.value();
+    }
+    for (const auto& pair : servers_) {
+        const ServerMetrics& server = *pair.second;
+        result.reconnects += server.reconnects.value();
+        result.connection_errors += server.connection_errors.value();
+        result.handshakes += server.handshake_latency.count();
+        result.handshake_microseconds += server.handshake_latency.sum();
+        result.first_bytes += server.first_byte_latency.count();
+        result.first_byte_microseconds += server.first_byte_latency.sum();
+    }
+    result.writes = write_latency_.count();
+    result.write_microseconds = write_latency_.sum();
+    result.written_bytes = written_bytes_.value();
+    return result;
+}
+
+QByteArray CMetrics::prometheusText() const
+{
+    QByteArray text;
+    QMutexLocker locker(&mutex_);
+
+    const auto commandLabels = [](const CommandMetrics& command) {
+        return "server=\"" + labelValue(command.server_name) + "\",command=\"" + labelValue(command.command_name) + '"';
+    };
+    const auto serverLabels = [](const ServerMetrics& server) {
+        return "server=\"" + labelValue(server.server_name) + '"';
+    };
+
+    appendHeader(text, "daggy_stream_bytes_total", "counter", "Bytes of command output delivered");
+    for (const auto& pair : commands_) {
+        const CommandMetrics& command = *pair.second;
+        appendValue(text, "daggy_stream_bytes_total", commandLabels(command) + ",stream=\"standard\"", QByteArray::number(command.standard_bytes.value()));
+        appendValue(text, "daggy_stream_bytes_total", commandLabels(command) + ",stream=\"error\"", QByteArray::number(command.error_bytes.value()));
+    }
+    appendHeader(text, "daggy_stream_chunks_total", "counter", "Chunks of command output delivered");
+    for (const auto& pair : commands_)
+        appendValue(text, "daggy_stream_chunks_total", commandLabels(*pair.second), QByteArray::number(pair.second->chunks.value()));
+    appendHeader(text, "daggy_command_starts_total", "counter", "Command starts, including restarts");
+    for (const auto& pair : commands_)
+        appendValue(text, "daggy_command_starts_total", commandLabels(*pair.second), QByteArray::number(pair.second->starts.value()));
+    appendHeader(text, "daggy_command_exits_total", "counter", "Command exits and failed starts");
+    for (const auto& pair : commands_)
+        appendValue(text, "daggy_command_exits_total", commandLabels(*pair.second), QByteArray::number(pair.second->exits.value()));
+
+    appendHeader(text, "daggy_connections_total", "counter", "Established connections");
+    for (const auto& pair : servers_)
+        appendValue(text, "daggy_connections_total", serverLabels(*pair.second), QByteArray::number(pair.second->connections.value()));
+    appendHeader(text, "daggy_disconnections_total", "counter", "Closed connections");
+    for (const auto& pair : servers_)
+        appendValue(text, "daggy_disconnections_total", serverLabels(*pair.second), QByteArray::number(pair.second->disconnections.value()));
+    appendHeader(text, "daggy_connection_errors_total", "counter", "Connection errors");
+    for (const auto& pair : servers_)
+        appendValue(text, "daggy_connection_errors_total", serverLabels(*pair.second), QByteArray::number(pair.second->connection_errors.value()));
+    appendHeader(text, "daggy_reconnects_total", "counter", "Reconnections after a lost connection");
+    for (const auto& pair : servers_)
+        appendValue(text, "daggy_reconnects_total", serverLabels(*pair.second), QByteArray::number(pair.second->reconnects.value()));
+    appendHeader(text, "daggy_handshake_latency_seconds", "histogram", "Time from the start of connecting to the established connection");
+    for (const auto& pair : servers_)
+        appendHistogram(text, "daggy_handshake_latency_seconds", serverLabels(*pair.second), pair.second->handshake_latency);
+    appendHeader(text, "daggy_command_first_byte_latency_seconds", "histogram", "Time from a command start to its first output");
+    for (const auto& pair : servers_)
+        appendHistogram(text, "daggy_command_first_byte_latency_seconds", serverLabels(*pair.second), pair.second->first_byte_latency);
+
+    appendHeader(text, "daggy_write_latency_seconds", "histogram", "Duration of output file writes");
+    appendHistogram(text, "daggy_write_latency_seconds", QByteArray(), write_latency_);
+    appendHeader(text, "daggy_written_bytes_total", "counter", "Bytes written to output files");
+    appendValue(text, "daggy_written_bytes_total", QByteArray(), QByteArray::number(written_bytes_.value()));
+    return text;
+}
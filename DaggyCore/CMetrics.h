@@ -0,0 +1,131 @@
+/*
+Copyright 2017-2018 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef CMETRICS_H
+#define CMETRICS_H
+
+#include "daggycore_global.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <utility>
+
+namespace daggycore {
+
+// Registry of counters and latency histograms for streams, connections and output files.
+// Every metric is updated only by the thread that owns its source (a remote server or the output writer),
+// so updates are plain relaxed stores without locks; any thread can read them.
+class DAGGYCORESHARED_EXPORT CMetrics
+{
+public:
+    class DAGGYCORESHARED_EXPORT Counter
+    {
+    public:
+        void add(const quint64 value = 1);
+        quint64 value() const;
+
+    private:
+        std::atomic<quint64> value_{0};
+    };
+
+    // Bucket i counts values up to 2^i microseconds, the last bucket counts all larger values
+    class DAGGYCORESHARED_EXPORT Histogram
+    {
+    public:
+        static constexpr int buckets_global = 24;
+
+        void observe(const quint64 microseconds);
+
+        quint64 bucketCount(const int bucket) const;
+        static quint64 bucketBound(const int bucket);
+        quint64 count() const;
+        quint64 sum() const;
+
+    private:
+        std::array<std::atomic<quint64>, buckets_global> buckets_{};
+        Counter count_;
+        Counter sum_;
+    };
+
+    struct ServerMetrics {
+        explicit ServerMetrics(const QString& name);
+
+        const QString server_name;
+        Counter connections;
+        Counter disconnections;
+        Counter connection_errors;
+        Counter reconnects;
+        // Time from the start of connecting to the connected status
+        Histogram handshake_latency;
+        // Time from a command start to its first output
+        Histogram first_byte_latency;
+    };
+
+    struct CommandMetrics {
+        CommandMetrics(const QString& server, const QString& command);
+
+        const QString server_name;
+        const QString command_name;
+        Counter standard_bytes;
+        Counter error_bytes;
+        Counter chunks;
+        Counter starts;
+        Counter exits;
+    };
+
+    struct Totals {
+        quint64 stream_bytes;
+        quint64 chunks;
+        quint64 command_starts;
+        quint64 reconnects;
+        quint64 connection_errors;
+        quint64 handshakes;
+        quint64 handshake_microseconds;
+        quint64 first_bytes;
+        quint64 first_byte_microseconds;
+        quint64 writes;
+        quint64 write_microseconds;
+        quint64 written_bytes;
+    };
+
+    static CMetrics& instance();
+
+    // Returns the same metrics for the same names, so that restarted agregators continue counting
+    std::shared_ptr<ServerMetrics> serverMetrics(const QString& server_name);
+    std::shared_ptr<CommandMetrics> commandMetrics(const QString& server_name, const QString& command_name);
+
+    // Output files writes, updated by the writer thread
+    Histogram& writeLatency();
+    Counter& writtenBytes();
+
+    Totals totals() const;
+    // Prometheus text exposition format
+    QByteArray prometheusText() const;
+
+private:
+    CMetrics() = default;
+
+    mutable QMutex mutex_;
+    std::map<QString, std::shared_ptr<ServerMetrics>> servers_;
+    std::map<std::pair<QString, QString>, std::shared_ptr<CommandMetrics>> commands_;
+
+    Histogram write_latency_;
+    Counter written_bytes_;
+};
+
+}
+
+#endif // CMETRICS_H
@@ -0,0 +1,283 @@
+/*
+Copyright 2017-2018 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Precompiled.h"
+#include "CSpawnedProcess.h"
+
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <cstring>
+#include <vector>
+
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+extern char** environ;
+
+using namespace daggycore;
+
+namespace {
+constexpr const char* shell_global = "/bin/sh";
+constexpr int exit_poll_milliseconds_global = 100;
+// After the pipes are closed the process exits in a moment
+constexpr int closed_pipes_exit_poll_milliseconds_global = 10;
+
+int openPidFd(const pid_t pid)
+{
+#if defined(Q_OS_LINUX) && defined(SYS_pidfd_open)
+    return static_cast<int>(::syscall(SYS_pidfd_open, pid, 0));
+#else
+    Q_UNUSED(pid);
+    return -1;
+#endif
+}
+
+void closeFd(int& fd)
+{
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+// Both ends are closed on exec, so that other spawned commands do not keep them open
+bool openPipe(int (&fds)[2])
+{
+#ifdef Q_OS_LINUX
+    return ::pipe2(fds, O_CLOEXEC) == 0;
+#else
+    if (::pipe(fds) != 0)
+        return false;
+    ::fcntl(fds[0], F_SETFD, FD_CLOEXEC);
+    ::fcntl(fds[1], F_SETFD, FD_CLOEXEC);
+    return true;
+#endif
+}
+}
+
+CSpawnedProcess::CSpawnedProcess(QObject* parent_pointer)
+    : QObject(parent_pointer)
+    , pid_(0)
+    , exit_fd_(-1)
+    , exit_notifier_pointer_(nullptr)
+{
+    connect(&exit_poll_timer_, &QTimer::timeout, this, &CSpawnedProcess::checkExit);
+}
+
+CSpawnedProcess::~CSpawnedProcess()
+{
+    if (isRunning()) {
+        ::kill(-pid_, SIGKILL);
+        int status = 0;
+        while (::waitpid(pid_, &status, 0) < 0 && errno == EINTR);
+    }
+    closePipe(standard_output_);
+    closePipe(standard_error_);
+    closeFd(exit_fd_);
+}
+
+void CSpawnedProcess::start(const QString& command)
+{
+    if (!spawn(command)) {
+        // Reported from the event loop, so that a restarting command does not recurse into start
+        QMetaObject::invokeMethod(this, "failedToStart", Qt::QueuedConnection);
+        return;
+    }
+
+    standard_output_.notifier_pointer = new QSocketNotifier(standard_output_.fd, QSocketNotifier::Read, this);
+    connect(standard_output_.notifier_pointer, &QSocketNotifier::activated, this, &CSpawnedProcess::onStandardOutputReady);
+    standard_error_.notifier_pointer = new QSocketNotifier(standard_error_.fd, QSocketNotifier::Read, this);
+    connect(standard_error_.notifier_pointer, &QSocketNotifier::activated, this, &CSpawnedProcess::onStandardErrorReady);
+    watchExit();
+}
+
+bool CSpawnedProcess::spawn(const QString& command)
+{
+    int output_pipe[2] = {-1, -1};
+    int error_pipe[2] = {-1, -1};
+    if (!openPipe(output_pipe) || !openPipe(error_pipe)) {
+        error_string_ = QString::fromLocal8Bit(std::strerror(errno));
+        for (int& fd : output_pipe)
+            closeFd(fd);
+        return false;
+    }
+    ::fcntl(output_pipe[0], F_SETFL, O_NONBLOCK);
+    ::fcntl(error_pipe[0], F_SETFL, O_NONBLOCK);
+
+    // dup2 clears close-on-exec of the child ends, all other pipe ends are closed by exec
+    posix_spawn_file_actions_t file_actions;
+    posix_spawn_file_actions_init(&file_actions);
+    posix_spawn_file_actions_addopen(&file_actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+    posix_spawn_file_actions_adddup2(&file_actions, output_pipe[1], STDOUT_FILENO);
+    posix_spawn_file_actions_adddup2(&file_actions, error_pipe[1], STDERR_FILENO);
+
+    // Own process group: close() stops shell pipelines as a whole,
+    // and daggy signal handlers and mask are not inherited
+    posix_spawnattr_t attributes;
+    posix_spawnattr_init(&attributes);
+    short flags = POSIX_SPAWN_SETPGROUP | POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF;
+#ifdef POSIX_SPAWN_USEVFORK
+    flags |= POSIX_SPAWN_USEVFORK;
+#endif
+    posix_spawnattr_setflags(&attributes, flags);
+    posix_spawnattr_setpgroup(&attributes, 0);
+    sigset_t signals;
+    sigemptyset(&signals);
+    posix_spawnattr_setsigmask(&attributes, &signals);
+    sigfillset(&signals);
+    posix_spawnattr_setsigdefault(&attributes, &signals);
+
+    const QByteArray& command_bytes = command.toLocal8Bit();
+    std::vector<char*> arguments = {const_cast<char*>(shell_global),
+                                    const_cast<char*>("-c"),
+                                    const_cast<char*>(command_bytes.constData()),
+                                    nullptr};
+    const int error = ::posix_spawn(&pid_, shell_global, &file_actions, &attributes, arguments.data(), environ);
+
+    posix_spawnattr_destroy(&attributes);
+    posix_spawn_file_actions_destroy(&file_actions);
+    ::close(output_pipe[1]);
+    ::close(error_pipe[1]);
+
+    if (error != 0) {
+        pid_ = 0;
+        error_string_ = QString::fromLocal8Bit(std::strerror(error));
+        ::close(output_pipe[0]);
+        ::close(error_pipe[0]);
+        return false;
+    }
+    standard_output_.fd = output_pipe[0];
+    standard_error_.fd = error_pipe[0];
+    return true;
+}
+
+void CSpawnedProcess::watchExit()
+{
+    exit_fd_ = openPidFd(pid_);
+    if (exit_fd_ >= 0) {
+        exit_notifier_pointer_ = new QSocketNotifier(exit_fd_, QSocketNotifier::Read, this);
+        connect(exit_notifier_pointer_, &QSocketNotifier::activated, this, &CSpawnedProcess::checkExit);
+    } else {
+        exit_poll_timer_.start(exit_poll_milliseconds_global);
+    }
+}
+
+bool CSpawnedProcess::isRunning() const
+{
+    return pid_ > 0;
+}
+
+void CSpawnedProcess::close()
+{
+    if (!isRunning())
+        return;
+    ::kill(-pid_, SIGKILL);
+    int status = 0;
+    pid_t result = 0;
+    do {
+        result = ::waitpid(pid_, &status, 0);
+    } while (result < 0 && errno == EINTR);
+    finish(result == pid_ ? status : 0);
+}
+
+const QString& CSpawnedProcess::errorString() const
+{
+    return error_string_;
+}
+
+void CSpawnedProcess::onStandardOutputReady()
+{
+    readPipe(standard_output_, true);
+}
+
+void CSpawnedProcess::onStandardErrorReady()
+{
+    readPipe(standard_error_, false);
+}
+
+void CSpawnedProcess::checkExit()
+{
+    if (!isRunning())
+        return;
+    int status = 0;
+    const pid_t result = ::waitpid(pid_, &status, WNOHANG);
+    // ECHILD: children are reaped automatically, the exit status is lost
+    if (result == pid_ || (result < 0 && errno == ECHILD))
+        finish(result == pid_ ? status : 0);
+}
+
+bool CSpawnedProcess::readPipe(Pipe& pipe, const bool standard)
+{
+    if (pipe.fd < 0)
+        return false;
+
+    int available = 0;
+    if (::ioctl(pipe.fd, FIONREAD, &available) != 0 || available <= 0)
+        available = 1; // Only a read tells end of file from a spurious wake up
+    // Read straight into the chunk that is handed out, no intermediate buffer is copied
+    QByteArray data(qMin(available, max_read_bytes_global), Qt::Uninitialized);
+    const ssize_t size = ::read(pipe.fd, data.data(), static_cast<size_t>(data.size()));
+    if (size > 0) {
+        if (size < data.size())
+            data.resize(static_cast<int>(size));
+        if (standard)
+            emit standardOutput(data);
+        else
+            emit standardError(data);
+        return true;
+    }
+    if (size == 0 || (errno != EAGAIN && errno != EINTR)) {
+        closePipe(pipe);
+        if (standard_output_.fd < 0 && standard_error_.fd < 0 && isRunning()) {
+            checkExit();
+            if (isRunning() && exit_fd_ < 0)
+                exit_poll_timer_.start(closed_pipes_exit_poll_milliseconds_global);
+        }
+    }
+    return false;
+}
+
+void CSpawnedProcess::closePipe(Pipe& pipe)
+{
+    if (pipe.notifier_pointer) {
+        pipe.notifier_pointer->setEnabled(false);
+        pipe.notifier_pointer->deleteLater();
+        pipe.notifier_pointer = nullptr;
+    }
+    closeFd(pipe.fd);
+}
+
+void CSpawnedProcess::finish(const int status)
+{
+    pid_ = 0;
+    exit_poll_timer_.stop();
+    if (exit_notifier_pointer_) {
+        exit_notifier_pointer_->setEnabled(false);
+        exit_notifier_pointer_->deleteLater();
+        exit_notifier_pointer_ = nullptr;
+    }
+    closeFd(exit_fd_);
+
+    // Output written just before the exit is still in the pipes. Background children
+    // of the command can keep them open, so only the data available now is read
+    while (readPipe(standard_output_, true));
+    while (readPipe(standard_error_, false));
+    closePipe(standard_output_);
+    closePipe(standard_error_);
+
+    const bool crashed = WIFSIGNALED(status);
+    emit finished(crashed ? 0 : WEXITSTATUS(status), crashed);
+}
@@ -0,0 +1,82 @@
+/*
+Copyright 2017-2018 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef CSPAWNEDPROCESS_H
+#define CSPAWNEDPROCESS_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QTimer>
+
+#include <sys/types.h>
+
+class QSocketNotifier;
+
+namespace daggycore {
+
+// Local command started with posix_spawn, which does not copy the page tables of daggy
+// like fork does. The command runs with /bin/sh -c in its own process group, standard output
+// and error pipes are watched by the event loop and read directly into the chunks handed out.
+class CSpawnedProcess : public QObject
+{
+    Q_OBJECT
+public:
+    // Upper bound of one read from a pipe
+    static constexpr int max_read_bytes_global = 1024 * 1024;
+
+    explicit CSpawnedProcess(QObject* parent_pointer = nullptr);
+    ~CSpawnedProcess() override;
+
+    // Emits failedToStart later if the command cannot be spawned
+    void start(const QString& command);
+    bool isRunning() const;
+    // Kills the process group, waits for the process and emits finished
+    void close();
+
+    const QString& errorString() const;
+
+signals:
+    void failedToStart();
+    void standardOutput(QByteArray data);
+    void standardError(QByteArray data);
+    void finished(int exit_code, bool crashed);
+
+private slots:
+    void onStandardOutputReady();
+    void onStandardErrorReady();
+    void checkExit();
+
+private:
+    struct Pipe {
+        int fd = -1;
+        QSocketNotifier* notifier_pointer = nullptr;
+    };
+
+    bool spawn(const QString& command);
+    void watchExit();
+    // Returns true if data was read
+    bool readPipe(Pipe& pipe, const bool standard);
+    void closePipe(Pipe& pipe);
+    void finish(const int status);
+
+    pid_t pid_;
+    Pipe standard_output_;
+    Pipe standard_error_;
+    // pidfd on Linux 5.3 and newer, otherwise the process is polled
+    int exit_fd_;
+    QSocketNotifier* exit_notifier_pointer_;
+    QTimer exit_poll_timer_;
+    QString error_string_;
+};
+
+}
+
+#endif // CSPAWNEDPROCESS_H
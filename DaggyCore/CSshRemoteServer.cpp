@@ -19,6 +19,7 @@ OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
 #include "CSshRemoteServer.h"
 
 #include <ssh/sshconnection.h>
+#include <ssh/sshconnectionmanager.h>
 #include <ssh/sshremoteprocess.h>
 
 using namespace QSsh;
@@ -36,6 +37,11 @@ constexpr const char* port_field_global( "port" );
 constexpr const char* force_kill_global( "forceKill" );
 constexpr const char* ignore_default_proxy_global( "ignoreProxy" );
 constexpr const char* enable_strict_conformance_checks_global( "strictConformance" );
+constexpr const char* enable_compression_global( "compression" );
+constexpr const char* window_size_global( "windowSize" );
+constexpr const char* packet_size_global( "packetSize" );
+constexpr const char* adaptive_window_global( "adaptiveWindow" );
+constexpr const char* coalesce_writes_global( "coalesceWrites" );
 
 constexpr const char* default_host_global( "127.0.0.1" );
 
@@ -44,11 +50,15 @@ constexpr int timeout_default_global = 2;
 constexpr int invalid_signal_global = -1;
 constexpr int default_kill_signal_global = 15;
 
+// sshd starts every command in a new session, so the shell pid that the command prints first
+// is also the id of the process group with everything the command has started
+constexpr const char* process_group_command_global = "echo $$; %1";
+
+// Kills only the process groups of this data source, other data sources can share the session
 constexpr const char* kill_command_global =
-  "pids=$(pstree -p $PPID | grep -oP \"\\d+\" | grep -v $PPID | grep -v $$ | tac);"
-  "for pid in $pids; do "
-  "while kill -0 $pid; do "
-  "kill -%1 $pid;"
+  "for pgid in %2; do "
+  "while kill -0 -- -$pgid 2>/dev/null; do "
+  "kill -%1 -- -$pgid;"
   "sleep 0.1;"
   "done "
   "done ";
@@ -60,9 +70,11 @@ RemoteCommand::Status convertStatus( const SshRemoteProcess::ExitStatus exitStat
 QString userName();
 QString privateKeyPath();
 
-CSshRemoteServer::CSshRemoteServer( const DataSource& data_source, QObject* parent_pointer )
+CSshRemoteServer::CSshRemoteServer( const DataSource& data_source,
+                                    SshConnection* ssh_connection_pointer,
+                                    QObject* parent_pointer )
   : IRemoteServer( data_source, parent_pointer )
-  , ssh_connection_pointer_( new SshConnection( getConnectionParameters( data_source ), this ) )
+  , ssh_connection_pointer_( ssh_connection_pointer )
   , force_kill_( data_source.connection_parameters.value( force_kill_global, default_kill_signal_global ).toInt() )
 {
      connect( ssh_connection_pointer_, &SshConnection::connected, this, &CSshRemoteServer::onHostConnected );
@@ -73,6 +85,10 @@ CSshRemoteServer::CSshRemoteServer( const DataSource& data_source, QObject* pare
 CSshRemoteServer::~CSshRemoteServer()
 {
      stop( true );
+     ssh_processes_.clear();
+     kill_childs_process_pointer_.reset();
+     disconnect( ssh_connection_pointer_, nullptr, this, nullptr );
+     releaseConnection( ssh_connection_pointer_ );
 }
 
 bool CSshRemoteServer::isForceKill() const
@@ -80,17 +96,33 @@ bool CSshRemoteServer::isForceKill() const
      return force_kill_ != invalid_signal_global;
 }
 
+bool CSshRemoteServer::isSharedConnection() const
+{
+     return connectionUsers( ssh_connection_pointer_ ) > 1;
+}
+
+SshConnectionParameters CSshRemoteServer::sshConnectionParameters( const DataSource& data_source )
+{
+     return getConnectionParameters( data_source );
+}
+
 void CSshRemoteServer::startAgregator()
 {
+     setConnecting();
      reconnect();
 }
 
 void CSshRemoteServer::startRemoteSshProcess( const QString& command_name, const QString& command )
 {
+     const QString& remote_command = isForceKill() ? QString( process_group_command_global ).arg( command ) : command;
      QSharedPointer<SshRemoteProcess> remote_process_pointer =
-       ssh_connection_pointer_->createRemoteProcess( qPrintable( command ) );
+       ssh_connection_pointer_->createRemoteProcess( qPrintable( remote_command ) );
      remote_process_pointer->setObjectName( command_name );
      ssh_processes_[command_name] = remote_process_pointer;
+     reported_copied_bytes_[command_name] = 0;
+     process_groups_.remove( command_name );
+     if ( isForceKill() )
+          process_group_lines_[command_name].clear();
 
      connect( remote_process_pointer.data(), &SshRemoteProcess::started, this, &CSshRemoteServer::onCommandStarted );
      connect( remote_process_pointer.data(),
@@ -130,7 +162,7 @@ void CSshRemoteServer::stopAgregator( const bool hard_stop )
                if ( remote_process_pointer->isRunning() )
                     remote_process_pointer->close();
           }
-          ssh_connection_pointer_->disconnectFromHost();
+          disconnectFromHost();
      }
      else if ( isForceKill() && isExistsRunningRemoteCommands() )
           killConnection();
@@ -140,8 +172,18 @@ void CSshRemoteServer::stopAgregator( const bool hard_stop )
 
 void CSshRemoteServer::reconnect()
 {
-     if ( ssh_connection_pointer_->state() == SshConnection::Unconnected )
-          ssh_connection_pointer_->connectToHost();
+     switch ( ssh_connection_pointer_->state() )
+     {
+          case SshConnection::Unconnected:
+               ssh_connection_pointer_->connectToHost();
+               break;
+          case SshConnection::Connected:
+               // Another data source has already established the shared session
+               QMetaObject::invokeMethod( this, "onHostConnected", Qt::QueuedConnection );
+               break;
+          case SshConnection::Connecting:
+               break;
+     }
 }
 
 void CSshRemoteServer::onHostConnected()
@@ -165,8 +207,13 @@ void CSshRemoteServer::onNewStandardStreamData()
      const QSharedPointer<SshRemoteProcess>& ssh_remote_process_pointer = getSshRemoteProcess( command_name );
      if ( ssh_remote_process_pointer )
      {
-          setNewRemoteCommandStream(
-            command_name, ssh_remote_process_pointer->readAllStandardOutput(), RemoteCommand::Stream::Type::Standard );
+          QByteArray data = ssh_remote_process_pointer->takeStandardOutput();
+          if ( process_group_lines_.contains( command_name ) && !takeProcessGroup( command_name, data ) )
+               return;
+          setNewRemoteCommandStream( command_name,
+                                     data,
+                                     RemoteCommand::Stream::Type::Standard,
+                                     takeCopiedBytes( command_name, ssh_remote_process_pointer ) );
      }
 }
 
@@ -176,8 +223,11 @@ void CSshRemoteServer::onNewErrorStreamData()
      const QSharedPointer<SshRemoteProcess>& ssh_remote_process_pointer = getSshRemoteProcess( command_name );
      if ( ssh_remote_process_pointer )
      {
-          setNewRemoteCommandStream(
-            command_name, ssh_remote_process_pointer->readAllStandardError(), RemoteCommand::Stream::Type::Error );
+          const QByteArray& data = ssh_remote_process_pointer->takeStandardError();
+          setNewRemoteCommandStream( command_name,
+                                     data,
+                                     RemoteCommand::Stream::Type::Error,
+                                     takeCopiedBytes( command_name, ssh_remote_process_pointer ) );
      }
 }
 
@@ -193,6 +243,8 @@ void CSshRemoteServer::onCommandWasExit( int exitStatus )
      const QSharedPointer<SshRemoteProcess>& ssh_remote_process_pointer = getSshRemoteProcess( command_name );
      if ( ssh_remote_process_pointer )
      {
+          process_groups_.remove( command_name );
+          process_group_lines_.remove( command_name );
           const SshRemoteProcess::ExitStatus status = static_cast<SshRemoteProcess::ExitStatus>( exitStatus );
           setRemoteCommandStatus( command_name, convertStatus( status ), ssh_remote_process_pointer->exitCode() );
      }
@@ -200,11 +252,17 @@ void CSshRemoteServer::onCommandWasExit( int exitStatus )
 
 void CSshRemoteServer::killConnection()
 {
+     if ( process_groups_.isEmpty() )
+     {
+          closeConnection();
+          return;
+     }
      if ( ssh_connection_pointer_->state() == SshConnection::Connected
           && ( !kill_childs_process_pointer_ || !kill_childs_process_pointer_->isRunning() ) )
      {
+          const QStringList& process_groups = process_groups_.values();
           kill_childs_process_pointer_ = ssh_connection_pointer_->createRemoteProcess(
-            qPrintable( QString( kill_command_global ).arg( force_kill_ ) ) );
+            qPrintable( QString( kill_command_global ).arg( force_kill_ ).arg( process_groups.join( ' ' ) ) ) );
           connect(
             kill_childs_process_pointer_.data(), &SshRemoteProcess::closed, this, &CSshRemoteServer::closeConnection );
           kill_childs_process_pointer_->start();
@@ -225,14 +283,55 @@ void CSshRemoteServer::closeConnection()
           }
           else
           {
-               ssh_connection_pointer_->disconnectFromHost();
+               disconnectFromHost();
           }
      }
      else
      {
-          ssh_connection_pointer_->disconnectFromHost();
+          const bool is_shared_connection = isSharedConnection();
+          disconnectFromHost();
+          if ( !is_shared_connection )
+               onHostDisconnected();
+     }
+}
+
+void CSshRemoteServer::disconnectFromHost()
+{
+     if ( isSharedConnection() )
+     {
+          // Other data sources keep running over this session or wait for its handshake:
+          // close only our channels, the session is torn down by its last user
+          for ( const QSharedPointer<SshRemoteProcess>& remote_process_pointer : ssh_processes_.values() )
+          {
+               if ( remote_process_pointer->isRunning() )
+                    remote_process_pointer->close();
+          }
           onHostDisconnected();
      }
+     else
+     {
+          ssh_connection_pointer_->disconnectFromHost();
+     }
+}
+
+bool CSshRemoteServer::takeProcessGroup( const QString& command_name, QByteArray& data )
+{
+     QByteArray& line = process_group_lines_[command_name];
+     const int newline_index = data.indexOf( '\n' );
+     line.append( data.constData(), newline_index < 0 ? data.size() : newline_index );
+     if ( newline_index < 0 )
+     {
+          data.clear();
+          return false;
+     }
+
+     bool is_ok = false;
+     const qint64 process_group = line.trimmed().toLongLong( &is_ok );
+     if ( is_ok && process_group > 1 )
+          process_groups_[command_name] = QString::number( process_group );
+     process_group_lines_.remove( command_name );
+     data.remove( 0, newline_index + 1 );
+     return !data.isEmpty();
 }
 
 QSharedPointer<SshRemoteProcess> CSshRemoteServer::getSshRemoteProcess( const QString& command_name ) const
@@ -240,6 +339,16 @@ QSharedPointer<SshRemoteProcess> CSshRemoteServer::getSshRemoteProcess( const QS
      return ssh_processes_.value( command_name, nullptr );
 }
 
+quint64 CSshRemoteServer::takeCopiedBytes( const QString& command_name,
+                                           const QSharedPointer<SshRemoteProcess>& ssh_remote_process_pointer )
+{
+     const quint64 copied_bytes = ssh_remote_process_pointer->copiedBytes();
+     quint64& reported_bytes = reported_copied_bytes_[command_name];
+     const quint64 result = copied_bytes - reported_bytes;
+     reported_bytes = copied_bytes;
+     return result;
+}
+
 QString userName()
 {
      QString name = qgetenv( "USER" );
@@ -278,11 +387,22 @@ QSsh::SshConnectionParameters getConnectionParameters( const DataSource& data_so
      const bool ignore_default_proxy = connection_parameters.value( ignore_default_proxy_global, true ).toBool();
      const bool enable_strict_conformance_checks =
        connection_parameters.value( enable_strict_conformance_checks_global, true ).toBool();
+     const bool enable_compression = connection_parameters.value( enable_compression_global, false ).toBool();
      if ( ignore_default_proxy )
           connection_options |= SshConnectionOption::SshIgnoreDefaultProxy;
      if ( enable_strict_conformance_checks )
           connection_options = SshConnectionOption::SshEnableStrictConformanceChecks;
+     if ( enable_compression )
+          connection_options |= SshConnectionOption::SshEnableCompression;
+     if ( connection_parameters.value( adaptive_window_global, false ).toBool() )
+          connection_options |= SshConnectionOption::SshAdaptiveChannelWindow;
+     if ( connection_parameters.value( coalesce_writes_global, false ).toBool() )
+          connection_options |= SshConnectionOption::SshCoalesceWrites;
      result.options = connection_options;
+     result.channelWindowSize =
+       connection_parameters.value( window_size_global, result.channelWindowSize ).toUInt();
+     result.channelPacketSize =
+       connection_parameters.value( packet_size_global, result.channelPacketSize ).toUInt();
 
      result.setHost( host );
      result.setUserName( login );
@@ -12,6 +12,7 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #define CSSHREMOTESERVER_H
 
 #include <QObject>
+#include <QHash>
 #include <QSharedPointer>
 #include <QVariantMap>
 
@@ -30,10 +31,14 @@ class CSshRemoteServer : public IRemoteServer
     Q_OBJECT
 public:
     CSshRemoteServer(const DataSource& data_source,
+                     QSsh::SshConnection* ssh_connection_pointer,
                      QObject* parent_pointer = nullptr);
     ~CSshRemoteServer() override;
 
     bool isForceKill() const;
+    bool isSharedConnection() const;
+
+    static QSsh::SshConnectionParameters sshConnectionParameters(const DataSource& data_source);
 
     static constexpr const char* connection_type_global = "ssh";
 
@@ -58,14 +63,23 @@ private:
 
     void killConnection();
     void closeConnection();
+    void disconnectFromHost();
 
     void startRemoteSshProcess(const QString& command_name, const QString& command);
     QSharedPointer<QSsh::SshRemoteProcess> getSshRemoteProcess(const QString& command_name) const;
+    quint64 takeCopiedBytes(const QString& command_name,
+                            const QSharedPointer<QSsh::SshRemoteProcess>& ssh_remote_process_pointer);
+    // Strips the process group line that a command prints first. Returns false if no command output is left
+    bool takeProcessGroup(const QString& command_name, QByteArray& data);
 
     QSsh::SshConnection* const ssh_connection_pointer_;
     const int force_kill_;
 
     QMap<QString, QSharedPointer<QSsh::SshRemoteProcess>> ssh_processes_;
+    QHash<QString, quint64> reported_copied_bytes_;
+    // Remote process groups of running commands, and lines of commands that have not printed their group yet
+    QHash<QString, QString> process_groups_;
+    QHash<QString, QByteArray> process_group_lines_;
     QSharedPointer<QSsh::SshRemoteProcess> kill_childs_process_pointer_ = nullptr;
     void closeRunCommands();
 };
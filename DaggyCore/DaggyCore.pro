@@ -17,16 +17,19 @@ DEFINES += DAGGYCORE_LIBRARY
 
 SOURCES += \
     CDaggy.cpp \
+    CConnectionScheduler.cpp \
     IRemoteServer.cpp \
     CSshRemoteServer.cpp \
     IRemoteAgregator.cpp \
     CDefaultRemoteServersFabric.cpp \
     CLocalRemoteServer.cpp \
-    CDataSourcesFabric.cpp
+    CDataSourcesFabric.cpp \
+    CMetrics.cpp
 
 HEADERS +=\
     Precompiled.h \
     CDaggy.h \
+    CConnectionScheduler.h \
     IRemoteServer.h \
     CSshRemoteServer.h \
     IRemoteServersFabric.h \
@@ -38,7 +41,12 @@ HEADERS +=\
     RemoteConnectionStatus.h \
     CLocalRemoteServer.h \
     CDataSourcesFabric.h \
+    CMetrics.h \
     daggycore_global.h
 
 DEPENDPATH += $$PWD/../ssh
 
+unix: {
+    SOURCES += CSpawnedProcess.cpp
+    HEADERS += CSpawnedProcess.h
+}
@@ -31,6 +31,19 @@ bool IRemoteAgregator::isExistsRunningRemoteCommands() const
      return runingRemoteCommandsCount() > 0;
 }
 
+quint64 IRemoteAgregator::streamChunkBucketBytes( const int bucket )
+{
+     return bucket == 0 ? 0 : quint64( 1 ) << ( 7 + bucket );
+}
+
+int IRemoteAgregator::streamChunkBucket( const quint64 chunk_size )
+{
+     int bucket = 0;
+     for ( quint64 size = chunk_size >> 8; size > 0 && bucket < stream_chunk_buckets_global - 1; size >>= 1 )
+          bucket++;
+     return bucket;
+}
+
 size_t IRemoteAgregator::runingRemoteCommandsCount() const
 {
      return running_remote_command_count_;
@@ -14,6 +14,9 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <QObject>
 #include "daggycore_global.h"
 
+#include <atomic>
+#include <vector>
+
 #include "RemoteCommand.h"
 #include "RemoteConnectionStatus.h"
 
@@ -36,8 +39,20 @@ public:
 
     virtual size_t runingRemoteCommandsCount() const = 0;
 
-    void start();
-    void stop(const bool hard_stop);
+    // Stream payload bytes handed to recievers and bytes copied while getting them there
+    virtual quint64 deliveredStreamBytes() const = 0;
+    virtual quint64 copiedStreamBytes() const = 0;
+
+    // Number of stream chunks handed to recievers by size. Bucket 0 counts chunks smaller than
+    // 256 bytes, bucket i - chunks from 2^(7 + i) bytes, the last one also counts all larger chunks
+    static constexpr int stream_chunk_buckets_global = 16;
+    static quint64 streamChunkBucketBytes(const int bucket);
+    static int streamChunkBucket(const quint64 chunk_size);
+    virtual std::vector<quint64> streamChunkSizes() const = 0;
+
+    // Invokable, so that agregators living in another thread can be started and stopped by queued calls
+    Q_INVOKABLE void start();
+    Q_INVOKABLE void stop(const bool hard_stop);
 
     State state() const;
 
@@ -61,10 +76,12 @@ protected:
 
 private:
     void setState(const State state);
-    State state_;
+    std::atomic<State> state_;
     size_t running_remote_command_count_;
 };
 
 }
 
+Q_DECLARE_METATYPE(daggycore::IRemoteAgregator::State)
+
 #endif // IREMOTEAGREGATOR_H
@@ -13,6 +13,10 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 
 #include "DataSource.h"
 
+#include <ssh/sshtrace.h>
+
+#include <QDateTime>
+
 using namespace daggycore;
 
 IRemoteServer::IRemoteServer(const DataSource& data_source,
@@ -21,6 +25,8 @@ IRemoteServer::IRemoteServer(const DataSource& data_source,
     , data_source_(data_source)
     , remote_commands_(convertRemoteCommands(data_source.remote_commands))
     , exists_restart_commands_(isExistsRestartCommand(data_source.remote_commands))
+    , metrics_(CMetrics::instance().serverMetrics(data_source.server_name))
+    , commands_metrics_(createCommandsMetrics())
 {
     setObjectName(data_source.server_name);
     for (const auto& pair : remote_commands_) {
@@ -53,15 +59,39 @@ bool IRemoteServer::isExistsRestartCommand(const std::vector<RemoteCommand>& com
     return result;
 }
 
+void IRemoteServer::setConnecting()
+{
+    connecting_timer_.start();
+}
+
 void IRemoteServer::setConnectionStatus(const RemoteConnectionStatus status, const QString& message)
 {
     if (connection_status_ != status) {
         connection_status_ = status;
+        switch (status) {
+        case RemoteConnectionStatus::Connected:
+            metrics_->connections.add();
+            if (connecting_timer_.isValid()) {
+                metrics_->handshake_latency.observe(static_cast<quint64>(connecting_timer_.nsecsElapsed() / 1000));
+                connecting_timer_.invalidate();
+            }
+            break;
+        case RemoteConnectionStatus::Disconnected:
+            metrics_->disconnections.add();
+            break;
+        case RemoteConnectionStatus::ConnectionError:
+            metrics_->connection_errors.add();
+            break;
+        case RemoteConnectionStatus::NotConnected:
+            break;
+        }
         emit connectionStatusChanged(data_source_.server_name, status, message);
         if (status != RemoteConnectionStatus::Connected) {
-            if (data_source_.reconnect && state() == State::Run)
+            if (data_source_.reconnect && state() == State::Run) {
+                metrics_->reconnects.add();
+                setConnecting();
                 reconnect();
-            else {
+            } else {
                 setStopped();
             }
         } else {
@@ -77,6 +107,17 @@ void IRemoteServer::setRemoteCommandStatus(const QString& command_name,
     const RemoteCommand::Status current_status = commands_status_[command_name];
     if (current_status != command_status) {
         commands_status_[command_name] = command_status;
+        CMetrics::CommandMetrics& command_metrics = *commands_metrics_.at(command_name);
+        if (command_status == RemoteCommand::Status::Started) {
+            running_commands_count_++;
+            command_metrics.starts.add();
+            first_byte_timers_[command_name].start();
+        } else {
+            if (current_status == RemoteCommand::Status::Started)
+                running_commands_count_--;
+            command_metrics.exits.add();
+            first_byte_timers_.remove(command_name);
+        }
         const RemoteCommand& remote_command = getRemoteCommand(command_name);
         emit remoteCommandStatusChanged(data_source_.server_name,
                                         remote_command,
@@ -93,10 +134,34 @@ void IRemoteServer::setRemoteCommandStatus(const QString& command_name,
     }
 }
 
-void IRemoteServer::setNewRemoteCommandStream(const QString& commandName, const QByteArray& data, const RemoteCommand::Stream::Type type)
-{
+void IRemoteServer::setNewRemoteCommandStream(const QString& commandName,
+                                              const QByteArray& data,
+                                              const RemoteCommand::Stream::Type type,
+                                              const quint64 copied_bytes)
+{
+    if (data.isEmpty())
+        return;
+    // With a reciever in the same thread, this also covers the reciever handling the stream
+    QSSH_TRACE_SCOPE("IRemoteServer::setNewRemoteCommandStream");
+    delivered_stream_bytes_ += data.size();
+    copied_stream_bytes_ += copied_bytes;
+    stream_chunk_sizes_[streamChunkBucket(data.size())]++;
+    CMetrics::CommandMetrics& command_metrics = *commands_metrics_.at(commandName);
+    command_metrics.chunks.add();
+    if (!first_byte_timers_.isEmpty()) {
+        const auto first_byte_timer = first_byte_timers_.find(commandName);
+        if (first_byte_timer != first_byte_timers_.end()) {
+            metrics_->first_byte_latency.observe(static_cast<quint64>(first_byte_timer->nsecsElapsed() / 1000));
+            first_byte_timers_.erase(first_byte_timer);
+        }
+    }
+    if (type == RemoteCommand::Stream::Type::Error)
+        command_metrics.error_bytes.add(data.size());
+    else
+        command_metrics.standard_bytes.add(data.size());
     const RemoteCommand& pRemoteCommand = getRemoteCommand(commandName);
-    emit newRemoteCommandStream(data_source_.server_name, {commandName, pRemoteCommand.output_extension, data, type});
+    emit newRemoteCommandStream(data_source_.server_name,
+                                {commandName, pRemoteCommand.output_extension, data, type, QDateTime::currentMSecsSinceEpoch()});
 }
 
 std::map<QString, RemoteCommand> IRemoteServer::convertRemoteCommands(const std::vector<RemoteCommand>& remoteCommands) const
@@ -110,6 +175,17 @@ std::map<QString, RemoteCommand> IRemoteServer::convertRemoteCommands(const std:
     return result;
 }
 
+std::map<QString, std::shared_ptr<CMetrics::CommandMetrics>> IRemoteServer::createCommandsMetrics() const
+{
+    std::map<QString, std::shared_ptr<CMetrics::CommandMetrics>> result;
+
+    for (const auto& pair : remote_commands_) {
+        result.insert({pair.first, CMetrics::instance().commandMetrics(data_source_.server_name, pair.first)});
+    }
+
+    return result;
+}
+
 const QString& IRemoteServer::connectionType() const
 {
     return data_source_.connection_type;
@@ -145,12 +221,25 @@ bool IRemoteServer::isExistsRestartCommand() const
     return exists_restart_commands_;
 }
 
-size_t IRemoteServer::runingRemoteCommandsCount() const
+quint64 IRemoteServer::deliveredStreamBytes() const
 {
-    size_t result = 0;
-    for (const QString& command_name : commands_status_.keys()) {
-        if (commands_status_[command_name] == RemoteCommand::Status::Started)
-            result++;
-    }
+    return delivered_stream_bytes_;
+}
+
+quint64 IRemoteServer::copiedStreamBytes() const
+{
+    return copied_stream_bytes_;
+}
+
+std::vector<quint64> IRemoteServer::streamChunkSizes() const
+{
+    std::vector<quint64> result;
+    for (const std::atomic<quint64>& chunks : stream_chunk_sizes_)
+        result.push_back(chunks);
     return result;
 }
+
+size_t IRemoteServer::runingRemoteCommandsCount() const
+{
+    return running_commands_count_;
+}
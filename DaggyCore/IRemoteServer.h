@@ -17,9 +17,16 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #include <QString>
 #include <QVector>
 #include <QMap>
+#include <QHash>
+#include <QElapsedTimer>
+
+#include <array>
+#include <atomic>
+#include <memory>
 
 #include "IRemoteAgregator.h"
 #include "DataSource.h"
+#include "CMetrics.h"
 
 namespace daggycore {
 
@@ -45,18 +52,28 @@ public:
 
     size_t runingRemoteCommandsCount() const override final;
 
+    quint64 deliveredStreamBytes() const override final;
+    quint64 copiedStreamBytes() const override final;
+    std::vector<quint64> streamChunkSizes() const override final;
+
 protected:
     virtual void restartCommand(const QString& commandName) = 0;
     virtual void reconnect() = 0;
 
+    // Starts measuring the handshake latency up to the connected status
+    void setConnecting();
     void setConnectionStatus(const RemoteConnectionStatus status, const QString& message = QString());
     void setRemoteCommandStatus(const QString& commandName, const RemoteCommand::Status commandStatus, const int exit_code = 0);
-    void setNewRemoteCommandStream(const QString& commandName, const QByteArray& data, const RemoteCommand::Stream::Type type);
+    void setNewRemoteCommandStream(const QString& commandName,
+                                   const QByteArray& data,
+                                   const RemoteCommand::Stream::Type type,
+                                   const quint64 copied_bytes);
 
 private:
     void startCommands();
     bool isExistsRestartCommand(const std::vector<RemoteCommand>& commands) const;
     std::map<QString, RemoteCommand> convertRemoteCommands(const std::vector<RemoteCommand>& remoteCommands) const;
+    std::map<QString, std::shared_ptr<CMetrics::CommandMetrics>> createCommandsMetrics() const;
 
     const DataSource data_source_;
     const std::map<QString, RemoteCommand> remote_commands_;
@@ -64,6 +81,18 @@ private:
     QMap<QString, RemoteCommand::Status> commands_status_;
 
     RemoteConnectionStatus connection_status_ = RemoteConnectionStatus::NotConnected;
+
+    // Read by the owning CDaggy, which can live in another thread
+    std::atomic<size_t> running_commands_count_{0};
+    std::atomic<quint64> delivered_stream_bytes_{0};
+    std::atomic<quint64> copied_stream_bytes_{0};
+    std::array<std::atomic<quint64>, stream_chunk_buckets_global> stream_chunk_sizes_{};
+
+    const std::shared_ptr<CMetrics::ServerMetrics> metrics_;
+    const std::map<QString, std::shared_ptr<CMetrics::CommandMetrics>> commands_metrics_;
+    QElapsedTimer connecting_timer_;
+    // Started commands without output yet
+    QHash<QString, QElapsedTimer> first_byte_timers_;
 };
 
 }
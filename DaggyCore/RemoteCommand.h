@@ -11,6 +11,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #ifndef REMOTECOMMAND_H
 #define REMOTECOMMAND_H
 
+#include <QByteArray>
+#include <QMetaType>
 #include <QString>
 
 namespace daggycore {
@@ -30,18 +32,25 @@ struct RemoteCommand {
             Error
         };
 
-        const QString command_name;
-        const QString output_extension;
-        const QByteArray data;
-        const Type type;
+        QString command_name;
+        QString output_extension;
+        QByteArray data;
+        Type type = Type::Standard;
+        qint64 receive_time = 0; // ms since epoch, taken by the data source thread when the data arrived
     };
 
-    const QString command_name;
-    const QString command;
-    const QString output_extension;
-    const bool restart;
+    QString command_name;
+    QString command;
+    QString output_extension;
+    bool restart = false;
+    QString output_compression; // Empty - receiver default
+    QString output_format; // Empty - receiver default
 };
 
 }
 
+Q_DECLARE_METATYPE(daggycore::RemoteCommand)
+Q_DECLARE_METATYPE(daggycore::RemoteCommand::Status)
+Q_DECLARE_METATYPE(daggycore::RemoteCommand::Stream)
+
 #endif // REMOTECOMMAND_H
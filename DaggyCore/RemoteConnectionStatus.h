@@ -11,6 +11,8 @@ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLI
 #ifndef REMOTECONNECTIONSTATUS_H
 #define REMOTECONNECTIONSTATUS_H
 
+#include <QMetaType>
+
 namespace daggycore {
 
 enum class RemoteConnectionStatus {
@@ -22,4 +24,6 @@ enum class RemoteConnectionStatus {
 
 }
 
+Q_DECLARE_METATYPE(daggycore::RemoteConnectionStatus)
+
 #endif // REMOTECONNECTIONSTATUS_H
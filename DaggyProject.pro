@@ -1,8 +1,11 @@
-TEMPLATE = subdirs
-
-CONFIG += ordered
-
-SUBDIRS += \
-    ssh \
-    DaggyCore \
-    Daggy
+TEMPLATE = subdirs
+
+CONFIG += ordered
+
+SUBDIRS += \
+    ssh \
+    DaggyCore \
+    Daggy
+
+# Benchmarks start a local sshd and synthetic data generators
+unix: SUBDIRS += benchmarks
@@ -13,9 +13,20 @@ unix: {
 }
 
 
+# zlib is used for ssh compression and gzip output files. Windows builds use it
+# only when zlib.lib is put to 3rd-party/msvc17_64x/zlib; CONFIG+=no_zlib
+# builds without it everywhere.
+!no_zlib {
+    unix|exists($$PWD/3rd-party/msvc17_64x/zlib/zlib.lib) {
+        CONFIG += daggy_zlib
+        DEFINES += DAGGY_ZLIB
+    }
+}
+
 unix: !macx {
     CONFIG += link_pkgconfig
     PKGCONFIG += botan-2 yaml-cpp
+    daggy_zlib: PKGCONFIG += zlib
 }
 
 macx: {
@@ -23,10 +34,12 @@ macx: {
     INCLUDEPATH += /usr/local/include/
 
     LIBS += -L/usr/local/lib -lbotan-2 -lyaml-cpp
+    daggy_zlib: LIBS += -lz
 }
 
 win32: {
     LIBS += -L$$PWD/3rd-party/msvc17_64x/botan2/lib/ -L$$PWD/3rd-party/msvc17_64x/yaml-cpp/
+    daggy_zlib: LIBS += -L$$PWD/3rd-party/msvc17_64x/zlib/ -lzlib
     INCLUDEPATH += $$PWD/3rd-party/include/
 
     QMAKE_TARGET_COMPANY = "Mikhail Milovidov <milovidovmikhail@gmail.com>"
@@ -0,0 +1,138 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CCipherBenchmark.h"
+
+#include <botan/block_cipher.h>
+#include <botan/cbc.h>
+#include <botan/ctr.h>
+#include <botan/filters.h>
+#include <botan/pipe.h>
+#include <botan/stream_mode.h>
+
+#include <memory>
+
+namespace {
+// AES and TripleDES blocks are not larger
+constexpr int max_block_size_global = 16;
+
+std::unique_ptr<Botan::BlockCipher> blockCipher( const CCipherBenchmark::Algorithm& algorithm )
+{
+     return Botan::BlockCipher::create_or_throw( algorithm.block_cipher.toStdString() );
+}
+
+Botan::SymmetricKey key( const Botan::BlockCipher& cipher )
+{
+     return Botan::SymmetricKey( std::vector<uint8_t>( cipher.key_spec().maximum_keylength(), 0x5a ) );
+}
+
+Botan::InitializationVector iv( const Botan::BlockCipher& cipher )
+{
+     return Botan::InitializationVector( std::vector<uint8_t>( cipher.block_size(), 0xa5 ) );
+}
+
+double bytesPerSecond( const qint64 bytes, const QElapsedTimer& elapsed )
+{
+     const qint64 nanoseconds = elapsed.nsecsElapsed();
+     return nanoseconds > 0 ? bytes * 1e9 / nanoseconds : 0;
+}
+}
+
+const std::vector<CCipherBenchmark::Algorithm>& CCipherBenchmark::algorithms()
+{
+     static const std::vector<Algorithm> algorithms = {
+          { "aes128-ctr", "AES-128", Mode::Ctr },
+          { "aes192-ctr", "AES-192", Mode::Ctr },
+          { "aes256-ctr", "AES-256", Mode::Ctr },
+          { "3des-ctr", "TripleDES", Mode::Ctr },
+          { "aes128-cbc", "AES-128", Mode::Cbc },
+          { "3des-cbc", "TripleDES", Mode::Cbc }
+     };
+     return algorithms;
+}
+
+CCipherBenchmark::CCipherBenchmark( const int packet_size, const qint64 total_bytes )
+  : packet_size_( packet_size )
+  , total_bytes_( total_bytes )
+{
+     if ( packet_size_ < max_block_size_global || packet_size_ % max_block_size_global != 0 )
+          throw std::invalid_argument( QString( "Invalid packet-size value: %1" ).arg( packet_size_ ).toStdString() );
+     if ( total_bytes_ < packet_size_ )
+          throw std::invalid_argument( QString( "Invalid bytes value: %1" ).arg( total_bytes_ ).toStdString() );
+}
+
+double CCipherBenchmark::runPipe( const Algorithm& algorithm ) const
+{
+     std::unique_ptr<Botan::BlockCipher> cipher = blockCipher( algorithm );
+     const Botan::SymmetricKey& cipher_key = key( *cipher );
+     const Botan::InitializationVector& cipher_iv = iv( *cipher );
+     Botan::Keyed_Filter* filter = nullptr;
+     if ( algorithm.mode == Mode::Cbc )
+     {
+          filter = Botan::get_cipher( algorithm.block_cipher.toStdString() + "/CBC/NoPadding", cipher_key, cipher_iv, Botan::ENCRYPTION );
+     }
+     else
+     {
+          filter = new Botan::StreamCipher_Filter( new Botan::CTR_BE( cipher.release() ) );
+          filter->set_key( cipher_key );
+          filter->set_iv( cipher_iv );
+     }
+     Botan::Pipe pipe( filter );
+
+     QByteArray packet( packet_size_, 'a' );
+     uint8_t* const data = reinterpret_cast<uint8_t*>( packet.data() );
+     const size_t size = static_cast<size_t>( packet_size_ );
+     const qint64 packets_count = packetsCount();
+     QElapsedTimer elapsed;
+     elapsed.start();
+     for ( qint64 index = 0; index < packets_count; index++ )
+     {
+          pipe.process_msg( data, size );
+          if ( pipe.read( data, size, pipe.message_count() - 1 ) != size )
+               throw std::runtime_error( "Botan::Pipe::read() returned unexpected value" );
+     }
+     return bytesPerSecond( packets_count * packet_size_, elapsed );
+}
+
+double CCipherBenchmark::runCipherMode( const Algorithm& algorithm ) const
+{
+     std::unique_ptr<Botan::BlockCipher> cipher = blockCipher( algorithm );
+     const Botan::SymmetricKey& cipher_key = key( *cipher );
+     const Botan::InitializationVector& cipher_iv = iv( *cipher );
+     std::unique_ptr<Botan::Cipher_Mode> cipher_mode;
+     if ( algorithm.mode == Mode::Cbc )
+          cipher_mode.reset( new Botan::CBC_Encryption( cipher.release(), new Botan::Null_Padding ) );
+     else
+          cipher_mode.reset( new Botan::Stream_Cipher_Mode( new Botan::CTR_BE( cipher.release() ) ) );
+     cipher_mode->set_key( cipher_key );
+     cipher_mode->start( cipher_iv.begin(), cipher_iv.length() );
+
+     QByteArray packet( packet_size_, 'a' );
+     uint8_t* const data = reinterpret_cast<uint8_t*>( packet.data() );
+     const size_t size = static_cast<size_t>( packet_size_ );
+     const qint64 packets_count = packetsCount();
+     QElapsedTimer elapsed;
+     elapsed.start();
+     for ( qint64 index = 0; index < packets_count; index++ )
+     {
+          if ( cipher_mode->process( data, size ) != size )
+               throw std::runtime_error( "Botan::Cipher_Mode::process() returned unexpected value" );
+     }
+     return bytesPerSecond( packets_count * packet_size_, elapsed );
+}
+
+qint64 CCipherBenchmark::packetsCount() const
+{
+     return total_bytes_ / packet_size_;
+}
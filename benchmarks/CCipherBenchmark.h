@@ -0,0 +1,53 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CCIPHERBENCHMARK_H
+#define CCIPHERBENCHMARK_H
+
+#include <QString>
+
+#include <vector>
+
+// Encrypts packets with the block cipher modes of the ssh transport in two ways: through
+// Botan::Pipe with a message per packet, as the crypto facility did before, and with the
+// Cipher_Mode object processing the packet in place, as it does now.
+class CCipherBenchmark
+{
+public:
+     enum class Mode {
+          Cbc,
+          Ctr
+     };
+
+     struct Algorithm {
+          QString ssh_name;
+          QString block_cipher;
+          Mode mode;
+     };
+
+     static const std::vector<Algorithm>& algorithms();
+
+     CCipherBenchmark( const int packet_size, const qint64 total_bytes );
+
+     // Bytes per second
+     double runPipe( const Algorithm& algorithm ) const;
+     double runCipherMode( const Algorithm& algorithm ) const;
+
+private:
+     qint64 packetsCount() const;
+
+     const int packet_size_;
+     const qint64 total_bytes_;
+};
+
+#endif // CCIPHERBENCHMARK_H
@@ -0,0 +1,263 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CDaggyBenchmark.h"
+
+using namespace daggycore;
+
+CDaggyBenchmark::CDaggyBenchmark( const DataSources& data_sources, QObject* parent_ptr )
+  : IRemoteAgregatorReciever( parent_ptr )
+  , daggy_( data_sources )
+  , start_cpu_milliseconds_( 0 )
+  , first_stream_milliseconds_( -1 )
+  , recieved_bytes_( 0 )
+  , recieved_error_bytes_( 0 )
+  , connected_sources_( 0 )
+  , connection_errors_( 0 )
+  , started_commands_( 0 )
+  , failed_commands_( 0 )
+  , expected_sources_( -1 )
+  , expected_commands_( -1 )
+  , connected_milliseconds_( -1 )
+  , started_milliseconds_( -1 )
+{
+     daggy_.connectRemoteAgregatorReciever( this );
+}
+
+void CDaggyBenchmark::setThreadsCount( const int threads_count )
+{
+     daggy_.setThreadsCount( threads_count );
+}
+
+void CDaggyBenchmark::connectReciever( IRemoteAgregatorReciever* const reciever_ptr )
+{
+     daggy_.connectRemoteAgregatorReciever( reciever_ptr );
+}
+
+CDaggyBenchmark::Result CDaggyBenchmark::run( const int seconds )
+{
+     QEventLoop event_loop;
+     Result result;
+     bool stop_requested = false;
+     const auto stop = [&]() {
+          if ( stop_requested )
+               return;
+          stop_requested = true;
+          result = snapshot();
+          daggy_.stop( false );
+          QTimer::singleShot( hard_stop_timeout_milliseconds_global, &event_loop, [this]() { daggy_.stop( true ); } );
+     };
+     connect( &daggy_, &IRemoteAgregator::stateChanged, &event_loop, [&]( const IRemoteAgregator::State state ) {
+          if ( state != IRemoteAgregator::State::Stopped )
+               return;
+          if ( !stop_requested )
+               result = snapshot();
+          stop_requested = true;
+          event_loop.quit();
+     } );
+     QTimer::singleShot( seconds * 1000, &event_loop, stop );
+
+     start_cpu_milliseconds_ = performance_monitor_.report().cpu_milliseconds;
+     performance_monitor_.start();
+     elapsed_.start();
+     daggy_.start();
+     if ( daggy_.state() != IRemoteAgregator::State::Stopped )
+          event_loop.exec();
+     return result;
+}
+
+CDaggyBenchmark::StartupResult CDaggyBenchmark::runStartup( const int sources_count, const int commands_count, const int timeout_seconds )
+{
+     expected_sources_ = sources_count;
+     expected_commands_ = sources_count * commands_count;
+
+     QEventLoop event_loop;
+     qint64 stop_start = -1;
+     qint64 stop_milliseconds = -1;
+     const auto stop = [&]() {
+          if ( stop_start >= 0 )
+               return;
+          stop_start = elapsed_.elapsed();
+          daggy_.stop( false );
+          QTimer::singleShot( hard_stop_timeout_milliseconds_global, &event_loop, [this]() { daggy_.stop( true ); } );
+     };
+     connect( &daggy_, &IRemoteAgregator::stateChanged, &event_loop, [&]( const IRemoteAgregator::State state ) {
+          if ( state != IRemoteAgregator::State::Stopped )
+               return;
+          if ( stop_start >= 0 )
+               stop_milliseconds = elapsed_.elapsed() - stop_start;
+          event_loop.quit();
+     } );
+     // Queued, so that the agregator is not stopped from inside its own start
+     connect( this, &CDaggyBenchmark::startupFinished, &event_loop, stop, Qt::QueuedConnection );
+     QTimer::singleShot( timeout_seconds * 1000, &event_loop, stop );
+
+     start_cpu_milliseconds_ = performance_monitor_.report().cpu_milliseconds;
+     performance_monitor_.start();
+     elapsed_.start();
+     daggy_.start();
+     checkStartupFinished();
+     if ( daggy_.state() != IRemoteAgregator::State::Stopped )
+          event_loop.exec();
+
+     CPerformanceMonitor::Report performance = performance_monitor_.report();
+     performance.cpu_milliseconds -= start_cpu_milliseconds_;
+     return {
+          connected_milliseconds_,
+          started_milliseconds_,
+          stop_milliseconds,
+          connected_sources_,
+          started_commands_,
+          failed_commands_,
+          performance
+     };
+}
+
+void CDaggyBenchmark::printResult( const Result& result )
+{
+     QTextStream out( stdout );
+     const double seconds = ( result.run_milliseconds - qMax<qint64>( result.first_stream_milliseconds, 0 ) ) / 1000.0;
+     const double megabytes = result.recieved_bytes / ( 1024.0 * 1024.0 );
+     out << QString( "Sources connected: %1, connection errors: %2, commands started: %3, failed: %4" )
+              .arg( result.connected_sources )
+              .arg( result.connection_errors )
+              .arg( result.started_commands )
+              .arg( result.failed_commands )
+         << endl;
+     out << QString( "Run: %1 ms, first stream chunk after %2 ms" )
+              .arg( result.run_milliseconds )
+              .arg( result.first_stream_milliseconds )
+         << endl;
+     out << QString( "Stream bytes recieved: %1, stderr: %2, copied: %3 (%4 per byte)" )
+              .arg( result.recieved_bytes )
+              .arg( result.recieved_error_bytes )
+              .arg( result.copied_bytes )
+              .arg( result.recieved_bytes > 0 ? static_cast<double>( result.copied_bytes ) / result.recieved_bytes : 0, 0, 'f', 2 )
+         << endl;
+     out << QString( "Throughput: %1 MB/s, CPU: %2 ms per MB, peak memory: %3 MB" )
+              .arg( seconds > 0 ? megabytes / seconds : 0, 0, 'f', 2 )
+              .arg( megabytes > 0 ? result.performance.cpu_milliseconds / megabytes : 0, 0, 'f', 2 )
+              .arg( result.performance.peak_memory_bytes / ( 1024 * 1024 ) )
+         << endl;
+     out << QString( "Event loop latency average: %1 us, max: %2 us" )
+              .arg( result.performance.average_latency_microseconds )
+              .arg( result.performance.max_latency_microseconds )
+         << endl;
+     out << QString( "Stream chunks by size: %1" ).arg( chunkSizesText( result.chunk_sizes ) ) << endl;
+}
+
+void CDaggyBenchmark::printStartupResult( const StartupResult& result )
+{
+     QTextStream out( stdout );
+     out << QString( "Sources connected: %1 in %2 ms" ).arg( result.connected_sources ).arg( result.connected_milliseconds ) << endl;
+     out << QString( "Commands started: %1, failed: %2, all in %3 ms" )
+              .arg( result.started_commands )
+              .arg( result.failed_commands )
+              .arg( result.started_milliseconds )
+         << endl;
+     out << QString( "Stopped in %1 ms" ).arg( result.stop_milliseconds ) << endl;
+     out << QString( "CPU: %1 ms, peak memory: %2 MB" )
+              .arg( result.performance.cpu_milliseconds )
+              .arg( result.performance.peak_memory_bytes / ( 1024 * 1024 ) )
+         << endl;
+     out << QString( "Event loop latency average: %1 us, max: %2 us" )
+              .arg( result.performance.average_latency_microseconds )
+              .arg( result.performance.max_latency_microseconds )
+         << endl;
+}
+
+void CDaggyBenchmark::onConnectionStatusChanged( const QString server_name, const RemoteConnectionStatus status, const QString message )
+{
+     switch ( status )
+     {
+     case RemoteConnectionStatus::Connected:
+          connected_sources_++;
+          break;
+     case RemoteConnectionStatus::ConnectionError:
+          connection_errors_++;
+          if ( connection_errors_ == 1 )
+               qWarning() << "Connection error on" << server_name << message;
+          break;
+     default:
+          break;
+     }
+     checkStartupFinished();
+}
+
+void CDaggyBenchmark::onRemoteCommandStatusChanged( const QString, const RemoteCommand, const RemoteCommand::Status status, const int )
+{
+     if ( status == RemoteCommand::Status::Started )
+          started_commands_++;
+     else if ( status == RemoteCommand::Status::FailedToStart )
+          failed_commands_++;
+     checkStartupFinished();
+}
+
+void CDaggyBenchmark::onNewRemoteCommandStream( const QString, const RemoteCommand::Stream stream )
+{
+     if ( first_stream_milliseconds_ < 0 )
+          first_stream_milliseconds_ = elapsed_.elapsed();
+     if ( stream.type == RemoteCommand::Stream::Type::Standard )
+          recieved_bytes_ += static_cast<quint64>( stream.data.size() );
+     else
+          recieved_error_bytes_ += static_cast<quint64>( stream.data.size() );
+}
+
+CDaggyBenchmark::Result CDaggyBenchmark::snapshot() const
+{
+     CPerformanceMonitor::Report performance = performance_monitor_.report();
+     performance.cpu_milliseconds -= start_cpu_milliseconds_;
+     return {
+          elapsed_.elapsed(),
+          first_stream_milliseconds_,
+          recieved_bytes_,
+          recieved_error_bytes_,
+          daggy_.copiedStreamBytes(),
+          daggy_.streamChunkSizes(),
+          connected_sources_,
+          connection_errors_,
+          started_commands_,
+          failed_commands_,
+          performance
+     };
+}
+
+void CDaggyBenchmark::checkStartupFinished()
+{
+     if ( expected_sources_ < 0 || ( started_milliseconds_ >= 0 && connected_milliseconds_ >= 0 ) )
+          return;
+     if ( connected_milliseconds_ < 0 && connected_sources_ >= expected_sources_ )
+          connected_milliseconds_ = elapsed_.elapsed();
+     if ( started_milliseconds_ < 0 && started_commands_ + failed_commands_ >= expected_commands_ )
+          started_milliseconds_ = elapsed_.elapsed();
+     if ( connected_milliseconds_ >= 0 && started_milliseconds_ >= 0 )
+          emit startupFinished();
+}
+
+QString CDaggyBenchmark::chunkSizesText( const std::vector<quint64>& chunk_sizes )
+{
+     QStringList buckets;
+     for ( size_t bucket = 0; bucket < chunk_sizes.size(); bucket++ )
+     {
+          if ( chunk_sizes[bucket] == 0 )
+               continue;
+          const quint64 bucket_bytes = IRemoteAgregator::streamChunkBucketBytes( static_cast<int>( bucket ) );
+          const QString& bucket_name = bucket == 0 ? QString( "<256B" )
+                                                   : bucket_bytes >= 1024 * 1024 ? QString( "%1M" ).arg( bucket_bytes / ( 1024 * 1024 ) )
+                                                                                 : bucket_bytes >= 1024 ? QString( "%1K" ).arg( bucket_bytes / 1024 )
+                                                                                                        : QString( "%1B" ).arg( bucket_bytes );
+          buckets << QString( "%1: %2" ).arg( bucket_name ).arg( chunk_sizes[bucket] );
+     }
+     return buckets.join( ", " );
+}
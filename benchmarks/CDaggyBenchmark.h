@@ -0,0 +1,111 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CDAGGYBENCHMARK_H
+#define CDAGGYBENCHMARK_H
+
+#include <QElapsedTimer>
+
+#include <vector>
+
+#include <DaggyCore/CDaggy.h>
+#include <DaggyCore/IRemoteAgregatorReciever.h>
+
+#include "CPerformanceMonitor.h"
+
+// Runs CDaggy with the given data sources for a fixed time and counts what reaches the reciever.
+// Throughput is measured from the first delivered stream chunk, so that handshakes
+// and process starts are not averaged into it; CPU, memory and event loop latency
+// are of the whole benchmark process.
+class CDaggyBenchmark : public daggycore::IRemoteAgregatorReciever
+{
+     Q_OBJECT
+public:
+     static constexpr int hard_stop_timeout_milliseconds_global = 10000;
+
+     struct Result {
+          qint64 run_milliseconds;
+          qint64 first_stream_milliseconds;
+          quint64 recieved_bytes;
+          quint64 recieved_error_bytes;
+          quint64 copied_bytes;
+          std::vector<quint64> chunk_sizes;
+          int connected_sources;
+          int connection_errors;
+          int started_commands;
+          int failed_commands;
+          CPerformanceMonitor::Report performance;
+     };
+
+     // Times from start, -1 if not reached before the timeout
+     struct StartupResult {
+          qint64 connected_milliseconds;
+          qint64 started_milliseconds;
+          qint64 stop_milliseconds;
+          int connected_sources;
+          int started_commands;
+          int failed_commands;
+          CPerformanceMonitor::Report performance;
+     };
+
+     explicit CDaggyBenchmark( const daggycore::DataSources& data_sources, QObject* parent_ptr = nullptr );
+
+     void setThreadsCount( const int threads_count );
+     // Recievers get the same streams; they must outlive the benchmark
+     void connectReciever( daggycore::IRemoteAgregatorReciever* const reciever_ptr );
+
+     Result run( const int seconds );
+     // Starts, waits until all sources are connected and all commands are started, then stops
+     StartupResult runStartup( const int sources_count, const int commands_count, const int timeout_seconds );
+
+     static void printResult( const Result& result );
+     static void printStartupResult( const StartupResult& result );
+
+signals:
+     void startupFinished();
+
+public slots:
+     void onConnectionStatusChanged( const QString server_name,
+                                     const daggycore::RemoteConnectionStatus status,
+                                     const QString message ) override;
+     void onRemoteCommandStatusChanged( const QString server_name,
+                                        const daggycore::RemoteCommand remote_command,
+                                        const daggycore::RemoteCommand::Status status,
+                                        const int exit_code ) override;
+     void onNewRemoteCommandStream( const QString server_name,
+                                    const daggycore::RemoteCommand::Stream stream ) override;
+
+private:
+     Result snapshot() const;
+     void checkStartupFinished();
+
+     static QString chunkSizesText( const std::vector<quint64>& chunk_sizes );
+
+     daggycore::CDaggy daggy_;
+     CPerformanceMonitor performance_monitor_;
+     QElapsedTimer elapsed_;
+     qint64 start_cpu_milliseconds_;
+     qint64 first_stream_milliseconds_;
+     quint64 recieved_bytes_;
+     quint64 recieved_error_bytes_;
+     int connected_sources_;
+     int connection_errors_;
+     int started_commands_;
+     int failed_commands_;
+     int expected_sources_;
+     int expected_commands_;
+     qint64 connected_milliseconds_;
+     qint64 started_milliseconds_;
+};
+
+#endif // CDAGGYBENCHMARK_H
@@ -0,0 +1,96 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CHandshakeBenchmark.h"
+#include "CLocalSshServer.h"
+#include "CPerformanceMonitor.h"
+
+#include <ssh/sshconnection.h>
+
+CHandshakeBenchmark::CHandshakeBenchmark( CLocalSshServer& ssh_server, const int handshakes_count )
+  : ssh_server_( ssh_server )
+  , handshakes_count_( handshakes_count )
+{
+     if ( handshakes_count_ < 1 )
+          throw std::invalid_argument( QString( "Invalid handshakes value: %1" ).arg( handshakes_count_ ).toStdString() );
+}
+
+CHandshakeBenchmark::Result CHandshakeBenchmark::run( const QString& key_exchange, const QString& host_key_algorithm )
+{
+     Result result = { 0, 0, 0, 0, QString() };
+     try {
+          ssh_server_.start( { QString( "KexAlgorithms %1" ).arg( key_exchange ),
+                               QString( "HostKeyAlgorithms %1" ).arg( host_key_algorithm ) } );
+     }
+     catch ( const std::exception& exception )
+     {
+          result.errors = 1;
+          result.error_string = exception.what();
+          return result;
+     }
+
+     const qint64 start_cpu = CPerformanceMonitor().report().cpu_milliseconds;
+     QElapsedTimer elapsed;
+     elapsed.start();
+     for ( int index = 0; index < handshakes_count_; index++ )
+     {
+          const QString& error_string = handshake();
+          if ( error_string.isEmpty() )
+               result.handshakes++;
+          else if ( result.errors++ == 0 )
+               result.error_string = error_string;
+     }
+     result.elapsed_milliseconds = elapsed.elapsed();
+     result.cpu_milliseconds = CPerformanceMonitor().report().cpu_milliseconds - start_cpu;
+     return result;
+}
+
+void CHandshakeBenchmark::printResult( const QString& key_exchange, const QString& host_key_algorithm, const Result& result )
+{
+     const double seconds = result.elapsed_milliseconds / 1000.0;
+     QTextStream out( stdout );
+     out << QString( "%1 %2 " ).arg( key_exchange, -30 ).arg( host_key_algorithm, -20 );
+     if ( result.handshakes == 0 )
+          out << QString( "failed: %1" ).arg( result.error_string ) << endl;
+     else
+          out << QString( "%1 handshakes/s, CPU: %2 ms per handshake, errors: %3" )
+                   .arg( seconds > 0 ? result.handshakes / seconds : 0, 0, 'f', 1 )
+                   .arg( static_cast<double>( result.cpu_milliseconds ) / result.handshakes, 0, 'f', 2 )
+                   .arg( result.errors )
+              << endl;
+}
+
+QString CHandshakeBenchmark::handshake() const
+{
+     QSsh::SshConnectionParameters parameters;
+     parameters.setHost( ssh_server_.host() );
+     parameters.setPort( ssh_server_.port() );
+     parameters.setUserName( ssh_server_.userName() );
+     parameters.privateKeyFile = ssh_server_.clientKeyFile();
+     parameters.authenticationType = QSsh::SshConnectionParameters::AuthenticationTypePublicKey;
+     parameters.timeout = connection_timeout_seconds_global;
+
+     QSsh::SshConnection connection( parameters );
+     QEventLoop event_loop;
+     QObject::connect( &connection, &QSsh::SshConnection::connected, &event_loop, &QEventLoop::quit );
+     QObject::connect( &connection, &QSsh::SshConnection::error, &event_loop, &QEventLoop::quit );
+     connection.connectToHost();
+     if ( connection.state() == QSsh::SshConnection::Connecting )
+          event_loop.exec();
+
+     if ( connection.state() != QSsh::SshConnection::Connected )
+          return connection.errorString().isEmpty() ? QString( "Connection failed" ) : connection.errorString();
+     connection.disconnectFromHost();
+     return QString();
+}
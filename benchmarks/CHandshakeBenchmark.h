@@ -0,0 +1,51 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CHANDSHAKEBENCHMARK_H
+#define CHANDSHAKEBENCHMARK_H
+
+#include <QString>
+
+class CLocalSshServer;
+
+// Connects to the local sshd and disconnects one connection after another, with sshd
+// restricted to one key exchange method and one host key algorithm.
+// CPU is of the client only, sshd is another process.
+class CHandshakeBenchmark
+{
+public:
+     static constexpr int connection_timeout_seconds_global = 10;
+
+     struct Result {
+          int handshakes;
+          int errors;
+          qint64 elapsed_milliseconds;
+          qint64 cpu_milliseconds;
+          QString error_string;
+     };
+
+     CHandshakeBenchmark( CLocalSshServer& ssh_server, const int handshakes_count );
+
+     Result run( const QString& key_exchange, const QString& host_key_algorithm );
+
+     static void printResult( const QString& key_exchange, const QString& host_key_algorithm, const Result& result );
+
+private:
+     // Returns empty string on success
+     QString handshake() const;
+
+     CLocalSshServer& ssh_server_;
+     const int handshakes_count_;
+};
+
+#endif // CHANDSHAKEBENCHMARK_H
@@ -0,0 +1,121 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CLatencyProxy.h"
+
+#include <QPair>
+#include <QQueue>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+#include <memory>
+
+CLatencyProxy::CLatencyProxy( const QString& target_host,
+                              const quint16 target_port,
+                              const int delay_milliseconds,
+                              QObject* parent_ptr )
+  : QThread( parent_ptr )
+  , target_host_( target_host )
+  , target_port_( target_port )
+  , delay_milliseconds_( delay_milliseconds )
+  , port_( 0 )
+{
+     if ( delay_milliseconds_ < 0 )
+          throw std::invalid_argument( QString( "Invalid delay value: %1" ).arg( delay_milliseconds_ ).toStdString() );
+}
+
+CLatencyProxy::~CLatencyProxy()
+{
+     quit();
+     wait();
+}
+
+void CLatencyProxy::listen()
+{
+     start();
+     // port_ is written by the proxy thread before the release
+     listening_.acquire();
+     if ( port_ == 0 )
+          throw std::runtime_error( "Cannot listen on localhost port for latency proxy" );
+}
+
+quint16 CLatencyProxy::port() const
+{
+     return port_;
+}
+
+void CLatencyProxy::run()
+{
+     QTcpServer server;
+     elapsed_.start();
+     if ( server.listen( QHostAddress::LocalHost, 0 ) )
+          port_ = server.serverPort();
+     connect( &server, &QTcpServer::newConnection, [this, &server]() {
+          while ( QTcpSocket* const client_socket = server.nextPendingConnection() )
+               accept( client_socket );
+     } );
+     listening_.release();
+     if ( port_ != 0 )
+          exec();
+}
+
+void CLatencyProxy::accept( QTcpSocket* const client_socket )
+{
+     // The target socket is a child of the client one and is deleted with it
+     QTcpSocket* const target_socket = new QTcpSocket( client_socket );
+     forward( client_socket, target_socket );
+     forward( target_socket, client_socket );
+
+     // A closed side closes the other one after the data in flight is delivered
+     connect( client_socket, &QTcpSocket::disconnected, target_socket, [this, target_socket]() {
+          QTimer::singleShot( delay_milliseconds_ + 1, target_socket, [target_socket]() { target_socket->disconnectFromHost(); } );
+     } );
+     connect( target_socket, &QTcpSocket::disconnected, client_socket, [this, client_socket]() {
+          QTimer::singleShot( delay_milliseconds_ + 1, client_socket, [client_socket]() { client_socket->disconnectFromHost(); } );
+     } );
+     connect( client_socket, &QTcpSocket::disconnected, client_socket, [this, client_socket]() {
+          QTimer::singleShot( 2 * delay_milliseconds_ + 2, client_socket, &QObject::deleteLater );
+     } );
+     connect( target_socket, static_cast<void ( QAbstractSocket::* )( QAbstractSocket::SocketError )>( &QAbstractSocket::error ),
+              client_socket, [client_socket]( QAbstractSocket::SocketError ) { client_socket->disconnectFromHost(); } );
+
+     target_socket->connectToHost( target_host_, target_port_ );
+}
+
+void CLatencyProxy::forward( QTcpSocket* const from_socket, QTcpSocket* const to_socket )
+{
+     using Chunk = QPair<qint64, QByteArray>;
+     const std::shared_ptr<QQueue<Chunk>> chunks = std::make_shared<QQueue<Chunk>>();
+     QTimer* const send_timer = new QTimer( from_socket );
+     send_timer->setSingleShot( true );
+     send_timer->setTimerType( Qt::PreciseTimer );
+
+     // Chunks due are written once the destination is connected, the rest wait for the timer
+     const auto send = [this, chunks, send_timer, to_socket]() {
+          if ( to_socket->state() != QAbstractSocket::ConnectedState )
+               return;
+          const qint64 now = elapsed_.elapsed();
+          while ( !chunks->isEmpty() && chunks->head().first <= now )
+               to_socket->write( chunks->dequeue().second );
+          if ( !chunks->isEmpty() )
+               send_timer->start( static_cast<int>( chunks->head().first - now ) );
+     };
+     connect( send_timer, &QTimer::timeout, to_socket, send );
+     connect( to_socket, &QTcpSocket::connected, send_timer, send );
+     connect( from_socket, &QTcpSocket::readyRead, send_timer, [this, chunks, send_timer, from_socket]() {
+          chunks->enqueue( { elapsed_.elapsed() + delay_milliseconds_, from_socket->readAll() } );
+          if ( !send_timer->isActive() )
+               send_timer->start( delay_milliseconds_ );
+     } );
+}
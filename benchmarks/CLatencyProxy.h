@@ -0,0 +1,57 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CLATENCYPROXY_H
+#define CLATENCYPROXY_H
+
+#include <QThread>
+#include <QElapsedTimer>
+#include <QSemaphore>
+#include <QString>
+
+class QTcpSocket;
+
+// TCP proxy on a localhost port that holds every chunk for a fixed delay in each
+// direction, so that a local server looks like a far one. Runs its own thread, so
+// that a busy benchmark event loop does not add to the delay.
+class CLatencyProxy : public QThread
+{
+     Q_OBJECT
+public:
+     CLatencyProxy( const QString& target_host,
+                    const quint16 target_port,
+                    const int delay_milliseconds,
+                    QObject* parent_ptr = nullptr );
+     ~CLatencyProxy() override;
+
+     // Starts the proxy thread and returns when the port accepts connections
+     void listen();
+     quint16 port() const;
+
+protected:
+     void run() override;
+
+private:
+     void accept( QTcpSocket* const client_socket );
+     void forward( QTcpSocket* const from_socket, QTcpSocket* const to_socket );
+
+     const QString target_host_;
+     const quint16 target_port_;
+     const int delay_milliseconds_;
+
+     QSemaphore listening_;
+     QElapsedTimer elapsed_;
+     quint16 port_;
+};
+
+#endif // CLATENCYPROXY_H
@@ -0,0 +1,193 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CLocalSshServer.h"
+
+#include <QStandardPaths>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QThread>
+
+#include <pwd.h>
+#include <unistd.h>
+
+namespace {
+constexpr const char* localhost_global = "127.0.0.1";
+constexpr const char* client_key_global = "id_ed25519";
+constexpr const char* config_file_global = "sshd_config";
+const QStringList host_key_types_global = { "ed25519", "ecdsa", "rsa" };
+}
+
+CLocalSshServer::CLocalSshServer( QObject* parent_ptr )
+  : QObject( parent_ptr )
+  , sshd_( this )
+  , port_( 0 )
+  , keys_generated_( false )
+{
+     if ( !folder_.isValid() )
+          throw std::runtime_error( "Cannot create temporary folder for sshd" );
+     sshd_.setProcessChannelMode( QProcess::ForwardedErrorChannel );
+}
+
+CLocalSshServer::~CLocalSshServer()
+{
+     stop();
+}
+
+void CLocalSshServer::start( const QStringList& options )
+{
+     stop();
+     if ( !keys_generated_ )
+          generateKeys();
+
+     port_ = freePort();
+     writeConfig( options );
+
+     sshd_.start( sshdPath(), { "-D", "-e", "-f", filePath( config_file_global ) } );
+     if ( !sshd_.waitForStarted() )
+          throw std::runtime_error( QString( "Cannot start sshd: %1" ).arg( sshd_.errorString() ).toStdString() );
+     if ( !waitForPort() )
+          throw std::runtime_error( QString( "sshd does not accept connections on port %1" ).arg( port_ ).toStdString() );
+}
+
+void CLocalSshServer::stop()
+{
+     if ( sshd_.state() == QProcess::NotRunning )
+          return;
+     sshd_.terminate();
+     if ( !sshd_.waitForFinished( start_timeout_milliseconds_global ) )
+     {
+          sshd_.kill();
+          sshd_.waitForFinished();
+     }
+}
+
+QString CLocalSshServer::host() const
+{
+     return localhost_global;
+}
+
+quint16 CLocalSshServer::port() const
+{
+     return port_;
+}
+
+QString CLocalSshServer::userName() const
+{
+     const passwd* const user = getpwuid( getuid() );
+     return user ? QString::fromLocal8Bit( user->pw_name ) : QString::fromLocal8Bit( qgetenv( "USER" ) );
+}
+
+QString CLocalSshServer::clientKeyFile() const
+{
+     return filePath( client_key_global );
+}
+
+QVariantMap CLocalSshServer::connectionParameters() const
+{
+     return {
+          { "port", static_cast<int>( port_ ) },
+          { "login", userName() },
+          { "key", clientKeyFile() }
+     };
+}
+
+void CLocalSshServer::generateKeys()
+{
+     for ( const QString& type : host_key_types_global )
+          generateKey( type, filePath( QString( "ssh_host_%1_key" ).arg( type ) ) );
+     generateKey( "ed25519", clientKeyFile() );
+
+     QFile public_key( clientKeyFile() + ".pub" );
+     QFile authorized_keys( filePath( "authorized_keys" ) );
+     if ( !public_key.open( QIODevice::ReadOnly ) || !authorized_keys.open( QIODevice::WriteOnly ) ||
+          authorized_keys.write( public_key.readAll() ) < 0 )
+          throw std::runtime_error( "Cannot write authorized_keys for sshd" );
+     keys_generated_ = true;
+}
+
+void CLocalSshServer::generateKey( const QString& type, const QString& file_path )
+{
+     QProcess ssh_keygen;
+     ssh_keygen.start( "ssh-keygen", { "-q", "-t", type, "-N", "", "-f", file_path } );
+     if ( !ssh_keygen.waitForFinished() || ssh_keygen.exitStatus() != QProcess::NormalExit || ssh_keygen.exitCode() != 0 )
+          throw std::runtime_error( QString( "Cannot generate %1 key: %2" )
+                                      .arg( type, QString::fromLocal8Bit( ssh_keygen.readAllStandardError() ) )
+                                      .toStdString() );
+}
+
+void CLocalSshServer::writeConfig( const QStringList& options ) const
+{
+     QStringList config = {
+          QString( "ListenAddress %1:%2" ).arg( localhost_global ).arg( port_ ),
+          QString( "PidFile %1" ).arg( filePath( "sshd.pid" ) ),
+          QString( "AuthorizedKeysFile %1" ).arg( filePath( "authorized_keys" ) ),
+          "PubkeyAuthentication yes",
+          "PasswordAuthentication no",
+          "UsePAM no",
+          "StrictModes no",
+          "MaxSessions 1000",
+          "MaxStartups 1000",
+          "LogLevel ERROR"
+     };
+     for ( const QString& type : host_key_types_global )
+          config << QString( "HostKey %1" ).arg( filePath( QString( "ssh_host_%1_key" ).arg( type ) ) );
+     // sshd uses the first value of an option, so the options of the caller go before the defaults
+     config = options + config;
+
+     QFile config_file( filePath( config_file_global ) );
+     if ( !config_file.open( QIODevice::WriteOnly | QIODevice::Truncate ) ||
+          config_file.write( config.join( '\n' ).toUtf8() + '\n' ) < 0 )
+          throw std::runtime_error( "Cannot write sshd_config" );
+}
+
+bool CLocalSshServer::waitForPort() const
+{
+     QElapsedTimer elapsed;
+     elapsed.start();
+     while ( elapsed.elapsed() < start_timeout_milliseconds_global && sshd_.state() == QProcess::Running )
+     {
+          QTcpSocket socket;
+          socket.connectToHost( localhost_global, port_ );
+          if ( socket.waitForConnected( 100 ) )
+               return true;
+          QThread::msleep( 50 );
+     }
+     return false;
+}
+
+QString CLocalSshServer::sshdPath()
+{
+     // sshd refuses to start when it is not run by absolute path
+     const QString& sshd_path = QStandardPaths::findExecutable( "sshd", { "/usr/sbin", "/usr/local/sbin", "/sbin" } );
+     if ( !sshd_path.isEmpty() )
+          return sshd_path;
+     const QString& path_sshd = QStandardPaths::findExecutable( "sshd" );
+     if ( path_sshd.isEmpty() )
+          throw std::runtime_error( "sshd is not found. Install OpenSSH server to run ssh benchmarks" );
+     return path_sshd;
+}
+
+quint16 CLocalSshServer::freePort()
+{
+     QTcpServer server;
+     if ( !server.listen( QHostAddress( localhost_global ), 0 ) )
+          throw std::runtime_error( QString( "Cannot find free port for sshd: %1" ).arg( server.errorString() ).toStdString() );
+     return server.serverPort();
+}
+
+QString CLocalSshServer::filePath( const QString& file_name ) const
+{
+     return QDir( folder_.path() ).filePath( file_name );
+}
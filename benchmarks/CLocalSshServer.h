@@ -0,0 +1,65 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CLOCALSSHSERVER_H
+#define CLOCALSSHSERVER_H
+
+#include <QObject>
+#include <QProcess>
+#include <QStringList>
+#include <QTemporaryDir>
+#include <QVariantMap>
+
+// OpenSSH server on a free localhost port, run as the current user with keys generated
+// in a temporary folder. Stands in for a remote host, so that ssh benchmarks load the whole
+// daggy ssh path without any host setup.
+class CLocalSshServer : public QObject
+{
+     Q_OBJECT
+public:
+     static constexpr int start_timeout_milliseconds_global = 10000;
+
+     explicit CLocalSshServer( QObject* parent_ptr = nullptr );
+     ~CLocalSshServer();
+
+     // Starts sshd. Options are sshd_config lines added to the generated config,
+     // e.g. "KexAlgorithms curve25519-sha256". Running server is restarted
+     void start( const QStringList& options = QStringList() );
+     void stop();
+
+     QString host() const;
+     quint16 port() const;
+     QString userName() const;
+     QString clientKeyFile() const;
+
+     // Connection field of ssh data sources for this server
+     QVariantMap connectionParameters() const;
+
+private:
+     void generateKeys();
+     void generateKey( const QString& type, const QString& file_path );
+     void writeConfig( const QStringList& options ) const;
+     bool waitForPort() const;
+
+     static QString sshdPath();
+     static quint16 freePort();
+
+     QString filePath( const QString& file_name ) const;
+
+     QTemporaryDir folder_;
+     QProcess sshd_;
+     quint16 port_;
+     bool keys_generated_;
+};
+
+#endif // CLOCALSSHSERVER_H
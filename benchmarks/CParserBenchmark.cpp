@@ -0,0 +1,191 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CParserBenchmark.h"
+
+#include <QBuffer>
+#include <QTcpSocket>
+
+#include <ssh/sshcapabilities_p.h>
+#include <ssh/sshcompressionfacility_p.h>
+#include <ssh/sshcryptofacility_p.h>
+#include <ssh/sshincomingbuffer_p.h>
+#include <ssh/sshincomingpacket_p.h>
+#include <ssh/sshkeyexchange_p.h>
+#include <ssh/sshoutgoingpacket_p.h>
+#include <ssh/sshsendfacility_p.h>
+
+using namespace QSsh;
+using namespace QSsh::Internal;
+
+namespace {
+constexpr quint32 remote_channel_global = 0;
+constexpr int max_payload_size_global = 32768;
+
+// Encrypts as the server does: with the server to client algorithms and keys
+class CServerEncryptionFacility : public SshEncryptionFacility
+{
+private:
+     QByteArray cryptAlgoName( const SshKeyExchange& kex ) const override { return kex.decryptionAlgo(); }
+     QByteArray hMacAlgoName( const SshKeyExchange& kex ) const override { return kex.hMacAlgoServerToClient(); }
+     char ivChar() const override { return 'B'; }
+     char keyChar() const override { return 'D'; }
+     char macChar() const override { return 'F'; }
+};
+
+// Hands out at most read_size bytes per SshIncomingBuffer::readFrom(), like a socket
+class CSocketReadsDevice : public QBuffer
+{
+public:
+     CSocketReadsDevice( QByteArray* data, const int read_size )
+       : QBuffer( data )
+       , read_size_( read_size )
+     {}
+
+     qint64 bytesAvailable() const override
+     {
+          return qMin<qint64>( QBuffer::bytesAvailable(), read_size_ );
+     }
+
+private:
+     const int read_size_;
+};
+}
+
+bool CParserBenchmark::compressionSupported()
+{
+     return SshCapabilities::CompressionAlgorithms.contains( SshCapabilities::CompressionAlgoZlibOpenSsh );
+}
+
+CParserBenchmark::CParserBenchmark( const QString& cipher,
+                                    const QString& mac,
+                                    const int payload_size,
+                                    const qint64 total_bytes,
+                                    const int read_size )
+  : cipher_( cipher.toLatin1() )
+  , mac_( mac.toLatin1() )
+  , payload_size_( payload_size )
+  , total_bytes_( total_bytes )
+  , read_size_( read_size )
+{
+     if ( !SshCapabilities::EncryptionAlgorithms.contains( cipher_ ) )
+          throw std::invalid_argument( QString( "Invalid cipher value: %1" ).arg( cipher ).toStdString() );
+     if ( !SshCapabilities::MacAlgorithms.contains( mac_ ) )
+          throw std::invalid_argument( QString( "Invalid mac value: %1" ).arg( mac ).toStdString() );
+     if ( payload_size_ < 1 || payload_size_ > max_payload_size_global )
+          throw std::invalid_argument( QString( "Invalid payload-size value: %1" ).arg( payload_size_ ).toStdString() );
+     if ( total_bytes_ < payload_size_ )
+          throw std::invalid_argument( QString( "Invalid bytes value: %1" ).arg( total_bytes_ ).toStdString() );
+     if ( read_size_ < 1 )
+          throw std::invalid_argument( QString( "Invalid read-size value: %1" ).arg( read_size_ ).toStdString() );
+}
+
+CParserBenchmark::Result CParserBenchmark::run( const bool compression, const int iterations ) const
+{
+     SshConnectionParameters parameters;
+     if ( compression )
+          parameters.options |= SshEnableCompression;
+     QTcpSocket socket;
+     SshSendFacility send_facility( &socket );
+     SshKeyExchange key_exchange( parameters, send_facility );
+     key_exchange.setNegotiatedState( SshCapabilities::Curve25519Sha256, cipher_, mac_,
+                                      AbstractSshPacket::encodeString( QByteArray( 32, '\x5a' ) ) );
+
+     CServerEncryptionFacility encrypter;
+     encrypter.recreateKeys( key_exchange );
+     SshCompressor compressor;
+     compressor.recreate( key_exchange.compressionAlgoServerToClient() );
+     if ( compression )
+          compressor.enableDelayedCompression();
+     quint32 sequence_number = 0;
+     SshOutgoingPacket outgoing_packet( encrypter, compressor, sequence_number );
+
+     QByteArray stream;
+     qint64 packets = 0;
+     qint64 payload_bytes = 0;
+     for ( ; payload_bytes < total_bytes_; payload_bytes += payload_size_ )
+     {
+          outgoing_packet.generateChannelDataPacket( remote_channel_global, { payload( packets ) }, 0,
+                                                     static_cast<quint32>( payload_size_ ) );
+          stream += outgoing_packet.rawData();
+          sequence_number++;
+          packets++;
+     }
+
+     Result result = { 0, 0, 0, 0 };
+     for ( int iteration = 0; iteration < iterations; iteration++ )
+     {
+          // A new connection each time: sequence numbers, cipher state and zlib stream start over
+          SshIncomingPacket incoming_packet;
+          incoming_packet.recreateKeys( key_exchange );
+          if ( compression )
+               incoming_packet.enableDelayedCompression();
+          SshIncomingBuffer incoming_data;
+          CSocketReadsDevice device( &stream, read_size_ );
+          device.open( QIODevice::ReadOnly | QIODevice::Unbuffered );
+
+          qint64 parsed_packets = 0;
+          QElapsedTimer elapsed;
+          elapsed.start();
+          // Same loop as SshConnectionPrivate::handlePackets() after every socket read
+          while ( incoming_data.readFrom( &device ) > 0 )
+          {
+               incoming_packet.consumeData( incoming_data );
+               while ( incoming_packet.isComplete() )
+               {
+                    if ( incoming_packet.type() != SSH_MSG_CHANNEL_DATA )
+                         throw std::runtime_error( "Parsed packet is not channel data" );
+                    parsed_packets++;
+                    incoming_packet.clear();
+                    incoming_packet.consumeData( incoming_data );
+               }
+          }
+          result.nanoseconds += elapsed.nsecsElapsed();
+          if ( parsed_packets != packets || !incoming_data.isEmpty() )
+               throw std::runtime_error( QString( "Parsed %1 packets of %2" ).arg( parsed_packets ).arg( packets ).toStdString() );
+
+          result.stream_bytes += stream.size();
+          result.payload_bytes += payload_bytes;
+          result.packets += parsed_packets;
+     }
+     return result;
+}
+
+void CParserBenchmark::printResult( const QString& name, const Result& result )
+{
+     const double seconds = result.nanoseconds / 1e9;
+     QTextStream( stdout ) << QString( "%1: %2 MB/s read, %3 MB/s channel data, %4 packets/s, %5 bytes per packet" )
+                                .arg( name, -28 )
+                                .arg( seconds > 0 ? result.stream_bytes / ( 1024.0 * 1024 ) / seconds : 0, 0, 'f', 2 )
+                                .arg( seconds > 0 ? result.payload_bytes / ( 1024.0 * 1024 ) / seconds : 0, 0, 'f', 2 )
+                                .arg( seconds > 0 ? result.packets / seconds : 0, 0, 'f', 0 )
+                                .arg( result.packets > 0 ? result.stream_bytes / result.packets : 0 )
+                           << endl;
+}
+
+QByteArray CParserBenchmark::payload( const qint64 index ) const
+{
+     // Log lines, so that compressed runs see command output like ratios
+     QByteArray result;
+     result.reserve( payload_size_ + 64 );
+     for ( qint64 line = index; result.size() < payload_size_; line++ )
+          result += QString( "2019-06-01 12:%1:%2 INFO request %3 served in %4 ms\n" )
+                        .arg( line / 60 % 60, 2, 10, QChar( '0' ) )
+                        .arg( line % 60, 2, 10, QChar( '0' ) )
+                        .arg( line )
+                        .arg( line * 7 % 1000 )
+                        .toLatin1();
+     result.truncate( payload_size_ );
+     return result;
+}
@@ -0,0 +1,59 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CPARSERBENCHMARK_H
+#define CPARSERBENCHMARK_H
+
+#include <QByteArray>
+#include <QString>
+
+// Parses a recorded stream of small encrypted channel data packets the way the ssh
+// connection parses socket data: the stream is read into SshIncomingBuffer in chunks as
+// large as socket reads, and SshIncomingPacket takes every complete packet out of it.
+// The stream is recorded with the server to client keys of a fixed shared secret, so no
+// server is needed. With compression the payload is deflated as after
+// enableDelayedCompression on both sides.
+class CParserBenchmark
+{
+public:
+     struct Result {
+          qint64 stream_bytes;
+          qint64 payload_bytes;
+          qint64 packets;
+          qint64 nanoseconds;
+     };
+
+     static bool compressionSupported();
+
+     CParserBenchmark( const QString& cipher,
+                       const QString& mac,
+                       const int payload_size,
+                       const qint64 total_bytes,
+                       const int read_size );
+
+     // Records the stream once, then parses it iterations times
+     Result run( const bool compression, const int iterations ) const;
+
+     static void printResult( const QString& name, const Result& result );
+
+private:
+     QByteArray payload( const qint64 index ) const;
+
+     const QByteArray cipher_;
+     const QByteArray mac_;
+     const int payload_size_;
+     const qint64 total_bytes_;
+     const int read_size_;
+};
+
+#endif // CPARSERBENCHMARK_H
@@ -0,0 +1,70 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CSyntheticSource.h"
+
+#include <QThread>
+
+namespace {
+// Rate limited sources write about 100 blocks per second
+constexpr int blocks_per_second_global = 100;
+}
+
+CSyntheticSource::CSyntheticSource( const qint64 bytes_per_second, const int line_size, const qint64 total_bytes )
+  : bytes_per_second_( bytes_per_second )
+  , line_size_( line_size )
+  , total_bytes_( total_bytes )
+{
+     if ( bytes_per_second_ < 0 )
+          throw std::invalid_argument( QString( "Invalid rate value: %1" ).arg( bytes_per_second_ ).toStdString() );
+     if ( line_size_ < 1 || line_size_ > max_block_bytes_global )
+          throw std::invalid_argument( QString( "Invalid line-size value: %1" ).arg( line_size_ ).toStdString() );
+     if ( total_bytes_ < 0 )
+          throw std::invalid_argument( QString( "Invalid bytes value: %1" ).arg( total_bytes_ ).toStdString() );
+}
+
+int CSyntheticSource::run()
+{
+     const QByteArray& block = makeBlock();
+     QElapsedTimer elapsed;
+     elapsed.start();
+
+     qint64 written = 0;
+     while ( total_bytes_ == 0 || written < total_bytes_ )
+     {
+          const qint64 size = total_bytes_ == 0 ? block.size() : qMin<qint64>( block.size(), total_bytes_ - written );
+          if ( fwrite( block.constData(), 1, static_cast<size_t>( size ), stdout ) != static_cast<size_t>( size ) ||
+               fflush( stdout ) != 0 )
+               return 0;
+          written += size;
+
+          if ( bytes_per_second_ > 0 )
+          {
+               const qint64 ahead = written * 1000 / bytes_per_second_ - elapsed.elapsed();
+               if ( ahead > 0 )
+                    QThread::msleep( static_cast<unsigned long>( ahead ) );
+          }
+     }
+     return 0;
+}
+
+QByteArray CSyntheticSource::makeBlock() const
+{
+     const qint64 block_bytes = bytes_per_second_ > 0
+                                  ? qBound<qint64>( line_size_, bytes_per_second_ / blocks_per_second_global, max_block_bytes_global )
+                                  : max_block_bytes_global;
+     QByteArray line( line_size_, 'a' );
+     line[line_size_ - 1] = '\n';
+     return line.repeated( static_cast<int>( block_bytes / line_size_ ) );
+}
@@ -0,0 +1,40 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CSYNTHETICSOURCE_H
+#define CSYNTHETICSOURCE_H
+
+#include <QByteArray>
+
+// Remote command of the benchmarks: writes lines of a fixed size to stdout at a fixed rate,
+// so that the load does not depend on shell tools installed on the host.
+// Rate 0 writes as fast as the reader takes the data.
+class CSyntheticSource
+{
+public:
+     static constexpr int max_block_bytes_global = 64 * 1024;
+
+     CSyntheticSource( const qint64 bytes_per_second, const int line_size, const qint64 total_bytes );
+
+     // Returns after total bytes are written, or when stdout is closed
+     int run();
+
+private:
+     QByteArray makeBlock() const;
+
+     const qint64 bytes_per_second_;
+     const int line_size_;
+     const qint64 total_bytes_;
+};
+
+#endif // CSYNTHETICSOURCE_H
@@ -0,0 +1,148 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CWriterBenchmark.h"
+#include "CPerformanceMonitor.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+constexpr int line_size_global = 100;
+}
+
+CWriterBenchmark::CWriterBenchmark( const QString& output_folder, const int files_count, const int chunk_size, const qint64 total_bytes )
+  : output_folder_( output_folder )
+  , files_count_( files_count )
+  , total_bytes_( total_bytes )
+{
+     if ( files_count_ < 1 )
+          throw std::invalid_argument( QString( "Invalid files value: %1" ).arg( files_count_ ).toStdString() );
+     if ( chunk_size < 1 )
+          throw std::invalid_argument( QString( "Invalid chunk-size value: %1" ).arg( chunk_size ).toStdString() );
+
+     QByteArray line( line_size_global, 'a' );
+     line[line_size_global - 1] = '\n';
+     chunk_ = line.repeated( chunk_size / line_size_global + 1 ).left( chunk_size );
+}
+
+CWriterBenchmark::Result CWriterBenchmark::runFlushEveryChunk()
+{
+     std::vector<std::unique_ptr<QFile>> files;
+     for ( int index = 0; index < files_count_; index++ )
+     {
+          files.emplace_back( new QFile( filePath( "flush", index ) ) );
+          if ( !files.back()->open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+               throw std::runtime_error( QString( "Cannot open %1: %2" ).arg( files.back()->fileName(), files.back()->errorString() ).toStdString() );
+     }
+
+     const qint64 start_cpu = CPerformanceMonitor().report().cpu_milliseconds;
+     QElapsedTimer elapsed;
+     elapsed.start();
+     const qint64 chunks_count = chunksCount();
+     for ( qint64 chunk = 0; chunk < chunks_count; chunk++ )
+     {
+          QFile& file = *files[static_cast<size_t>( chunk % files_count_ )];
+          file.write( chunk_ );
+          file.flush();
+     }
+     files.clear();
+     const qint64 elapsed_milliseconds = elapsed.elapsed();
+     return { elapsed_milliseconds, elapsed_milliseconds, CPerformanceMonitor().report().cpu_milliseconds - start_cpu, 0, 0, 0, 0, 0 };
+}
+
+CWriterBenchmark::Result CWriterBenchmark::runOutputFilesWriter( const qint64 flush_bytes,
+                                                                const int flush_milliseconds,
+                                                                const COutputFilesWriter::Compression compression,
+                                                                const int compression_level )
+{
+     COutputFilesWriter writer( { flush_bytes, flush_milliseconds },
+                                { 0, 0, COutputFilesWriter::SegmentNaming::Number, 0, false },
+                                { QString(), COutputFilesWriter::default_merge_window_milliseconds_global, COutputFilesWriter::Compression::None },
+                                COutputFilesWriter::default_max_queued_bytes_global,
+                                compression_level );
+     writer.start();
+     const QString& extension = compression == COutputFilesWriter::Compression::None
+                                  ? QString()
+                                  : "." + COutputFilesWriter::compressionExtension( compression );
+     std::vector<COutputFilesWriter::FileId> files;
+     for ( int index = 0; index < files_count_; index++ )
+          files.push_back( writer.openFile( filePath( "writer", index ) + extension, compression ) );
+
+     const qint64 start_cpu = CPerformanceMonitor().report().cpu_milliseconds;
+     QElapsedTimer elapsed;
+     elapsed.start();
+     const qint64 chunks_count = chunksCount();
+     const qint64 receive_time = QDateTime::currentMSecsSinceEpoch();
+     for ( qint64 chunk = 0; chunk < chunks_count; chunk++ )
+          writer.write( files[static_cast<size_t>( chunk % files_count_ )], chunk_, receive_time );
+     const qint64 caller_milliseconds = elapsed.elapsed();
+     for ( const COutputFilesWriter::FileId file_id : files )
+          writer.closeFile( file_id );
+     writer.stop();
+
+     const COutputFilesWriter::Statistics& statistics = writer.statistics();
+     return { elapsed.elapsed(),
+              caller_milliseconds,
+              CPerformanceMonitor().report().cpu_milliseconds - start_cpu,
+              statistics.stalled_writes,
+              statistics.stalled_nanoseconds / 1000000,
+              statistics.writer_cpu_nanoseconds / 1000000,
+              statistics.input_bytes,
+              statistics.output_bytes };
+}
+
+void CWriterBenchmark::printResult( const QString& name, const Result& result ) const
+{
+     const double megabytes = chunksCount() * chunk_.size() / ( 1024.0 * 1024.0 );
+     QTextStream( stdout ) << QString( "%1: %2 MB/s, caller busy: %3 ms of %4 ms, CPU: %5 ms per MB, write queue full: %6 times, %7 ms" )
+                                .arg( name, -20 )
+                                .arg( result.elapsed_milliseconds > 0 ? megabytes * 1000 / result.elapsed_milliseconds : 0, 0, 'f', 2 )
+                                .arg( result.caller_milliseconds )
+                                .arg( result.elapsed_milliseconds )
+                                .arg( megabytes > 0 ? result.cpu_milliseconds / megabytes : 0, 0, 'f', 2 )
+                                .arg( result.stalled_writes )
+                                .arg( result.stalled_milliseconds )
+                           << endl;
+     if ( result.writer_cpu_milliseconds == 0 )
+          return;
+
+     // Input MB per second of writer thread CPU is the throughput of one core
+     const double writer_seconds = result.writer_cpu_milliseconds / 1000.0;
+     QTextStream( stdout ) << QString( "%1  writer thread: %2 MB/s per core, CPU: %3 ms per MB" )
+                                .arg( QString(), -20 )
+                                .arg( megabytes / writer_seconds, 0, 'f', 2 )
+                                .arg( megabytes > 0 ? result.writer_cpu_milliseconds / megabytes : 0, 0, 'f', 2 )
+                           << endl;
+     if ( result.compressed_input_bytes == 0 )
+          return;
+     QTextStream( stdout ) << QString( "%1  compressed: %2 bytes to %3 bytes (%4x)" )
+                                .arg( QString(), -20 )
+                                .arg( result.compressed_input_bytes )
+                                .arg( result.compressed_output_bytes )
+                                .arg( result.compressed_output_bytes > 0
+                                        ? static_cast<double>( result.compressed_input_bytes ) / result.compressed_output_bytes
+                                        : 0, 0, 'f', 2 )
+                           << endl;
+}
+
+QString CWriterBenchmark::filePath( const QString& prefix, const int file_index ) const
+{
+     return QDir( output_folder_ ).filePath( QString( "%1%2.log" ).arg( prefix ).arg( file_index ) );
+}
+
+qint64 CWriterBenchmark::chunksCount() const
+{
+     return qMax<qint64>( 1, total_bytes_ / chunk_.size() );
+}
@@ -0,0 +1,62 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#ifndef CWRITERBENCHMARK_H
+#define CWRITERBENCHMARK_H
+
+#include <QByteArray>
+#include <QString>
+
+#include "COutputFilesWriter.h"
+
+// Writes the same chunks to many output files twice: with a write and flush of every
+// chunk on the calling thread, as output files were written before COutputFilesWriter,
+// and through COutputFilesWriter. Caller time is how long the calling thread, the event
+// loop in daggy, was busy with writing. Writer thread CPU includes compression: all
+// gzip output files are compressed on the one writer thread.
+class CWriterBenchmark
+{
+public:
+     struct Result {
+          qint64 elapsed_milliseconds;
+          qint64 caller_milliseconds;
+          qint64 cpu_milliseconds;
+          qint64 stalled_writes;
+          qint64 stalled_milliseconds;
+          // COutputFilesWriter only
+          qint64 writer_cpu_milliseconds;
+          qint64 compressed_input_bytes;
+          qint64 compressed_output_bytes;
+     };
+
+     CWriterBenchmark( const QString& output_folder, const int files_count, const int chunk_size, const qint64 total_bytes );
+
+     Result runFlushEveryChunk();
+     Result runOutputFilesWriter( const qint64 flush_bytes,
+                                  const int flush_milliseconds,
+                                  const COutputFilesWriter::Compression compression,
+                                  const int compression_level );
+
+     void printResult( const QString& name, const Result& result ) const;
+
+private:
+     QString filePath( const QString& prefix, const int file_index ) const;
+     qint64 chunksCount() const;
+
+     const QString output_folder_;
+     const int files_count_;
+     const qint64 total_bytes_;
+     QByteArray chunk_;
+};
+
+#endif // CWRITERBENCHMARK_H
@@ -0,0 +1,50 @@
+TARGET = daggy-bench
+CONFIG += console
+CONFIG -= app_bundle
+
+TEMPLATE = app
+
+QT += core network
+
+
+include(../GeneralSettings.pri)
+
+INCLUDEPATH += $$PWD/../Daggy
+
+SOURCES += main.cpp \
+    CSyntheticSource.cpp \
+    CLocalSshServer.cpp \
+    CDaggyBenchmark.cpp \
+    CWriterBenchmark.cpp \
+    CCipherBenchmark.cpp \
+    CParserBenchmark.cpp \
+    CLatencyProxy.cpp \
+    CHandshakeBenchmark.cpp \
+    ../Daggy/CPerformanceMonitor.cpp \
+    ../Daggy/COutputFilesWriter.cpp \
+    ../Daggy/CFileDataSourcesReciever.cpp \
+    ../Daggy/CConsolePrinter.cpp
+
+
+HEADERS += \
+    Precompiled.h \
+    CSyntheticSource.h \
+    CLocalSshServer.h \
+    CDaggyBenchmark.h \
+    CWriterBenchmark.h \
+    CCipherBenchmark.h \
+    CParserBenchmark.h \
+    CLatencyProxy.h \
+    CHandshakeBenchmark.h \
+    ../Daggy/CPerformanceMonitor.h \
+    ../Daggy/COutputFilesWriter.h \
+    ../Daggy/CFileDataSourcesReciever.h \
+    ../Daggy/CConsolePrinter.h
+
+
+LIBS += -lDaggyCore -lqssh
+
+
+DEPENDPATH += $$PWD/../DaggyCore
+DEPENDPATH += $$PWD/../ssh
+DEPENDPATH += $$PWD/../Daggy
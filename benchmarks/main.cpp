@@ -0,0 +1,505 @@
+/*
+Copyright 2019 Mikhail Milovidov <milovidovmikhail@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"), to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+
+
+#include "Precompiled.h"
+#include "CSyntheticSource.h"
+#include "CLocalSshServer.h"
+#include "CDaggyBenchmark.h"
+#include "CWriterBenchmark.h"
+#include "CCipherBenchmark.h"
+#include "CParserBenchmark.h"
+#include "CLatencyProxy.h"
+#include "CHandshakeBenchmark.h"
+#include "COutputFilesWriter.h"
+#include "CFileDataSourcesReciever.h"
+
+#include <DaggyCore/CMetrics.h>
+
+#include <functional>
+
+using namespace daggycore;
+
+namespace {
+
+struct Benchmark {
+     const char* name;
+     const char* description;
+     std::function<int( const QStringList& )> run;
+};
+
+void myCategoryFilter( QLoggingCategory* category_ptr )
+{
+     if ( qstrcmp( category_ptr->categoryName(), "qtc.ssh" ) == 0 )
+          category_ptr->setEnabled( QtDebugMsg, false );
+}
+
+qint64 integerValue( const QCommandLineParser& parser, const QCommandLineOption& option, const qint64 minimum )
+{
+     bool converted = false;
+     const QString& value = parser.value( option );
+     const qint64 result = value.toLongLong( &converted );
+     if ( !converted || result < minimum )
+          throw std::invalid_argument( QString( "Invalid %1 value: %2" ).arg( option.names().last(), value ).toStdString() );
+     return result;
+}
+
+// Remote command that runs the synthetic source of this binary. Double quotes, because
+// local commands started by QProcess are split into arguments without a shell
+QString sourceCommand( const qint64 rate, const qint64 line_size )
+{
+     return QString( "\"%1\" source --rate %2 --line-size %3" )
+       .arg( QCoreApplication::applicationFilePath() )
+       .arg( rate )
+       .arg( line_size );
+}
+
+std::vector<RemoteCommand> sourceCommands( const int commands_count, const qint64 rate, const qint64 line_size )
+{
+     std::vector<RemoteCommand> remote_commands;
+     for ( int index = 0; index < commands_count; index++ )
+          remote_commands.push_back( { QString( "source%1" ).arg( index + 1 ), sourceCommand( rate, line_size ), "log" } );
+     return remote_commands;
+}
+
+int runSource( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Write lines of a fixed size to stdout at a fixed rate" );
+     parser.addHelpOption();
+     const QCommandLineOption rate_option( "rate", "Bytes per second. 0 - as fast as possible", "bytes", "0" );
+     const QCommandLineOption line_size_option( "line-size", "Line size with the line break", "bytes", "100" );
+     const QCommandLineOption bytes_option( "bytes", "Total bytes to write. 0 - until stdout is closed", "bytes", "0" );
+     parser.addOptions( { rate_option, line_size_option, bytes_option } );
+     parser.process( arguments );
+
+     CSyntheticSource source( integerValue( parser, rate_option, 0 ),
+                              static_cast<int>( integerValue( parser, line_size_option, 1 ) ),
+                              integerValue( parser, bytes_option, 0 ) );
+     return source.run();
+}
+
+int runSsh( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Aggregate synthetic sources through a local sshd" );
+     parser.addHelpOption();
+     const QCommandLineOption sources_option( "sources", "Number of ssh data sources", "count", "4" );
+     const QCommandLineOption commands_option( "commands", "Number of commands per data source", "count", "1" );
+     const QCommandLineOption rate_option( "rate", "Bytes per second of each command. 0 - as fast as possible", "bytes", "0" );
+     const QCommandLineOption line_size_option( "line-size", "Line size with the line break", "bytes", "100" );
+     const QCommandLineOption seconds_option( "seconds", "Benchmark duration", "seconds", "10" );
+     const QCommandLineOption threads_option( "threads", "Number of worker threads. 0 - thread per CPU core", "count", "1" );
+     parser.addOptions( { sources_option, commands_option, rate_option, line_size_option, seconds_option, threads_option } );
+     parser.process( arguments );
+
+     const qint64 sources_count = integerValue( parser, sources_option, 1 );
+     const std::vector<RemoteCommand>& remote_commands = sourceCommands( static_cast<int>( integerValue( parser, commands_option, 1 ) ),
+                                                                         integerValue( parser, rate_option, 0 ),
+                                                                         integerValue( parser, line_size_option, 1 ) );
+
+     CLocalSshServer ssh_server;
+     ssh_server.start();
+
+     DataSources data_sources;
+     for ( qint64 index = 0; index < sources_count; index++ )
+          data_sources.push_back( { QString( "ssh%1" ).arg( index + 1 ), "ssh", ssh_server.host(), remote_commands,
+                                    ssh_server.connectionParameters(), false } );
+
+     CDaggyBenchmark benchmark( data_sources );
+     benchmark.setThreadsCount( static_cast<int>( integerValue( parser, threads_option, 0 ) ) );
+     CDaggyBenchmark::printResult( benchmark.run( static_cast<int>( integerValue( parser, seconds_option, 1 ) ) ) );
+     return 0;
+}
+
+int runWriter( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Write chunks to many output files with flush of every chunk and with COutputFilesWriter" );
+     parser.addHelpOption();
+     const QCommandLineOption output_option( "output", "Folder for the output files. Temporary folder by default", "folder" );
+     const QCommandLineOption files_option( "files", "Number of output files", "count", "200" );
+     const QCommandLineOption chunk_size_option( "chunk-size", "Size of each written chunk", "bytes", "4096" );
+     const QCommandLineOption bytes_option( "bytes", "Total bytes written in each run", "bytes", QString::number( 512 * 1024 * 1024 ) );
+     const QCommandLineOption flush_size_option( "flush-size", "Flush size of COutputFilesWriter", "bytes",
+                                                 QString::number( COutputFilesWriter::default_flush_bytes_global ) );
+     const QCommandLineOption flush_interval_option( "flush-interval", "Flush interval of COutputFilesWriter", "milliseconds",
+                                                     QString::number( COutputFilesWriter::default_flush_milliseconds_global ) );
+     const QCommandLineOption compression_option( "compression", "Compression of COutputFilesWriter files: none, gzip", "method", "none" );
+     const QCommandLineOption compression_level_option( "compression-level", "Compression level, from 1 (fastest) to 9 (smallest)", "level",
+                                                        QString::number( COutputFilesWriter::default_compression_level_global ) );
+     parser.addOptions( { output_option, files_option, chunk_size_option, bytes_option, flush_size_option, flush_interval_option,
+                          compression_option, compression_level_option } );
+     parser.process( arguments );
+
+     bool compression_is_ok = false;
+     const COutputFilesWriter::Compression compression = COutputFilesWriter::compression( parser.value( compression_option ), &compression_is_ok );
+     if ( !compression_is_ok )
+          throw std::invalid_argument( QString( "Invalid compression value: %1" ).arg( parser.value( compression_option ) ).toStdString() );
+     const qint64 compression_level = integerValue( parser, compression_level_option, 1 );
+     if ( compression_level > 9 )
+          throw std::invalid_argument( QString( "Invalid compression-level value: %1" ).arg( compression_level ).toStdString() );
+
+     QTemporaryDir temporary_folder;
+     const QString& output_folder = parser.isSet( output_option ) ? parser.value( output_option ) : temporary_folder.path();
+     if ( output_folder.isEmpty() || !QDir().mkpath( output_folder ) )
+          throw std::runtime_error( QString( "Cannot create output folder %1" ).arg( output_folder ).toStdString() );
+
+     CWriterBenchmark benchmark( output_folder,
+                                 static_cast<int>( integerValue( parser, files_option, 1 ) ),
+                                 static_cast<int>( integerValue( parser, chunk_size_option, 1 ) ),
+                                 integerValue( parser, bytes_option, 1 ) );
+     benchmark.printResult( "Flush every chunk", benchmark.runFlushEveryChunk() );
+     benchmark.printResult( "COutputFilesWriter", benchmark.runOutputFilesWriter( integerValue( parser, flush_size_option, 0 ),
+                                                                                  static_cast<int>( integerValue( parser, flush_interval_option, 1 ) ),
+                                                                                  compression,
+                                                                                  static_cast<int>( compression_level ) ) );
+     return 0;
+}
+
+int runCiphers( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Encrypt packets through Botan::Pipe and with in place Cipher_Mode" );
+     parser.addHelpOption();
+     const QCommandLineOption packet_size_option( "packet-size", "Packet size, multiple of 16", "bytes", "32768" );
+     const QCommandLineOption bytes_option( "bytes", "Bytes encrypted with each algorithm and way", "bytes", QString::number( 256 * 1024 * 1024 ) );
+     const QCommandLineOption algorithm_option( "algorithm", "Benchmark only the algorithm, may be repeated", "name" );
+     parser.addOptions( { packet_size_option, bytes_option, algorithm_option } );
+     parser.process( arguments );
+
+     const QStringList& algorithm_names = parser.values( algorithm_option );
+     const CCipherBenchmark benchmark( static_cast<int>( integerValue( parser, packet_size_option, 1 ) ),
+                                       integerValue( parser, bytes_option, 1 ) );
+     QTextStream out( stdout );
+     for ( const CCipherBenchmark::Algorithm& algorithm : CCipherBenchmark::algorithms() )
+     {
+          if ( !algorithm_names.isEmpty() && !algorithm_names.contains( algorithm.ssh_name ) )
+               continue;
+          const double pipe = benchmark.runPipe( algorithm );
+          const double cipher_mode = benchmark.runCipherMode( algorithm );
+          out << QString( "%1 Pipe: %2 MB/s, Cipher_Mode: %3 MB/s (%4x)" )
+                   .arg( algorithm.ssh_name, -12 )
+                   .arg( pipe / ( 1024 * 1024 ), 0, 'f', 2 )
+                   .arg( cipher_mode / ( 1024 * 1024 ), 0, 'f', 2 )
+                   .arg( pipe > 0 ? cipher_mode / pipe : 0, 0, 'f', 2 )
+              << endl;
+     }
+     return 0;
+}
+
+int runParser( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Parse a recorded stream of small encrypted channel data packets in socket read sized chunks" );
+     parser.addHelpOption();
+     const QCommandLineOption cipher_option( "cipher", "Transport cipher, may be repeated", "name", "aes128-ctr" );
+     const QCommandLineOption mac_option( "mac", "MAC of ciphers without own authentication", "name", "hmac-sha2-256" );
+     const QCommandLineOption payload_size_option( "payload-size", "Channel data per packet", "bytes", "256" );
+     const QCommandLineOption bytes_option( "bytes", "Channel data in the recorded stream", "bytes", QString::number( 1024 * 1024 ) );
+     const QCommandLineOption read_size_option( "read-size", "Bytes per socket read", "bytes", "16384" );
+     const QCommandLineOption iterations_option( "iterations", "How many times the stream is parsed", "count", "100" );
+     parser.addOptions( { cipher_option, mac_option, payload_size_option, bytes_option, read_size_option, iterations_option } );
+     parser.process( arguments );
+
+     const int iterations = static_cast<int>( integerValue( parser, iterations_option, 1 ) );
+     for ( const QString& cipher : parser.values( cipher_option ) )
+     {
+          const CParserBenchmark benchmark( cipher,
+                                            parser.value( mac_option ),
+                                            static_cast<int>( integerValue( parser, payload_size_option, 1 ) ),
+                                            integerValue( parser, bytes_option, 1 ),
+                                            static_cast<int>( integerValue( parser, read_size_option, 1 ) ) );
+          CParserBenchmark::printResult( cipher, benchmark.run( false, iterations ) );
+          // Compression is switched on after user authentication, the stream is parsed as after that
+          const QString compressed_name = QString( "%1 zlib@openssh.com" ).arg( cipher );
+          if ( CParserBenchmark::compressionSupported() )
+               CParserBenchmark::printResult( compressed_name, benchmark.run( true, iterations ) );
+          else
+               QTextStream( stdout ) << compressed_name << ": built without zlib" << endl;
+     }
+     return 0;
+}
+
+int runStartup( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Start and stop many local data sources" );
+     parser.addHelpOption();
+     const QCommandLineOption sources_option( "sources", "Number of local data sources", "count", "10000" );
+     const QCommandLineOption commands_option( "commands", "Number of commands per data source", "count", "1" );
+     const QCommandLineOption command_option( "command", "Command of each data source", "command", "sleep 3600" );
+     const QCommandLineOption runner_option( "runner", "Local runner: qprocess, spawn", "runner", "qprocess" );
+     const QCommandLineOption timeout_option( "timeout", "Stop after timeout even if not all commands are started", "seconds", "300" );
+     const QCommandLineOption threads_option( "threads", "Number of worker threads. 0 - thread per CPU core", "count", "1" );
+     parser.addOptions( { sources_option, commands_option, command_option, runner_option, timeout_option, threads_option } );
+     parser.process( arguments );
+
+     const int sources_count = static_cast<int>( integerValue( parser, sources_option, 1 ) );
+     const int commands_count = static_cast<int>( integerValue( parser, commands_option, 0 ) );
+     std::vector<RemoteCommand> remote_commands;
+     for ( int index = 0; index < commands_count; index++ )
+          remote_commands.push_back( { QString( "command%1" ).arg( index + 1 ), parser.value( command_option ), "log" } );
+     const QVariantMap connection_parameters = { { "runner", parser.value( runner_option ) } };
+
+     QElapsedTimer create_elapsed;
+     create_elapsed.start();
+     DataSources data_sources;
+     data_sources.reserve( static_cast<size_t>( sources_count ) );
+     for ( int index = 0; index < sources_count; index++ )
+          data_sources.push_back( { QString( "local%1" ).arg( index + 1 ), "local", QString(), remote_commands, connection_parameters, false } );
+     CDaggyBenchmark benchmark( data_sources );
+     benchmark.setThreadsCount( static_cast<int>( integerValue( parser, threads_option, 0 ) ) );
+     QTextStream( stdout ) << QString( "Created in %1 ms" ).arg( create_elapsed.elapsed() ) << endl;
+
+     CDaggyBenchmark::printStartupResult( benchmark.runStartup( sources_count, commands_count,
+                                                                static_cast<int>( integerValue( parser, timeout_option, 1 ) ) ) );
+     return 0;
+}
+
+int runWindow( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Aggregate synthetic sources through a latency proxy to a local sshd, with fixed and adaptive channel window" );
+     parser.addHelpOption();
+     const QCommandLineOption delay_option( "delay", "Proxy delay in each direction, round trip time is twice as long", "milliseconds", "50" );
+     const QCommandLineOption window_size_option( "window-size", "Initial channel window", "bytes", "1048576" );
+     const QCommandLineOption sources_option( "sources", "Number of ssh data sources", "count", "1" );
+     const QCommandLineOption seconds_option( "seconds", "Duration of each run", "seconds", "20" );
+     parser.addOptions( { delay_option, window_size_option, sources_option, seconds_option } );
+     parser.process( arguments );
+
+     const qint64 sources_count = integerValue( parser, sources_option, 1 );
+     const int seconds = static_cast<int>( integerValue( parser, seconds_option, 1 ) );
+     const std::vector<RemoteCommand>& remote_commands = sourceCommands( 1, 0, 100 );
+
+     CLocalSshServer ssh_server;
+     ssh_server.start();
+     CLatencyProxy latency_proxy( ssh_server.host(), ssh_server.port(), static_cast<int>( integerValue( parser, delay_option, 0 ) ) );
+     latency_proxy.listen();
+
+     for ( const bool adaptive_window : { false, true } )
+     {
+          QVariantMap connection_parameters = ssh_server.connectionParameters();
+          connection_parameters["port"] = static_cast<int>( latency_proxy.port() );
+          connection_parameters["windowSize"] = integerValue( parser, window_size_option, 1 );
+          connection_parameters["adaptiveWindow"] = adaptive_window;
+
+          DataSources data_sources;
+          for ( qint64 index = 0; index < sources_count; index++ )
+               data_sources.push_back( { QString( "ssh%1" ).arg( index + 1 ), "ssh", ssh_server.host(), remote_commands,
+                                         connection_parameters, false } );
+
+          QTextStream( stdout ) << ( adaptive_window ? "Adaptive window:" : "Fixed window:" ) << endl;
+          CDaggyBenchmark benchmark( data_sources );
+          CDaggyBenchmark::printResult( benchmark.run( seconds ) );
+     }
+     return 0;
+}
+
+int runHandshakes( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Connect to a local sshd one connection after another with each key exchange method and host key algorithm" );
+     parser.addHelpOption();
+     const QCommandLineOption handshakes_option( "handshakes", "Number of connections for each method", "count", "200" );
+     const QCommandLineOption kex_option( "kex", "Benchmark only the key exchange method, may be repeated", "name" );
+     const QCommandLineOption host_key_option( "host-key", "Benchmark only the host key algorithm, may be repeated", "name" );
+     parser.addOptions( { handshakes_option, kex_option, host_key_option } );
+     parser.process( arguments );
+
+     const QStringList& key_exchanges = parser.isSet( kex_option )
+                                          ? parser.values( kex_option )
+                                          : QStringList{ "curve25519-sha256", "ecdh-sha2-nistp256", "ecdh-sha2-nistp384",
+                                                         "ecdh-sha2-nistp521", "diffie-hellman-group14-sha1" };
+     const QStringList& host_keys = parser.isSet( host_key_option )
+                                      ? parser.values( host_key_option )
+                                      : QStringList{ "ssh-ed25519", "ecdsa-sha2-nistp256", "ssh-rsa" };
+
+     CLocalSshServer ssh_server;
+     CHandshakeBenchmark benchmark( ssh_server, static_cast<int>( integerValue( parser, handshakes_option, 1 ) ) );
+     // Key exchange methods with the first host key, then host keys with the first key exchange method
+     for ( const QString& key_exchange : key_exchanges )
+          CHandshakeBenchmark::printResult( key_exchange, host_keys.first(), benchmark.run( key_exchange, host_keys.first() ) );
+     for ( const QString& host_key : host_keys.mid( 1 ) )
+          CHandshakeBenchmark::printResult( key_exchanges.first(), host_key, benchmark.run( key_exchanges.first(), host_key ) );
+     return 0;
+}
+
+int runLocal( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Aggregate hundreds of local generator commands to output files" );
+     parser.addHelpOption();
+     const QCommandLineOption yes_option( "yes", "Number of yes commands", "count", "100" );
+     const QCommandLineOption dd_option( "dd", "Number of dd commands", "count", "100" );
+     const QCommandLineOption rate_sources_option( "rate-sources", "Number of fixed rate line sources", "count", "100" );
+     const QCommandLineOption rate_option( "rate", "Bytes per second of each fixed rate source", "bytes", "1048576" );
+     const QCommandLineOption seconds_option( "seconds", "Benchmark duration", "seconds", "30" );
+     const QCommandLineOption runner_option( "runner", "Local runner: qprocess, spawn", "runner", "qprocess" );
+     const QCommandLineOption threads_option( "threads", "Number of worker threads. 0 - thread per CPU core", "count", "1" );
+     const QCommandLineOption output_option( "output", "Folder for the output files. Temporary folder by default", "folder" );
+     const QCommandLineOption flush_size_option( "flush-size", "Flush output file buffer after it reaches size", "bytes",
+                                                 QString::number( COutputFilesWriter::default_flush_bytes_global ) );
+     const QCommandLineOption flush_interval_option( "flush-interval", "Flush output file buffer not later than interval", "milliseconds",
+                                                     QString::number( COutputFilesWriter::default_flush_milliseconds_global ) );
+     const QCommandLineOption write_queue_size_option( "write-queue-size", "Maximum size of data waiting for write to output files", "bytes",
+                                                       QString::number( COutputFilesWriter::default_max_queued_bytes_global ) );
+     parser.addOptions( { yes_option, dd_option, rate_sources_option, rate_option, seconds_option, runner_option, threads_option,
+                          output_option, flush_size_option, flush_interval_option, write_queue_size_option } );
+     parser.process( arguments );
+
+     std::vector<RemoteCommand> remote_commands;
+     const qint64 yes_count = integerValue( parser, yes_option, 0 );
+     for ( qint64 index = 0; index < yes_count; index++ )
+          remote_commands.push_back( { QString( "yes%1" ).arg( index + 1 ), "yes \"daggy local benchmark line\"", "log" } );
+     const qint64 dd_count = integerValue( parser, dd_option, 0 );
+     for ( qint64 index = 0; index < dd_count; index++ )
+          remote_commands.push_back( { QString( "dd%1" ).arg( index + 1 ),
+                                       "sh -c \"dd if=/dev/zero bs=65536 2>/dev/null | tr '\\000' a\"", "log" } );
+     const qint64 rate_sources_count = integerValue( parser, rate_sources_option, 0 );
+     const qint64 rate = integerValue( parser, rate_option, 1 );
+     for ( qint64 index = 0; index < rate_sources_count; index++ )
+          remote_commands.push_back( { QString( "rate%1" ).arg( index + 1 ), sourceCommand( rate, 100 ), "log" } );
+     if ( remote_commands.empty() )
+          throw std::invalid_argument( "Invalid commands value: 0" );
+
+     QTemporaryDir temporary_folder;
+     const QString& output_folder = parser.isSet( output_option ) ? parser.value( output_option ) : temporary_folder.path();
+     const DataSources data_sources = {
+          { "localhost", "local", QString(), remote_commands, { { "runner", parser.value( runner_option ) } }, false }
+     };
+
+     // The reciever prints write queue statistics when destroyed, after the benchmark
+     CFileDataSourcesReciever file_reciever( output_folder,
+                                             { integerValue( parser, flush_size_option, 0 ),
+                                               static_cast<int>( integerValue( parser, flush_interval_option, 1 ) ) },
+                                             { 0, 0, COutputFilesWriter::SegmentNaming::Number, 0, false },
+                                             { QString(), COutputFilesWriter::default_merge_window_milliseconds_global, COutputFilesWriter::Compression::None },
+                                             integerValue( parser, write_queue_size_option, 1 ),
+                                             COutputFilesWriter::Compression::None,
+                                             COutputFilesWriter::default_compression_level_global,
+                                             COutputFilesWriter::Format::Raw,
+                                             CFileDataSourcesReciever::default_std_error_rate_global );
+     CDaggyBenchmark benchmark( data_sources );
+     benchmark.connectReciever( &file_reciever );
+     benchmark.setThreadsCount( static_cast<int>( integerValue( parser, threads_option, 0 ) ) );
+     CDaggyBenchmark::printResult( benchmark.run( static_cast<int>( integerValue( parser, seconds_option, 1 ) ) ) );
+     return 0;
+}
+
+// Upper bound of the histogram bucket that holds the quantile
+quint64 histogramQuantileBound( const CMetrics::Histogram& histogram, const double quantile )
+{
+     const quint64 count = histogram.count();
+     quint64 cumulative_count = 0;
+     for ( int bucket = 0; bucket < CMetrics::Histogram::buckets_global; bucket++ )
+     {
+          cumulative_count += histogram.bucketCount( bucket );
+          if ( cumulative_count > 0 && cumulative_count >= quantile * count )
+               return CMetrics::Histogram::bucketBound( bucket );
+     }
+     return 0;
+}
+
+int runRestarts( const QStringList& arguments )
+{
+     QCommandLineParser parser;
+     parser.setApplicationDescription( "Restart short local commands for a fixed time" );
+     parser.addHelpOption();
+     const QCommandLineOption commands_option( "commands", "Number of restarted commands", "count", "20" );
+     const QCommandLineOption command_option( "command", "Command, restarted after every exit", "command", "echo restart" );
+     const QCommandLineOption runner_option( "runner", "Local runner: qprocess, spawn", "runner", "qprocess" );
+     const QCommandLineOption seconds_option( "seconds", "Benchmark duration", "seconds", "10" );
+     parser.addOptions( { commands_option, command_option, runner_option, seconds_option } );
+     parser.process( arguments );
+
+     const qint64 commands_count = integerValue( parser, commands_option, 1 );
+     std::vector<RemoteCommand> remote_commands;
+     for ( qint64 index = 0; index < commands_count; index++ )
+          remote_commands.push_back( { QString( "restart%1" ).arg( index + 1 ), parser.value( command_option ), "log", true } );
+     const DataSources data_sources = {
+          { "localhost", "local", QString(), remote_commands, { { "runner", parser.value( runner_option ) } }, false }
+     };
+
+     CDaggyBenchmark benchmark( data_sources );
+     const CDaggyBenchmark::Result& result = benchmark.run( static_cast<int>( integerValue( parser, seconds_option, 1 ) ) );
+
+     const CMetrics::Totals& totals = CMetrics::instance().totals();
+     const CMetrics::Histogram& first_byte_latency = CMetrics::instance().serverMetrics( "localhost" )->first_byte_latency;
+     const double seconds = result.run_milliseconds / 1000.0;
+     QTextStream out( stdout );
+     out << QString( "Command starts: %1, %2 per second, failed: %3" )
+              .arg( totals.command_starts )
+              .arg( seconds > 0 ? totals.command_starts / seconds : 0, 0, 'f', 1 )
+              .arg( result.failed_commands )
+         << endl;
+     out << QString( "First output average: %1 us, p99: under %2 us, of %3 starts with output" )
+              .arg( totals.first_bytes > 0 ? totals.first_byte_microseconds / totals.first_bytes : 0 )
+              .arg( histogramQuantileBound( first_byte_latency, 0.99 ) )
+              .arg( totals.first_bytes )
+         << endl;
+     out << QString( "CPU: %1 ms, event loop latency average: %2 us, max: %3 us" )
+              .arg( result.performance.cpu_milliseconds )
+              .arg( result.performance.average_latency_microseconds )
+              .arg( result.performance.max_latency_microseconds )
+         << endl;
+     return 0;
+}
+
+const std::vector<Benchmark> benchmarks_global = {
+     { "source", "Synthetic data source, the remote command of the other benchmarks", runSource },
+     { "ssh", "CDaggy with synthetic sources through a local sshd", runSsh },
+     { "writer", "Output files written with flush of every chunk and with COutputFilesWriter", runWriter },
+     { "ciphers", "Transport ciphers through Botan::Pipe and with in place Cipher_Mode", runCiphers },
+     { "parser", "Incoming packet parsing of small encrypted packets, without and with compression", runParser },
+     { "startup", "Start and stop of thousands of local data sources", runStartup },
+     { "window", "ssh throughput over a latency proxy with fixed and adaptive channel window", runWindow },
+     { "handshakes", "ssh handshakes per second with each key exchange method and host key", runHandshakes },
+     { "local", "Hundreds of local generator commands to output files", runLocal },
+     { "restarts", "Starts per second and first output latency of restarted local commands", runRestarts }
+};
+
+int printUsage()
+{
+     QTextStream out( stderr );
+     out << "Usage: daggy-bench <benchmark> [options]" << endl
+         << "Run daggy-bench <benchmark> --help for benchmark options." << endl << endl
+         << "Benchmarks:" << endl;
+     for ( const Benchmark& benchmark : benchmarks_global )
+          out << QString( "  %1 %2" ).arg( QString( benchmark.name ), -12 ).arg( QString( benchmark.description ) ) << endl;
+     return 1;
+}
+
+}
+
+int main( int argc, char* argv[] )
+try {
+     QLoggingCategory::installFilter( myCategoryFilter );
+     QCoreApplication application( argc, argv );
+
+     QStringList arguments = application.arguments();
+     if ( arguments.size() < 2 )
+          return printUsage();
+     const QString benchmark_name = arguments.takeAt( 1 );
+     for ( const Benchmark& benchmark : benchmarks_global )
+     {
+          if ( benchmark_name == benchmark.name )
+               return benchmark.run( arguments );
+     }
+     return printUsage();
+}
+catch ( const std::exception& exception )
+{
+     qDebug() << exception.what();
+     return -1;
+}
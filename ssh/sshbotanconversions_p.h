@@ -73,7 +73,8 @@ inline const char *botanKeyExchangeAlgoName(const QByteArray &rfcAlgoName)
 inline const char *botanCryptAlgoName(const QByteArray &rfcAlgoName)
 {
     if (rfcAlgoName == SshCapabilities::CryptAlgoAes128Cbc
-            || rfcAlgoName == SshCapabilities::CryptAlgoAes128Ctr) {
+            || rfcAlgoName == SshCapabilities::CryptAlgoAes128Ctr
+            || rfcAlgoName == SshCapabilities::CryptAlgoAes128Gcm) {
         return "AES-128";
     }
     if (rfcAlgoName == SshCapabilities::CryptAlgo3DesCbc
@@ -83,9 +84,13 @@ inline const char *botanCryptAlgoName(const QByteArray &rfcAlgoName)
     if (rfcAlgoName == SshCapabilities::CryptAlgoAes192Ctr) {
         return "AES-192";
     }
-    if (rfcAlgoName == SshCapabilities::CryptAlgoAes256Ctr) {
+    if (rfcAlgoName == SshCapabilities::CryptAlgoAes256Ctr
+            || rfcAlgoName == SshCapabilities::CryptAlgoAes256Gcm) {
         return "AES-256";
     }
+    if (rfcAlgoName == SshCapabilities::CryptAlgoChaCha20Poly1305) {
+        return "ChaCha(20)";
+    }
     throw SshClientException(SshInternalError, SSH_TR("Unexpected cipher \"%1\"")
                              .arg(QString::fromLatin1(rfcAlgoName)));
 }
@@ -102,6 +107,8 @@ inline const char *botanEmsaAlgoName(const QByteArray &rfcAlgoName)
         return "EMSA1(SHA-384)";
     if (rfcAlgoName == SshCapabilities::PubKeyEcdsa521)
         return "EMSA1(SHA-512)";
+    if (rfcAlgoName == SshCapabilities::PubKeyEd25519)
+        return "Pure";
     throw SshClientException(SshInternalError, SSH_TR("Unexpected host key algorithm \"%1\"")
                              .arg(QString::fromLatin1(rfcAlgoName)));
 }
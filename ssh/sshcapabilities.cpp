@@ -51,7 +51,12 @@ const QByteArray SshCapabilities::EcdhKexNamePrefix("ecdh-sha2-nistp");
 const QByteArray SshCapabilities::EcdhNistp256 = EcdhKexNamePrefix + "256";
 const QByteArray SshCapabilities::EcdhNistp384 = EcdhKexNamePrefix + "384";
 const QByteArray SshCapabilities::EcdhNistp521 = EcdhKexNamePrefix + "521";
+const QByteArray SshCapabilities::Curve25519Sha256("curve25519-sha256");
+const QByteArray SshCapabilities::Curve25519Sha256LibSsh("curve25519-sha256@libssh.org");
+// Curve25519 first: it is the cheapest for the client, which matters on mass reconnects.
 const QList<QByteArray> SshCapabilities::KeyExchangeMethods = QList<QByteArray>()
+        << SshCapabilities::Curve25519Sha256
+        << SshCapabilities::Curve25519Sha256LibSsh
         << SshCapabilities::EcdhNistp256
         << SshCapabilities::EcdhNistp384
         << SshCapabilities::EcdhNistp521
@@ -64,7 +69,9 @@ const QByteArray SshCapabilities::PubKeyEcdsaPrefix("ecdsa-sha2-nistp");
 const QByteArray SshCapabilities::PubKeyEcdsa256 = SshCapabilities::PubKeyEcdsaPrefix + "256";
 const QByteArray SshCapabilities::PubKeyEcdsa384 = SshCapabilities::PubKeyEcdsaPrefix + "384";
 const QByteArray SshCapabilities::PubKeyEcdsa521 = SshCapabilities::PubKeyEcdsaPrefix + "521";
+const QByteArray SshCapabilities::PubKeyEd25519("ssh-ed25519");
 const QList<QByteArray> SshCapabilities::PublicKeyAlgorithms = QList<QByteArray>()
+        << SshCapabilities::PubKeyEd25519
         << SshCapabilities::PubKeyEcdsa256
         << SshCapabilities::PubKeyEcdsa384
         << SshCapabilities::PubKeyEcdsa521
@@ -77,8 +84,15 @@ const QByteArray SshCapabilities::CryptAlgoAes128Cbc("aes128-cbc");
 const QByteArray SshCapabilities::CryptAlgoAes128Ctr("aes128-ctr");
 const QByteArray SshCapabilities::CryptAlgoAes192Ctr("aes192-ctr");
 const QByteArray SshCapabilities::CryptAlgoAes256Ctr("aes256-ctr");
+const QByteArray SshCapabilities::CryptAlgoAes128Gcm("aes128-gcm@openssh.com");
+const QByteArray SshCapabilities::CryptAlgoAes256Gcm("aes256-gcm@openssh.com");
+const QByteArray SshCapabilities::CryptAlgoChaCha20Poly1305("chacha20-poly1305@openssh.com");
+// AEAD ciphers first: they need a single pass over the packet instead of cipher plus HMAC.
 const QList<QByteArray> SshCapabilities::EncryptionAlgorithms
-    = QList<QByteArray>() << SshCapabilities::CryptAlgoAes256Ctr
+    = QList<QByteArray>() << SshCapabilities::CryptAlgoAes128Gcm
+                          << SshCapabilities::CryptAlgoAes256Gcm
+                          << SshCapabilities::CryptAlgoChaCha20Poly1305
+                          << SshCapabilities::CryptAlgoAes256Ctr
                           << SshCapabilities::CryptAlgoAes192Ctr
                           << SshCapabilities::CryptAlgoAes128Ctr
                           << SshCapabilities::CryptAlgo3DesCtr
@@ -97,8 +111,16 @@ const QList<QByteArray> SshCapabilities::MacAlgorithms
         << SshCapabilities::HMacSha512
         << SshCapabilities::HMacSha1;
 
+const QByteArray SshCapabilities::CompressionAlgoNone("none");
+const QByteArray SshCapabilities::CompressionAlgoZlibOpenSsh("zlib@openssh.com");
 const QList<QByteArray> SshCapabilities::CompressionAlgorithms
-    = QList<QByteArray>() << "none";
+    = QList<QByteArray>()
+#ifdef DAGGY_ZLIB
+        << SshCapabilities::CompressionAlgoZlibOpenSsh
+#endif
+        << SshCapabilities::CompressionAlgoNone;
+const QList<QByteArray> SshCapabilities::NoCompressionAlgorithms
+    = QList<QByteArray>() << SshCapabilities::CompressionAlgoNone;
 
 const QByteArray SshCapabilities::SshConnectionService("ssh-connection");
 
@@ -166,5 +188,16 @@ const char *SshCapabilities::oid(const QByteArray &ecdsaAlgo)
                              .arg(QString::fromLatin1(ecdsaAlgo)));
 }
 
+bool SshCapabilities::isAeadCryptAlgo(const QByteArray &cryptAlgo)
+{
+    return cryptAlgo == CryptAlgoAes128Gcm || cryptAlgo == CryptAlgoAes256Gcm
+            || cryptAlgo == CryptAlgoChaCha20Poly1305;
+}
+
+bool SshCapabilities::isCurve25519KexAlgo(const QByteArray &kexAlgo)
+{
+    return kexAlgo == Curve25519Sha256 || kexAlgo == Curve25519Sha256LibSsh;
+}
+
 } // namespace Internal
 } // namespace QSsh
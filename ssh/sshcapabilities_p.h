@@ -40,6 +40,8 @@ public:
     static const QByteArray EcdhNistp256;
     static const QByteArray EcdhNistp384;
     static const QByteArray EcdhNistp521; // sic
+    static const QByteArray Curve25519Sha256;
+    static const QByteArray Curve25519Sha256LibSsh;
     static const QList<QByteArray> KeyExchangeMethods;
 
     static const QByteArray PubKeyDss;
@@ -48,6 +50,7 @@ public:
     static const QByteArray PubKeyEcdsa256;
     static const QByteArray PubKeyEcdsa384;
     static const QByteArray PubKeyEcdsa521;
+    static const QByteArray PubKeyEd25519;
     static const QList<QByteArray> PublicKeyAlgorithms;
 
     static const QByteArray CryptAlgo3DesCbc;
@@ -56,6 +59,9 @@ public:
     static const QByteArray CryptAlgoAes128Ctr;
     static const QByteArray CryptAlgoAes192Ctr;
     static const QByteArray CryptAlgoAes256Ctr;
+    static const QByteArray CryptAlgoAes128Gcm;
+    static const QByteArray CryptAlgoAes256Gcm;
+    static const QByteArray CryptAlgoChaCha20Poly1305;
     static const QList<QByteArray> EncryptionAlgorithms;
 
     static const QByteArray HMacSha1;
@@ -65,7 +71,10 @@ public:
     static const QByteArray HMacSha512;
     static const QList<QByteArray> MacAlgorithms;
 
+    static const QByteArray CompressionAlgoNone;
+    static const QByteArray CompressionAlgoZlibOpenSsh;
     static const QList<QByteArray> CompressionAlgorithms;
+    static const QList<QByteArray> NoCompressionAlgorithms;
 
     static const QByteArray SshConnectionService;
 
@@ -77,6 +86,8 @@ public:
     static int ecdsaIntegerWidthInBytes(const QByteArray &ecdsaAlgo);
     static QByteArray ecdsaPubKeyAlgoForKeyWidth(int keyWidthInBytes);
     static const char *oid(const QByteArray &ecdsaAlgo);
+    static bool isAeadCryptAlgo(const QByteArray &cryptAlgo);
+    static bool isCurve25519KexAlgo(const QByteArray &kexAlgo);
 };
 
 } // namespace Internal
@@ -40,12 +40,21 @@ const quint32 MinMaxPacketSize = 32768 - sizeof(quint32) - sizeof(quint32) - 1;
 
 const quint32 NoChannel = 0xffffffffu;
 
+// The smallest packet size a peer has to accept (RFC 4253, 6.1).
+const quint32 MinLocalPacketSize = 32768;
+
+// Upper bound for adaptive window growth, keeps the amount of unread data per channel bounded.
+const quint32 MaxAdaptiveWindowSize = 256 * 1024 * 1024;
+
 AbstractSshChannel::AbstractSshChannel(quint32 channelId,
     SshSendFacility &sendFacility)
     : m_sendFacility(sendFacility),
       m_localChannel(channelId), m_remoteChannel(NoChannel),
-      m_localWindowSize(initialWindowSize()), m_remoteWindowSize(0),
-      m_state(Inactive)
+      m_localWindowSize(m_windowParameters.windowSize),
+      m_localWindowMax(m_windowParameters.windowSize), m_localConsumed(0),
+      m_remoteWindowSize(0), m_state(Inactive), m_sendQueueOffset(0), m_sendQueueSize(0),
+      m_receivedBytes(0), m_windowEdge(0),
+      m_roundTripPending(false), m_minRoundTripNs(-1), m_bandwidth(0)
 {
     m_timeoutTimer.setSingleShot(true);
     connect(&m_timeoutTimer, &QTimer::timeout, this, &AbstractSshChannel::timeout);
@@ -82,7 +91,10 @@ void AbstractSshChannel::requestSessionStart()
 void AbstractSshChannel::sendData(const QByteArray &data)
 {
     try {
-        m_sendBuffer += data;
+        if (!data.isEmpty()) {
+            m_sendQueue.append(data);
+            m_sendQueueSize += data.size();
+        }
         flushSendBuffer();
     }  catch (const std::exception &e) {
         qCWarning(sshLog, "Botan error: %s", e.what());
@@ -90,14 +102,26 @@ void AbstractSshChannel::sendData(const QByteArray &data)
     }
 }
 
-quint32 AbstractSshChannel::initialWindowSize()
+void AbstractSshChannel::setWindowParameters(const SshChannelWindowParameters &parameters)
+{
+    QSSH_ASSERT_AND_RETURN(m_localConsumed == 0 && m_receivedBytes == 0);
+
+    m_windowParameters = parameters;
+    m_windowParameters.packetSize = qBound(MinLocalPacketSize, m_windowParameters.packetSize,
+                                           DefaultChannelPacketSize);
+    m_windowParameters.windowSize = qMax(m_windowParameters.windowSize,
+                                         m_windowParameters.packetSize);
+    m_localWindowSize = m_localWindowMax = m_windowParameters.windowSize;
+}
+
+quint32 AbstractSshChannel::initialWindowSize() const
 {
-    return maxPacketSize();
+    return m_windowParameters.windowSize;
 }
 
-quint32 AbstractSshChannel::maxPacketSize()
+quint32 AbstractSshChannel::maxPacketSize() const
 {
-    return 16 * 1024 * 1024;
+    return m_windowParameters.packetSize;
 }
 
 void AbstractSshChannel::handleWindowAdjust(quint32 bytesToAdd)
@@ -117,14 +141,26 @@ void AbstractSshChannel::handleWindowAdjust(quint32 bytesToAdd)
 void AbstractSshChannel::flushSendBuffer()
 {
     while (true) {
-        const quint32 bytesToSend = qMin(m_remoteMaxPacketSize,
-                qMin<quint32>(m_remoteWindowSize, m_sendBuffer.size()));
+        const quint32 bytesToSend = static_cast<quint32>(qMin<qint64>(
+                qMin(m_remoteMaxPacketSize, m_remoteWindowSize), m_sendQueueSize));
         if (bytesToSend == 0)
             break;
-        const QByteArray &data = m_sendBuffer.left(bytesToSend);
-        m_sendFacility.sendChannelDataPacket(m_remoteChannel, data);
-        m_sendBuffer.remove(0, bytesToSend);
+        m_sendFacility.sendChannelDataPacket(m_remoteChannel, m_sendQueue, m_sendQueueOffset,
+                                             bytesToSend);
         m_remoteWindowSize -= bytesToSend;
+        m_sendQueueSize -= bytesToSend;
+
+        quint32 bytesToDrop = bytesToSend;
+        while (bytesToDrop > 0) {
+            const quint32 available = m_sendQueue.first().size() - m_sendQueueOffset;
+            if (bytesToDrop < available) {
+                m_sendQueueOffset += bytesToDrop;
+                break;
+            }
+            bytesToDrop -= available;
+            m_sendQueue.removeFirst();
+            m_sendQueueOffset = 0;
+        }
     }
 }
 
@@ -235,13 +271,65 @@ int AbstractSshChannel::handleChannelOrExtendedChannelData(const QByteArray &dat
         qCWarning(sshLog, "Misbehaving server does not respect local window, clipping.");
 
     m_localWindowSize -= bytesToDeliver;
-    if (m_localWindowSize < maxPacketSize()) {
-        m_localWindowSize += maxPacketSize();
-        m_sendFacility.sendWindowAdjustPacket(m_remoteChannel, maxPacketSize());
+    m_localConsumed += bytesToDeliver;
+    m_receivedBytes += bytesToDeliver;
+    if (m_windowParameters.adaptive)
+        updateRoundTripTime();
+
+    // Like OpenSSH, top the window up once half of it has been consumed.
+    if (m_localConsumed > 0 && m_localWindowSize < m_localWindowMax / 2) {
+        if (m_windowParameters.adaptive)
+            growLocalWindow();
+        const quint32 bytesToAdd = m_localWindowMax - m_localWindowSize;
+        m_sendFacility.sendWindowAdjustPacket(m_remoteChannel, bytesToAdd);
+        m_localWindowSize += bytesToAdd;
+        m_localConsumed = 0;
     }
     return bytesToDeliver;
 }
 
+void AbstractSshChannel::updateRoundTripTime()
+{
+    if (!m_roundTripPending || m_receivedBytes <= m_windowEdge)
+        return;
+
+    // Data beyond the old window edge means the peer has seen our last adjust.
+    const qint64 sample = m_roundTripTimer.nsecsElapsed();
+    if (m_minRoundTripNs < 0 || sample < m_minRoundTripNs)
+        m_minRoundTripNs = sample;
+    m_roundTripPending = false;
+}
+
+void AbstractSshChannel::growLocalWindow()
+{
+    if (m_adjustTimer.isValid()) {
+        const qint64 elapsedNs = qMax<qint64>(m_adjustTimer.nsecsElapsed(), 1);
+        const double bandwidth = m_localConsumed * 1e9 / elapsedNs;
+        m_bandwidth = m_bandwidth > 0 ? 0.75 * m_bandwidth + 0.25 * bandwidth : bandwidth;
+    }
+    m_adjustTimer.start();
+
+    if (!m_roundTripPending) {
+        m_windowEdge = m_receivedBytes + m_localWindowSize;
+        m_roundTripTimer.start();
+        m_roundTripPending = true;
+    }
+
+    if (m_minRoundTripNs <= 0 || m_bandwidth <= 0)
+        return;
+
+    // Twice the bandwidth-delay product keeps the sender busy while the adjust is in flight.
+    const double target = 2 * m_bandwidth * m_minRoundTripNs / 1e9;
+    const quint32 newWindow = target >= MaxAdaptiveWindowSize
+            ? MaxAdaptiveWindowSize : static_cast<quint32>(target);
+    if (newWindow > m_localWindowMax) {
+        qCDebug(sshLog, "Growing window of channel %u from %u to %u bytes "
+                "(bandwidth: %.0f B/s, rtt: %lld us)", m_localChannel, m_localWindowMax,
+                newWindow, m_bandwidth, m_minRoundTripNs / 1000);
+        m_localWindowMax = newWindow;
+    }
+}
+
 void AbstractSshChannel::closeChannel()
 {
     if (m_state == CloseRequested) {
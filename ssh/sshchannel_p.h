@@ -26,6 +26,8 @@
 #pragma once
 
 #include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
 #include <QObject>
 #include <QString>
 #include <QTimer>
@@ -38,6 +40,23 @@ struct SshChannelExitStatus;
 class SshIncomingPacket;
 class SshSendFacility;
 
+const quint32 DefaultChannelWindowSize = 16 * 1024 * 1024;
+// Also the largest packet size announced: a data packet of this size, with
+// its headers and padding, still fits MaxIncomingPacketLength.
+const quint32 DefaultChannelPacketSize = 255 * 1024;
+
+struct SshChannelWindowParameters
+{
+    SshChannelWindowParameters(quint32 windowSize = DefaultChannelWindowSize,
+                               quint32 packetSize = DefaultChannelPacketSize,
+                               bool adaptive = false)
+        : windowSize(windowSize), packetSize(packetSize), adaptive(adaptive) {}
+
+    quint32 windowSize;
+    quint32 packetSize;
+    bool adaptive; // Grow the window towards the measured bandwidth-delay product.
+};
+
 class AbstractSshChannel : public QObject
 {
     Q_OBJECT
@@ -64,6 +83,9 @@ public:
 
     void closeChannel();
 
+    // Must be called before the channel is opened.
+    void setWindowParameters(const SshChannelWindowParameters &parameters);
+
     virtual ~AbstractSshChannel();
 
     static const int ReplyTimeout = 10000; // milli seconds
@@ -81,8 +103,8 @@ protected:
     void requestSessionStart();
     void sendData(const QByteArray &data);
 
-    static quint32 initialWindowSize();
-    static quint32 maxPacketSize();
+    quint32 initialWindowSize() const;
+    quint32 maxPacketSize() const;
 
     quint32 maxDataSize() const;
     void checkChannelActive();
@@ -103,14 +125,34 @@ private:
 
     void flushSendBuffer();
     int handleChannelOrExtendedChannelData(const QByteArray &data);
+    void updateRoundTripTime();
+    void growLocalWindow();
 
     const quint32 m_localChannel;
     quint32 m_remoteChannel;
+    SshChannelWindowParameters m_windowParameters;
     quint32 m_localWindowSize;
+    quint32 m_localWindowMax;
+    quint32 m_localConsumed;
     quint32 m_remoteWindowSize;
     quint32 m_remoteMaxPacketSize;
     ChannelState m_state;
-    QByteArray m_sendBuffer;
+
+    // Pending outgoing data. Chunks are shared with the caller and copied only once,
+    // into the packet; m_sendQueueOffset bytes of the first chunk are already sent.
+    QList<QByteArray> m_sendQueue;
+    int m_sendQueueOffset;
+    qint64 m_sendQueueSize;
+
+    // Adaptive window state. The round trip is sampled as the time from sending a window
+    // adjust until the peer sends past the window edge it had before that adjust.
+    quint64 m_receivedBytes;
+    quint64 m_windowEdge;
+    bool m_roundTripPending;
+    qint64 m_minRoundTripNs;
+    double m_bandwidth; // bytes per second
+    QElapsedTimer m_roundTripTimer;
+    QElapsedTimer m_adjustTimer;
 };
 
 } // namespace Internal
@@ -43,8 +43,9 @@ namespace QSsh {
 namespace Internal {
 
 SshChannelManager::SshChannelManager(SshSendFacility &sendFacility,
-    QObject *parent)
-    : QObject(parent), m_sendFacility(sendFacility), m_nextLocalChannelId(0)
+    const SshChannelWindowParameters &windowParameters, QObject *parent)
+    : QObject(parent), m_sendFacility(sendFacility), m_windowParameters(windowParameters),
+      m_nextLocalChannelId(0)
 {
 }
 
@@ -97,6 +98,7 @@ void SshChannelManager::handleChannelOpen(const SshIncomingPacket &packet)
 
     SshForwardedTcpIpTunnel::Ptr tunnel(new SshForwardedTcpIpTunnel(m_nextLocalChannelId++,
                                                                     m_sendFacility));
+    tunnel->d->setWindowParameters(m_windowParameters);
     tunnel->d->handleOpenSuccess(channelOpen.remoteChannel, channelOpen.remoteWindowSize,
                                  channelOpen.remoteMaxPacketSize);
     tunnel->open(QIODevice::ReadWrite);
@@ -275,6 +277,7 @@ void SshChannelManager::insertChannel(AbstractSshChannel *priv,
     const QSharedPointer<QObject> &pub)
 {
     connect(priv, &AbstractSshChannel::timeout, this, &SshChannelManager::timeout);
+    priv->setWindowParameters(m_windowParameters);
     m_channels.insert(priv->localChannelId(), priv);
     m_sessions.insert(priv, pub);
 }
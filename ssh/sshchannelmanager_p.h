@@ -25,6 +25,8 @@
 
 #pragma once
 
+#include "sshchannel_p.h"
+
 #include <QHash>
 #include <QObject>
 #include <QSharedPointer>
@@ -37,7 +39,6 @@ class SshTcpIpForwardServer;
 
 namespace Internal {
 
-class AbstractSshChannel;
 class SshIncomingPacket;
 class SshSendFacility;
 
@@ -45,7 +46,8 @@ class SshChannelManager : public QObject
 {
     Q_OBJECT
 public:
-    SshChannelManager(SshSendFacility &sendFacility, QObject *parent);
+    SshChannelManager(SshSendFacility &sendFacility,
+                      const SshChannelWindowParameters &windowParameters, QObject *parent);
 
     QSharedPointer<SshRemoteProcess> createRemoteProcess(const QByteArray &command);
     QSharedPointer<SshRemoteProcess> createRemoteShell();
@@ -87,6 +89,7 @@ private:
         const QSharedPointer<QObject> &pub);
 
     SshSendFacility &m_sendFacility;
+    const SshChannelWindowParameters m_windowParameters;
     QHash<quint32, AbstractSshChannel *> m_channels;
     QHash<AbstractSshChannel *, QSharedPointer<QObject> > m_sessions;
     quint32 m_nextLocalChannelId;
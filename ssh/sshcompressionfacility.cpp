@@ -0,0 +1,239 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "sshcompressionfacility_p.h"
+
+#include "ssh_global.h"
+#include "sshcapabilities_p.h"
+#include "sshexception_p.h"
+
+#include <cstring>
+
+namespace QSsh {
+namespace Internal {
+
+namespace {
+
+// Same bound as OpenSSH applies to a single packet; protects against payloads
+// that inflate without limit.
+const int MaxDecompressedPayloadSize = 256 * 1024;
+
+const int CompressionChunkSize = 4096;
+
+} // anonymous namespace
+
+SshAbstractCompressionFacility::SshAbstractCompressionFacility()
+    : m_negotiated(false), m_active(false), m_streamInitialized(false)
+{
+#ifdef DAGGY_ZLIB
+    std::memset(&m_stream, 0, sizeof m_stream);
+#endif
+}
+
+SshAbstractCompressionFacility::~SshAbstractCompressionFacility() {}
+
+void SshAbstractCompressionFacility::reset()
+{
+    destroyStream();
+    m_buffer.clear();
+    m_negotiated = false;
+    m_active = false;
+}
+
+void SshAbstractCompressionFacility::recreate(const QByteArray &algoName)
+{
+    if (algoName == SshCapabilities::CompressionAlgoZlibOpenSsh) {
+        // Re-keying keeps an already running stream.
+        m_negotiated = true;
+        return;
+    }
+    QSSH_ASSERT(algoName == SshCapabilities::CompressionAlgoNone);
+    reset();
+}
+
+void SshAbstractCompressionFacility::enableDelayedCompression()
+{
+    if (!m_negotiated || m_active)
+        return;
+    if (!m_streamInitialized) {
+        initStream();
+        m_streamInitialized = true;
+    }
+    m_active = true;
+}
+
+void SshAbstractCompressionFacility::destroyStream()
+{
+    if (!m_streamInitialized)
+        return;
+    endStream();
+#ifdef DAGGY_ZLIB
+    std::memset(&m_stream, 0, sizeof m_stream);
+#endif
+    m_streamInitialized = false;
+}
+
+#ifdef DAGGY_ZLIB
+void SshAbstractCompressionFacility::throwOnError(int result, const char *what) const
+{
+    if (result == Z_OK)
+        return;
+    throw SshServerException(SSH_DISCONNECT_COMPRESSION_ERROR,
+            QString::fromLatin1("%1 failed: %2").arg(QLatin1String(what),
+                QLatin1String(m_stream.msg ? m_stream.msg : zError(result))).toLatin1(),
+            SSH_TR("Compression error."));
+}
+
+
+SshCompressor::~SshCompressor()
+{
+    reset();
+}
+
+void SshCompressor::initStream()
+{
+    throwOnError(deflateInit(&m_stream, Z_DEFAULT_COMPRESSION), "deflateInit");
+}
+
+void SshCompressor::endStream()
+{
+    deflateEnd(&m_stream);
+}
+
+void SshCompressor::compress(QByteArray &data, int offset)
+{
+    Q_ASSERT(isActive());
+    Q_ASSERT(offset >= 0 && offset <= data.size());
+
+    const int inputSize = data.size() - offset;
+    m_stream.next_in = reinterpret_cast<Bytef *>(data.data() + offset);
+    m_stream.avail_in = static_cast<uInt>(inputSize);
+
+    // Z_PARTIAL_FLUSH makes every packet decompressible on its own, as the
+    // receiver cannot wait for more data.
+    m_buffer.resize(0);
+    do {
+        const int oldSize = m_buffer.size();
+        m_buffer.resize(oldSize + qMax(CompressionChunkSize, inputSize / 2));
+        m_stream.next_out = reinterpret_cast<Bytef *>(m_buffer.data() + oldSize);
+        m_stream.avail_out = static_cast<uInt>(m_buffer.size() - oldSize);
+        throwOnError(deflate(&m_stream, Z_PARTIAL_FLUSH), "deflate");
+        m_buffer.resize(m_buffer.size() - static_cast<int>(m_stream.avail_out));
+    } while (m_stream.avail_out == 0);
+
+    data.resize(offset);
+    data.append(m_buffer);
+}
+
+
+SshDecompressor::~SshDecompressor()
+{
+    reset();
+}
+
+void SshDecompressor::initStream()
+{
+    throwOnError(inflateInit(&m_stream), "inflateInit");
+}
+
+void SshDecompressor::endStream()
+{
+    inflateEnd(&m_stream);
+}
+
+int SshDecompressor::decompress(QByteArray &data, int offset, int size)
+{
+    Q_ASSERT(isActive());
+    Q_ASSERT(offset >= 0 && size >= 0 && offset + size <= data.size());
+
+    m_stream.next_in = reinterpret_cast<Bytef *>(data.data() + offset);
+    m_stream.avail_in = static_cast<uInt>(size);
+
+    m_buffer.resize(0);
+    for (;;) {
+        const int oldSize = m_buffer.size();
+        // Room for one byte over the limit tells a payload of exactly the
+        // limit from a larger one.
+        m_buffer.resize(qMin(oldSize + qMax(CompressionChunkSize, 4 * size),
+                             MaxDecompressedPayloadSize + 1));
+        m_stream.next_out = reinterpret_cast<Bytef *>(m_buffer.data() + oldSize);
+        m_stream.avail_out = static_cast<uInt>(m_buffer.size() - oldSize);
+        const int result = inflate(&m_stream, Z_SYNC_FLUSH);
+        m_buffer.resize(m_buffer.size() - static_cast<int>(m_stream.avail_out));
+        if (m_buffer.size() > MaxDecompressedPayloadSize) {
+            throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_COMPRESSION_ERROR,
+                                       "Decompressed packet too large.");
+        }
+        // Z_BUF_ERROR only means that no progress was possible, i.e. that
+        // all the input has been consumed and flushed.
+        if (result == Z_BUF_ERROR)
+            break;
+        throwOnError(result, "inflate");
+        if (m_stream.avail_in == 0 && m_stream.avail_out != 0)
+            break;
+    }
+
+    data.replace(offset, size, m_buffer);
+    return m_buffer.size();
+}
+
+#else // DAGGY_ZLIB
+
+// zlib@openssh.com is never negotiated without zlib, the streams are not used.
+
+SshCompressor::~SshCompressor()
+{
+    reset();
+}
+
+void SshCompressor::initStream() {}
+
+void SshCompressor::endStream() {}
+
+void SshCompressor::compress(QByteArray &, int)
+{
+    QSSH_ASSERT(false);
+}
+
+
+SshDecompressor::~SshDecompressor()
+{
+    reset();
+}
+
+void SshDecompressor::initStream() {}
+
+void SshDecompressor::endStream() {}
+
+int SshDecompressor::decompress(QByteArray &, int, int size)
+{
+    QSSH_ASSERT(false);
+    return size;
+}
+
+#endif // DAGGY_ZLIB
+
+} // namespace Internal
+} // namespace QSsh
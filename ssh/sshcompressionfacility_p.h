@@ -0,0 +1,106 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+#ifdef DAGGY_ZLIB
+#include <zlib.h>
+#endif
+
+namespace QSsh {
+namespace Internal {
+
+class SshKeyExchange;
+
+/*
+ * Payload compression as negotiated during key exchange. Only
+ * "zlib@openssh.com" is supported: it is negotiated like any other algorithm,
+ * but not switched on before the server has accepted the user authentication.
+ * The zlib stream lives for the whole connection, so that the dictionary built
+ * up by earlier packets keeps paying off; a re-key does not reset it.
+ * Builds without zlib (DAGGY_ZLIB not defined) never offer the algorithm, so
+ * the facilities stay inactive.
+ */
+class SshAbstractCompressionFacility
+{
+public:
+    virtual ~SshAbstractCompressionFacility();
+
+    void reset();
+    void recreate(const QByteArray &algoName);
+    void enableDelayedCompression();
+    bool isActive() const { return m_active; }
+
+protected:
+    SshAbstractCompressionFacility();
+
+#ifdef DAGGY_ZLIB
+    void throwOnError(int result, const char *what) const;
+
+    z_stream m_stream;
+#endif
+    QByteArray m_buffer;
+
+private:
+    virtual void initStream() = 0;
+    virtual void endStream() = 0;
+    void destroyStream();
+
+    bool m_negotiated;
+    bool m_active;
+    bool m_streamInitialized;
+};
+
+class SshCompressor : public SshAbstractCompressionFacility
+{
+public:
+    ~SshCompressor();
+
+    // Replaces everything in data from offset on by its compressed form.
+    void compress(QByteArray &data, int offset);
+
+private:
+    void initStream();
+    void endStream();
+};
+
+class SshDecompressor : public SshAbstractCompressionFacility
+{
+public:
+    ~SshDecompressor();
+
+    // Replaces size bytes of data starting at offset by their decompressed form.
+    // Returns the size of the decompressed data.
+    int decompress(QByteArray &data, int offset, int size);
+
+private:
+    void initStream();
+    void endStream();
+};
+
+} // namespace Internal
+} // namespace QSsh
@@ -28,14 +28,17 @@
 
 #include "sshagent_p.h"
 #include "sshcapabilities_p.h"
+#include "sshchannel_p.h"
 #include "sshchannelmanager_p.h"
 #include "sshcryptofacility_p.h"
+#include "sshcryptojob_p.h"
 #include "sshdirecttcpiptunnel.h"
 #include "sshtcpipforwardserver.h"
 #include "sshexception_p.h"
 #include "sshkeyexchange_p.h"
 #include "sshlogging_p.h"
 #include "sshremoteprocess.h"
+#include "sshtrace.h"
 
 #include <QFile>
 #include <QMutex>
@@ -59,7 +62,9 @@ namespace QSsh {
 const QByteArray ClientId("SSH-2.0-QtCreator\r\n");
 
 SshConnectionParameters::SshConnectionParameters() :
-    timeout(0), authenticationType(AuthenticationTypePublicKey),
+    timeout(0), channelWindowSize(Internal::DefaultChannelWindowSize),
+    channelPacketSize(Internal::DefaultChannelPacketSize),
+    authenticationType(AuthenticationTypePublicKey),
     hostKeyCheckingMode(SshHostKeyCheckingNone)
 {
     url.setPort(0);
@@ -73,7 +78,10 @@ static inline bool equals(const SshConnectionParameters &p1, const SshConnection
             && p1.authenticationType == p2.authenticationType
             && p1.privateKeyFile == p2.privateKeyFile
             && p1.hostKeyCheckingMode == p2.hostKeyCheckingMode
-            && p1.timeout == p2.timeout;
+            && p1.options == p2.options
+            && p1.timeout == p2.timeout
+            && p1.channelWindowSize == p2.channelWindowSize
+            && p1.channelPacketSize == p2.channelPacketSize;
 }
 
 bool operator==(const SshConnectionParameters &p1, const SshConnectionParameters &p2)
@@ -191,15 +199,22 @@ int SshConnection::channelCount() const
     return d->m_channelManager->channelCount();
 }
 
+SshWriteStatistics SshConnection::writeStatistics() const
+{
+    return d->m_sendFacility.statistics();
+}
+
 namespace Internal {
 
 SshConnectionPrivate::SshConnectionPrivate(SshConnection *conn,
     const SshConnectionParameters &serverInfo)
     : m_socket(new QTcpSocket(this)), m_state(SocketUnconnected),
       m_sendFacility(m_socket),
-      m_channelManager(new SshChannelManager(m_sendFacility, this)),
+      m_channelManager(new SshChannelManager(m_sendFacility,
+          SshChannelWindowParameters(serverInfo.channelWindowSize, serverInfo.channelPacketSize,
+                                     serverInfo.options.testFlag(SshAdaptiveChannelWindow)), this)),
       m_connParams(serverInfo), m_error(SshNoError), m_ignoreNextPacket(false),
-      m_conn(conn)
+      m_conn(conn), m_cryptoJobPending(false), m_cryptoJobId(0)
 {
     setupPacketHandlers();
     m_socket->setProxy((m_connParams.options & SshIgnoreDefaultProxy)
@@ -312,14 +327,21 @@ void SshConnectionPrivate::handleIncomingData()
     if (m_state == SocketUnconnected)
         return; // For stuff queued in the event loop after we've called closeConnection();
 
-    try {
+    runPacketHandling([this] {
         if (!canUseSocket())
             return;
-        m_incomingData += m_socket->readAll();
-        qCDebug(sshLog, "state = %d, remote data size = %d", m_state, m_incomingData.count());
+        m_incomingData.readFrom(m_socket);
+        qCDebug(sshLog, "state = %d, remote data size = %d", m_state, m_incomingData.size());
         if (m_serverId.isEmpty())
             handleServerId();
         handlePackets();
+    });
+}
+
+void SshConnectionPrivate::runPacketHandling(const std::function<void()> &handling)
+{
+    try {
+        handling();
     } catch (const SshServerException &e) {
         closeConnection(e.error, SshProtocolError, e.errorStringServer,
             tr("SSH Protocol error: %1").arg(e.errorStringUser));
@@ -335,15 +357,16 @@ void SshConnectionPrivate::handleIncomingData()
 // RFC 4253, 4.2.
 void SshConnectionPrivate::handleServerId()
 {
+    const QByteArray &incomingData = m_incomingData.peek();
     qCDebug(sshLog, "%s: incoming data size = %d, incoming data = '%s'",
-        Q_FUNC_INFO, m_incomingData.count(), m_incomingData.data());
-    const int newLinePos = m_incomingData.indexOf('\n');
+        Q_FUNC_INFO, incomingData.count(), QByteArray(incomingData.constData(), incomingData.size()).constData());
+    const int newLinePos = incomingData.indexOf('\n');
     if (newLinePos == -1)
         return; // Not enough data yet.
 
     // Lines not starting with "SSH-" are ignored.
-    if (!m_incomingData.startsWith("SSH-")) {
-        m_incomingData.remove(0, newLinePos + 1);
+    if (!incomingData.startsWith("SSH-")) {
+        m_incomingData.consume(newLinePos + 1);
         m_serverHasSentDataBeforeId = true;
         return;
     }
@@ -355,11 +378,11 @@ void SshConnectionPrivate::handleServerId()
                "allowed length is 255.", 0, newLinePos + 1));
     }
 
-    const bool hasCarriageReturn = m_incomingData.at(newLinePos - 1) == '\r';
-    m_serverId = m_incomingData.left(newLinePos);
+    const bool hasCarriageReturn = incomingData.at(newLinePos - 1) == '\r';
+    m_serverId = QByteArray(incomingData.constData(), newLinePos);
     if (hasCarriageReturn)
         m_serverId.chop(1);
-    m_incomingData.remove(0, newLinePos + 1);
+    m_incomingData.consume(newLinePos + 1);
 
     if (m_serverId.contains('\0')) {
         throw SshServerException(SSH_DISCONNECT_PROTOCOL_ERROR,
@@ -407,16 +430,43 @@ void SshConnectionPrivate::handleServerId()
 
 void SshConnectionPrivate::handlePackets()
 {
+    // Packets following one whose handling is offloaded may depend on its outcome
+    // (e.g. they are encrypted with the keys being computed), so they stay queued.
+    if (m_cryptoJobPending)
+        return;
+    QSSH_TRACE_SCOPE("SshConnectionPrivate::handlePackets");
     m_incomingPacket.consumeData(m_incomingData);
     while (m_incomingPacket.isComplete()) {
         handleCurrentPacket();
         m_incomingPacket.clear();
+        if (m_cryptoJobPending)
+            return;
         m_incomingPacket.consumeData(m_incomingData);
     }
 }
 
+void SshConnectionPrivate::startCryptoJob(const std::function<void()> &work,
+                                          const std::function<void()> &finish)
+{
+    QSSH_ASSERT_AND_RETURN(!m_cryptoJobPending);
+    m_cryptoJobPending = true;
+    const quint64 jobId = ++m_cryptoJobId;
+    SshCryptoJob::start(this, work, [this, jobId, finish](std::exception_ptr error) {
+        if (jobId != m_cryptoJobId)
+            return; // Connection was closed or restarted in the meantime.
+        m_cryptoJobPending = false;
+        runPacketHandling([this, error, finish] {
+            if (error)
+                std::rethrow_exception(error);
+            finish();
+            handlePackets();
+        });
+    });
+}
+
 void SshConnectionPrivate::handleCurrentPacket()
 {
+    QSSH_TRACE_SCOPE("SshConnectionPrivate::handleCurrentPacket");
     Q_ASSERT(m_incomingPacket.isComplete());
     Q_ASSERT(m_keyExchangeState == DhInitSent || !m_ignoreNextPacket);
 
@@ -470,10 +520,18 @@ void SshConnectionPrivate::handleKeyExchangeReplyPacket()
             .arg(m_incomingPacket.type()));
     }
 
-    m_keyExchange->sendNewKeysPacket(m_incomingPacket,
-        ClientId.left(ClientId.size() - 2));
-    m_sendFacility.recreateKeys(*m_keyExchange);
-    m_keyExchangeState = NewKeysSent;
+    // Computing the shared secret and verifying the host's signature is the most
+    // expensive part of connecting, so it does not run in the connection's thread.
+    m_keyExchange->readKeyExchangeReply(m_incomingPacket);
+    const QSharedPointer<SshKeyExchange> keyExchange = m_keyExchange;
+    const QByteArray clientId = ClientId.left(ClientId.size() - 2);
+    startCryptoJob([keyExchange, clientId] { keyExchange->computeSessionKeys(clientId); },
+                   [this, keyExchange] {
+        QSSH_ASSERT_AND_RETURN(keyExchange == m_keyExchange);
+        m_keyExchange->sendNewKeysPacket();
+        m_sendFacility.recreateKeys(*m_keyExchange);
+        m_keyExchangeState = NewKeysSent;
+    });
 }
 
 void SshConnectionPrivate::handleNewKeysPacket()
@@ -580,6 +638,9 @@ void SshConnectionPrivate::handleUserAuthSuccessPacket()
 {
     m_state = ConnectionEstablished;
     m_timeoutTimer.stop();
+    // zlib@openssh.com: both directions are compressed from the next packet on.
+    m_incomingPacket.enableDelayedCompression();
+    m_sendFacility.enableDelayedCompression();
     emit connected();
     m_lastInvalidMsgSeqNr = InvalidSeqNr;
     connect(&m_keepAliveTimer, &QTimer::timeout, this, &SshConnectionPrivate::sendKeepAlivePacket);
@@ -830,18 +891,26 @@ void SshConnectionPrivate::authenticateWithPublicKey()
 {
     qCDebug(sshLog) << "sending actual authentication request";
 
-    QByteArray key;
-    QByteArray signature;
+    const QByteArray user = m_connParams.userName().toUtf8();
+    const QByteArray service = SshCapabilities::SshConnectionService;
     if (m_connParams.authenticationType == SshConnectionParameters::AuthenticationTypeAgent) {
         // Agent is not needed anymore after this point.
         disconnect(&SshAgent::instance(), 0, this, 0);
 
-        key = m_agentKeyToUse;
-        signature = m_agentSignature;
+        m_sendFacility.sendUserAuthByPublicKeyRequestPacket(user, service, m_agentKeyToUse,
+                                                            m_agentSignature);
+        return;
     }
 
-    m_sendFacility.sendUserAuthByPublicKeyRequestPacket(m_connParams.userName().toUtf8(),
-            SshCapabilities::SshConnectionService, key, signature);
+    // Private key operations (RSA in particular) are slow, sign on the crypto thread pool.
+    const std::function<QByteArray()> signer = m_sendFacility.userAuthByPublicKeySigner(user,
+                                                                                        service);
+    const QSharedPointer<QByteArray> signature(new QByteArray);
+    startCryptoJob([signer, signature] { *signature = signer(); },
+                   [this, user, service, signature] {
+        m_sendFacility.sendUserAuthByPublicKeyRequestPacket(user, service,
+                m_sendFacility.authenticationPublicKey(), *signature);
+    });
 }
 
 void SshConnectionPrivate::setAgentError()
@@ -858,6 +927,7 @@ void SshConnectionPrivate::connectToHost()
     m_incomingData.clear();
     m_incomingPacket.reset();
     m_sendFacility.reset();
+    m_sendFacility.setCoalesceWrites(m_connParams.options.testFlag(SshCoalesceWrites));
     m_error = SshNoError;
     m_ignoreNextPacket = false;
     m_errorString.clear();
@@ -867,6 +937,8 @@ void SshConnectionPrivate::connectToHost()
     m_agentKeysUpToDate = false;
     m_pendingKeyChecks.clear();
     m_agentKeyToUse.clear();
+    m_cryptoJobPending = false;
+    ++m_cryptoJobId;
 
     switch (m_connParams.authenticationType) {
     case SshConnectionParameters::AuthenticationTypePublicKey:
@@ -922,6 +994,8 @@ void SshConnectionPrivate::closeConnection(SshErrorCode sshError,
 
     m_error = userError;
     m_errorString = userErrorString;
+    m_cryptoJobPending = false;
+    ++m_cryptoJobId;
     m_timeoutTimer.stop();
     disconnect(m_socket, 0, this, 0);
     disconnect(&m_timeoutTimer, 0, this, 0);
@@ -933,6 +1007,10 @@ void SshConnectionPrivate::closeConnection(SshErrorCode sshError,
             m_sendFacility.sendDisconnectPacket(sshError, serverErrorString);
         } catch (...) {}  // Nothing sensible to be done here.
     }
+    const SshWriteStatistics &statistics = m_sendFacility.statistics();
+    qCDebug(sshLog, "Sent %llu packets in %llu socket writes (%.1f packets per write), "
+            "%.1f socket flushes per second", statistics.packets, statistics.socketWrites,
+            statistics.packetsPerWrite(), statistics.flushesPerSecond());
     if (m_error != SshNoError)
         emit error(userError);
     if (m_state == ConnectionEstablished)
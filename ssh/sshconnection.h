@@ -48,7 +48,10 @@ namespace Internal { class SshConnectionPrivate; }
 
 enum SshConnectionOption {
     SshIgnoreDefaultProxy = 0x1,
-    SshEnableStrictConformanceChecks = 0x2
+    SshEnableStrictConformanceChecks = 0x2,
+    SshEnableCompression = 0x4, // Offers zlib@openssh.com to the server.
+    SshAdaptiveChannelWindow = 0x8, // Grows channel windows up to the measured bandwidth-delay product.
+    SshCoalesceWrites = 0x10 // Packets sent in one event loop iteration are written to the socket at once.
 };
 
 Q_DECLARE_FLAGS(SshConnectionOptions, SshConnectionOption)
@@ -88,6 +91,8 @@ public:
     QUrl url;
     QString privateKeyFile;
     int timeout; // In seconds.
+    quint32 channelWindowSize; // Initial local window of each channel, in bytes.
+    quint32 channelPacketSize; // Maximum packet size announced for each channel, in bytes.
     AuthenticationType authenticationType;
     SshConnectionOptions options;
     SshHostKeyCheckingMode hostKeyCheckingMode;
@@ -110,6 +115,21 @@ public:
     quint16 peerPort;
 };
 
+class QSSH_EXPORT SshWriteStatistics
+{
+public:
+    SshWriteStatistics() : packets(0), socketWrites(0), socketFlushes(0), bytes(0), elapsedMs(0) {}
+
+    double packetsPerWrite() const { return socketWrites ? double(packets) / socketWrites : 0; }
+    double flushesPerSecond() const { return elapsedMs ? socketFlushes * 1000.0 / elapsedMs : 0; }
+
+    quint64 packets;       // SSH packets sent.
+    quint64 socketWrites;  // QTcpSocket::write() calls.
+    quint64 socketFlushes; // Writes of the socket buffer to the system, as reported by bytesWritten().
+    quint64 bytes;
+    qint64 elapsedMs;      // Since the connection was started.
+};
+
 class QSSH_EXPORT SshConnection : public QObject
 {
     Q_OBJECT
@@ -138,6 +158,7 @@ public:
     int closeAllChannels();
 
     int channelCount() const;
+    SshWriteStatistics writeStatistics() const;
 
 signals:
     void connected();
@@ -36,8 +36,12 @@
 #include <QObject>
 #include <QPair>
 #include <QScopedPointer>
+#include <QSharedPointer>
 #include <QTimer>
 
+#include <exception>
+#include <functional>
+
 QT_BEGIN_NAMESPACE
 class QTcpSocket;
 QT_END_NAMESPACE
@@ -104,6 +108,8 @@ signals:
 private:
     void handleSocketConnected();
     void handleIncomingData();
+    void runPacketHandling(const std::function<void()> &handling);
+    void startCryptoJob(const std::function<void()> &work, const std::function<void()> &finish);
     void handleSocketError();
     void handleSocketDisconnected();
     void handleTimeout();
@@ -172,10 +178,10 @@ private:
     SshSendFacility m_sendFacility;
     SshChannelManager * const m_channelManager;
     const SshConnectionParameters m_connParams;
-    QByteArray m_incomingData;
+    SshIncomingBuffer m_incomingData;
     SshError m_error;
     QString m_errorString;
-    QScopedPointer<SshKeyExchange> m_keyExchange;
+    QSharedPointer<SshKeyExchange> m_keyExchange;
     QTimer m_timeoutTimer;
     QTimer m_keepAliveTimer;
     bool m_ignoreNextPacket;
@@ -188,6 +194,8 @@ private:
     bool m_serverHasSentDataBeforeId;
     bool m_triedAllPasswordBasedMethods;
     bool m_agentKeysUpToDate;
+    bool m_cryptoJobPending; // Packet handling is suspended until the job has finished.
+    quint64 m_cryptoJobId;
 };
 
 } // namespace Internal
@@ -166,6 +166,12 @@ public:
         }
     }
 
+    int connectionUsers(const SshConnection *connection)
+    {
+        QMutexLocker locker(&m_listMutex);
+        return m_acquiredConnections.count(const_cast<SshConnection *>(connection));
+    }
+
     void forceNewConnection(const SshConnectionParameters &sshParams)
     {
         QMutexLocker locker(&m_listMutex);
@@ -259,6 +265,12 @@ void releaseConnection(SshConnection *connection)
     instance().releaseConnection(connection);
 }
 
+int connectionUsers(const SshConnection *connection)
+{
+    QMutexLocker locker(&instanceMutex);
+    return instance().connectionUsers(connection);
+}
+
 void forceNewConnection(const SshConnectionParameters &sshParams)
 {
     QMutexLocker locker(&instanceMutex);
@@ -35,6 +35,9 @@ class SshConnectionParameters;
 QSSH_EXPORT SshConnection *acquireConnection(const SshConnectionParameters &sshParams);
 QSSH_EXPORT void releaseConnection(SshConnection *connection);
 
+// Number of acquireConnection() calls for the connection that have not been released yet.
+QSSH_EXPORT int connectionUsers(const SshConnection *connection);
+
 // Make sure the next acquireConnection with the given parameters will return a new connection.
 QSSH_EXPORT void forceNewConnection(const SshConnectionParameters &sshParams);
 
@@ -25,17 +25,22 @@
 
 #pragma once
 
+#include <botan/aead.h>
 #include <botan/auto_rng.h>
 #include <botan/bigint.h>
 #include <botan/block_cipher.h>
+#include <botan/cipher_mode.h>
 #include <botan/hmac.h>
-#include <botan/key_filt.h>
-#include <botan/pipe.h>
+#include <botan/mac.h>
 #include <botan/pk_keys.h>
-#include <botan/filters.h>
+#include <botan/stream_cipher.h>
+#include <botan/symkey.h>
 
 #include <QByteArray>
 #include <QScopedPointer>
+#include <QSharedPointer>
+
+#include <functional>
 
 namespace QSsh {
 namespace Internal {
@@ -50,17 +55,32 @@ public:
     void clearKeys();
     void recreateKeys(const SshKeyExchange &kex);
     QByteArray generateMac(const QByteArray &data, quint32 dataSize) const;
+    QByteArray generateMac(quint32 seqNr, const QByteArray &data, quint32 dataSize) const;
     quint32 cipherBlockSize() const { return m_cipherBlockSize; }
     quint32 macLength() const { return m_macLength; }
     QByteArray sessionId() const { return m_sessionId; }
 
+    /*
+     * AEAD ciphers authenticate the packet themselves: no separate MAC is
+     * computed and the packet length field is not part of the encrypted blocks.
+     */
+    bool isAead() const { return m_aead; }
+
 protected:
-    enum Mode { CbcMode, CtrMode };
+    enum Mode { CbcMode, CtrMode, GcmMode, ChaCha20Poly1305Mode };
+
+    static const quint32 AeadLengthFieldSize = 4;
 
     SshAbstractCryptoFacility();
     void convert(QByteArray &data, quint32 offset, quint32 dataSize) const;
-    Botan::Keyed_Filter *makeCtrCipherMode(Botan::BlockCipher *cipher,
-        const Botan::InitializationVector &iv, const Botan::SymmetricKey &key);
+    Botan::Cipher_Mode *makeCtrCipherMode(Botan::BlockCipher *cipher);
+
+    void processGcmPacket(QByteArray &data, quint32 dataSize) const;
+    void cryptChaCha20Poly1305Length(const char *input, char *output, quint32 seqNr) const;
+    void startChaCha20Poly1305Payload(quint32 seqNr) const;
+    void cryptChaCha20Poly1305Payload(char *data, quint32 dataSize) const;
+    void generateChaCha20Poly1305Tag(const char *data, quint32 dataSize, char *tag) const;
+    Mode mode() const { return m_mode; }
 
 private:
     SshAbstractCryptoFacility(const SshAbstractCryptoFacility &);
@@ -68,32 +88,51 @@ private:
 
     virtual QByteArray cryptAlgoName(const SshKeyExchange &kex) const = 0;
     virtual QByteArray hMacAlgoName(const SshKeyExchange &kex) const = 0;
-    virtual Botan::Keyed_Filter *makeCipherMode(Botan::BlockCipher *cipher,
-        Mode mode, const Botan::InitializationVector &iv, const Botan::SymmetricKey &key) = 0;
+    virtual Botan::Cipher_Mode *makeCipherMode(Botan::BlockCipher *cipher, Mode mode) = 0;
+    virtual Botan::Cipher_Dir cipherDirection() const = 0;
     virtual char ivChar() const = 0;
     virtual char keyChar() const = 0;
     virtual char macChar() const = 0;
 
+    void createGcmKeys(const SshKeyExchange &kex, const QByteArray &rfcCryptAlgoName);
+    void createChaCha20Poly1305Keys(const SshKeyExchange &kex);
     QByteArray generateHash(const SshKeyExchange &kex, char c, quint32 length);
     void checkInvariant() const;
     static Mode getMode(const QByteArray &algoName);
 
     QByteArray m_sessionId;
-    QScopedPointer<Botan::Pipe> m_pipe;
+    // CBC and CTR modes; processed in place, the mode keeps its state between packets.
+    std::unique_ptr<Botan::Cipher_Mode> m_cipherMode;
     QScopedPointer<Botan::HMAC> m_hMac;
     quint32 m_cipherBlockSize;
     quint32 m_macLength;
+    Mode m_mode;
+    bool m_aead;
+
+    // aes*-gcm@openssh.com (RFC 5647)
+    std::unique_ptr<Botan::AEAD_Mode> m_gcm;
+    mutable QByteArray m_gcmNonce;
+    mutable Botan::secure_vector<Botan::byte> m_gcmFinalBlock;
+
+    // chacha20-poly1305@openssh.com
+    std::unique_ptr<Botan::StreamCipher> m_lengthCipher;
+    std::unique_ptr<Botan::StreamCipher> m_payloadCipher;
+    std::unique_ptr<Botan::MessageAuthenticationCode> m_poly1305;
 };
 
 class SshEncryptionFacility : public SshAbstractCryptoFacility
 {
 public:
     void encrypt(QByteArray &data) const;
+    void encryptAead(QByteArray &data, quint32 seqNr) const;
 
     void createAuthenticationKey(const QByteArray &privKeyFileContents);
     QByteArray authenticationAlgorithmName() const;
     QByteArray authenticationPublicKey() const { return m_authPubKeyBlob; }
     QByteArray authenticationKeySignature(const QByteArray &data) const;
+
+    // Returns a self-contained signing operation that may run on any thread.
+    std::function<QByteArray()> authenticationKeySigner(const QByteArray &data) const;
     QByteArray getRandomNumbers(int count) const;
 
     ~SshEncryptionFacility();
@@ -101,8 +140,8 @@ public:
 private:
     virtual QByteArray cryptAlgoName(const SshKeyExchange &kex) const;
     virtual QByteArray hMacAlgoName(const SshKeyExchange &kex) const;
-    virtual Botan::Keyed_Filter *makeCipherMode(Botan::BlockCipher *cipher,
-        Mode mode, const Botan::InitializationVector &iv, const Botan::SymmetricKey &key);
+    virtual Botan::Cipher_Mode *makeCipherMode(Botan::BlockCipher *cipher, Mode mode);
+    virtual Botan::Cipher_Dir cipherDirection() const { return Botan::ENCRYPTION; }
     virtual char ivChar() const { return 'A'; }
     virtual char keyChar() const { return 'C'; }
     virtual char macChar() const { return 'E'; }
@@ -111,6 +150,10 @@ private:
         QList<Botan::BigInt> &pubKeyParams, QList<Botan::BigInt> &allKeyParams, QString &error);
     bool createAuthenticationKeyFromOpenSSL(const QByteArray &privKeyFileContents,
         QList<Botan::BigInt> &pubKeyParams, QList<Botan::BigInt> &allKeyParams, QString &error);
+    bool createAuthenticationKeyFromOpenSsh(const QByteArray &privKeyFileContents,
+        QList<Botan::BigInt> &pubKeyParams, QList<Botan::BigInt> &allKeyParams, QString &error);
+    void decryptOpenSshPrivateKey(QByteArray &privateSection, const QByteArray &cipherName,
+        const QByteArray &kdfName, const QByteArray &kdfOptions);
 
     static const QByteArray PrivKeyFileStartLineRsa;
     static const QByteArray PrivKeyFileStartLineDsa;
@@ -118,11 +161,13 @@ private:
     static const QByteArray PrivKeyFileEndLineDsa;
     static const QByteArray PrivKeyFileStartLineEcdsa;
     static const QByteArray PrivKeyFileEndLineEcdsa;
+    static const QByteArray PrivKeyFileStartLineOpenSsh;
+    static const QByteArray PrivKeyFileEndLineOpenSsh;
 
     QByteArray m_authKeyAlgoName;
     QByteArray m_authPubKeyBlob;
     QByteArray m_cachedPrivKeyContents;
-    QScopedPointer<Botan::Private_Key> m_authKey;
+    QSharedPointer<Botan::Private_Key> m_authKey;
     mutable Botan::AutoSeeded_RNG m_rng;
 };
 
@@ -130,12 +175,14 @@ class SshDecryptionFacility : public SshAbstractCryptoFacility
 {
 public:
     void decrypt(QByteArray &data, quint32 offset, quint32 dataSize) const;
+    quint32 aeadPacketLength(const QByteArray &data, quint32 seqNr) const;
+    void decryptAead(QByteArray &data, quint32 seqNr) const;
 
 private:
     virtual QByteArray cryptAlgoName(const SshKeyExchange &kex) const;
     virtual QByteArray hMacAlgoName(const SshKeyExchange &kex) const;
-    virtual Botan::Keyed_Filter *makeCipherMode(Botan::BlockCipher *cipher,
-        Mode mode, const Botan::InitializationVector &iv, const Botan::SymmetricKey &key);
+    virtual Botan::Cipher_Mode *makeCipherMode(Botan::BlockCipher *cipher, Mode mode);
+    virtual Botan::Cipher_Dir cipherDirection() const { return Botan::DECRYPTION; }
     virtual char ivChar() const { return 'B'; }
     virtual char keyChar() const { return 'D'; }
     virtual char macChar() const { return 'F'; }
@@ -0,0 +1,60 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "sshcryptojob_p.h"
+
+#include <QThreadPool>
+
+namespace QSsh {
+namespace Internal {
+
+Q_GLOBAL_STATIC(QThreadPool, cryptoThreadPool)
+
+SshCryptoJob::SshCryptoJob(const Work &work) : m_work(work)
+{
+    setAutoDelete(false); // Deleted in its own thread once finished() has been delivered.
+}
+
+void SshCryptoJob::start(QObject *context, const Work &work, const Finish &finish)
+{
+    SshCryptoJob * const job = new SshCryptoJob(work);
+    job->moveToThread(context->thread());
+    connect(job, &SshCryptoJob::finished, context, [job, finish] { finish(job->m_error); });
+    connect(job, &SshCryptoJob::finished, job, &QObject::deleteLater);
+    cryptoThreadPool()->start(job);
+}
+
+void SshCryptoJob::run()
+{
+    try {
+        m_work();
+    } catch (...) {
+        m_error = std::current_exception();
+    }
+    emit finished();
+}
+
+} // namespace Internal
+} // namespace QSsh
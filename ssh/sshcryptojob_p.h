@@ -0,0 +1,64 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QObject>
+#include <QRunnable>
+
+#include <exception>
+#include <functional>
+
+namespace QSsh {
+namespace Internal {
+
+// Runs the CPU heavy steps of key exchange and public key authentication on a thread pool
+// shared by all connections, so that a reconnect storm does not stall the threads that
+// deliver channel data.
+class SshCryptoJob : public QObject, public QRunnable
+{
+    Q_OBJECT
+public:
+    typedef std::function<void()> Work;
+    typedef std::function<void(std::exception_ptr)> Finish;
+
+    // work runs on the pool and must not touch objects owned by context. finish runs in
+    // context's thread with the exception thrown by work, if any. It is not called if
+    // context has been destroyed in the meantime.
+    static void start(QObject *context, const Work &work, const Finish &finish);
+
+signals:
+    void finished();
+
+private:
+    explicit SshCryptoJob(const Work &work);
+    void run() override;
+
+    const Work m_work;
+    std::exception_ptr m_error;
+};
+
+} // namespace Internal
+} // namespace QSsh
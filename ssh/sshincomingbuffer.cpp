@@ -0,0 +1,72 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "sshincomingbuffer_p.h"
+
+#include "ssh_global.h"
+
+#include <QIODevice>
+
+namespace QSsh {
+namespace Internal {
+
+qint64 SshIncomingBuffer::readFrom(QIODevice *device)
+{
+    const qint64 available = device->bytesAvailable();
+    if (available <= 0)
+        return 0;
+
+    compact();
+    const int oldSize = m_data.size();
+    m_data.resize(oldSize + static_cast<int>(available));
+    const qint64 bytesRead = device->read(m_data.data() + oldSize, available);
+    m_data.resize(oldSize + static_cast<int>(qMax<qint64>(bytesRead, 0)));
+    return bytesRead;
+}
+
+void SshIncomingBuffer::consume(int count)
+{
+    QSSH_ASSERT_AND_RETURN(count >= 0 && count <= size());
+    m_readPos += count;
+    if (m_readPos == m_data.size())
+        clear();
+}
+
+void SshIncomingBuffer::clear()
+{
+    m_data.clear();
+    m_readPos = 0;
+}
+
+void SshIncomingBuffer::compact()
+{
+    if (m_readPos == 0 || m_readPos < m_data.size() - m_readPos)
+        return;
+    m_data.remove(0, m_readPos);
+    m_readPos = 0;
+}
+
+} // namespace Internal
+} // namespace QSsh
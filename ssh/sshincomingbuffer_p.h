@@ -0,0 +1,67 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include <QByteArray>
+
+QT_BEGIN_NAMESPACE
+class QIODevice;
+QT_END_NAMESPACE
+
+namespace QSsh {
+namespace Internal {
+
+/*
+ * Receive buffer with a read cursor. Consuming data only advances the cursor;
+ * the already consumed prefix is dropped when it makes up at least half of the
+ * buffer, so every byte is moved at most a constant number of times no matter
+ * how many packets a single read contains.
+ */
+class SshIncomingBuffer
+{
+public:
+    SshIncomingBuffer() : m_readPos(0) { }
+
+    qint64 readFrom(QIODevice *device);
+    void consume(int count);
+    void clear();
+
+    const char *data() const { return m_data.constData() + m_readPos; }
+    int size() const { return m_data.size() - m_readPos; }
+    bool isEmpty() const { return size() == 0; }
+
+    // Unconsumed data without copying; valid until the buffer is modified.
+    QByteArray peek() const { return QByteArray::fromRawData(data(), size()); }
+
+private:
+    void compact();
+
+    QByteArray m_data;
+    int m_readPos;
+};
+
+} // namespace Internal
+} // namespace QSsh
@@ -28,7 +28,13 @@
 #include "ssh_global.h"
 #include "sshbotanconversions_p.h"
 #include "sshcapabilities_p.h"
+#include "sshkeyexchange_p.h"
 #include "sshlogging_p.h"
+#include "sshtrace.h"
+
+#include <botan/mem_ops.h>
+
+#include <cstring>
 
 namespace QSsh {
 namespace Internal {
@@ -52,6 +58,12 @@ quint32 SshIncomingPacket::macLength() const
 void SshIncomingPacket::recreateKeys(const SshKeyExchange &keyExchange)
 {
     m_decrypter.recreateKeys(keyExchange);
+    m_decompressor.recreate(keyExchange.compressionAlgoServerToClient());
+}
+
+void SshIncomingPacket::enableDelayedCompression()
+{
+    m_decompressor.enableDelayedCompression();
 }
 
 void SshIncomingPacket::reset()
@@ -59,9 +71,10 @@ void SshIncomingPacket::reset()
     clear();
     m_serverSeqNr = 0;
     m_decrypter.clearKeys();
+    m_decompressor.reset();
 }
 
-void SshIncomingPacket::consumeData(QByteArray &newData)
+void SshIncomingPacket::consumeData(SshIncomingBuffer &newData)
 {
     qCDebug(sshLog, "%s: current data size = %d, new data size = %d",
         Q_FUNC_INFO, m_data.size(), newData.size());
@@ -77,46 +90,73 @@ void SshIncomingPacket::consumeData(QByteArray &newData)
     if (currentDataSize() < minSize) {
         const int bytesToTake
             = qMin<quint32>(minSize - currentDataSize(), newData.size());
-        moveFirstBytes(m_data, newData, bytesToTake);
+        takeFirstBytes(newData, bytesToTake);
         qCDebug(sshLog, "Took %d bytes from new data", bytesToTake);
         if (currentDataSize() < minSize)
             return;
     }
 
-    if (4 + length() + macLength() < currentDataSize())
+    // The length is not authenticated yet, bound it before allocating anything.
+    if (length() > MaxIncomingPacketLength)
+        throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_PROTOCOL_ERROR, "Server sent packet that is too large.");
+    const quint32 packetSize = 4 + length() + macLength();
+    if (packetSize < currentDataSize())
         throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_PROTOCOL_ERROR, "Server sent invalid packet.");
 
+    // Grow the packet buffer once; the reservation also survives clear().
+    m_data.reserve(packetSize);
     const int bytesToTake
-        = qMin<quint32>(length() + 4 + macLength() - currentDataSize(),
-              newData.size());
-    moveFirstBytes(m_data, newData, bytesToTake);
+        = qMin<quint32>(packetSize - currentDataSize(), newData.size());
+    takeFirstBytes(newData, bytesToTake);
     qCDebug(sshLog, "Took %d bytes from new data", bytesToTake);
     if (isComplete()) {
         qCDebug(sshLog, "Message complete. Overall size: %u, payload size: %u",
             m_data.size(), m_length - paddingLength() - 1);
         decrypt();
+        if (m_decompressor.isActive())
+            decompress();
         ++m_serverSeqNr;
     }
 }
 
 void SshIncomingPacket::decrypt()
 {
+    QSSH_TRACE_SCOPE("SshIncomingPacket::decrypt");
     Q_ASSERT(isComplete());
+    if (m_decrypter.isAead()) {
+        m_decrypter.decryptAead(m_data, m_serverSeqNr);
+        return;
+    }
     const quint32 netDataLength = length() + 4;
     m_decrypter.decrypt(m_data, cipherBlockSize(),
         netDataLength - cipherBlockSize());
-    const QByteArray &mac = m_data.mid(netDataLength, macLength());
-    if (mac != generateMac(m_decrypter, m_serverSeqNr)) {
+    const QByteArray &mac = generateMac(m_decrypter, m_serverSeqNr);
+    if (static_cast<quint32>(mac.size()) != macLength()
+            || !Botan::constant_time_compare(
+                reinterpret_cast<const Botan::byte *>(m_data.constData()) + netDataLength,
+                reinterpret_cast<const Botan::byte *>(mac.constData()), macLength())) {
         throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_MAC_ERROR,
                            "Message authentication failed.");
     }
 }
 
-void SshIncomingPacket::moveFirstBytes(QByteArray &target, QByteArray &source,
-    int n)
+void SshIncomingPacket::decompress()
 {
-    target.append(source.left(n));
-    source.remove(0, n);
+    // Swaps the compressed payload for the plain one, keeping padding and MAC
+    // behind it, so that the packet stays complete with the adjusted length.
+    const int payloadSize = static_cast<int>(length()) - paddingLength() - 1;
+    if (payloadSize < 0)
+        throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_PROTOCOL_ERROR, "Server sent invalid packet.");
+    const int decompressedSize = m_decompressor.decompress(m_data, PayloadOffset, payloadSize);
+    m_length = length() - payloadSize + decompressedSize;
+    const quint32 lengthBe = qToBigEndian(m_length);
+    std::memcpy(m_data.data(), &lengthBe, sizeof lengthBe);
+}
+
+void SshIncomingPacket::takeFirstBytes(SshIncomingBuffer &source, int n)
+{
+    m_data.append(source.data(), n);
+    source.consume(n);
 }
 
 SshKeyExchangeInit SshIncomingPacket::extractKeyExchangeInitData() const
@@ -173,6 +213,8 @@ static void getHostKeySpecificReplyData(SshKeyExchangeReply &replyData,
             replyData.hostKeyParameters << SshPacketParser::asBigInt(input, &offset);
             replyData.hostKeyParameters << SshPacketParser::asBigInt(input, &offset);
         }
+    } else if (hostKeyAlgo == SshCapabilities::PubKeyEd25519) {
+        replyData.q = SshPacketParser::asString(input, &offset);
     } else {
         QSSH_ASSERT_AND_RETURN(hostKeyAlgo.startsWith(SshCapabilities::PubKeyEcdsaPrefix));
         if (SshPacketParser::asString(input, &offset)
@@ -203,10 +245,12 @@ SshKeyExchangeReply SshIncomingPacket::extractKeyExchangeReply(const QByteArray
             throw SshPacketParseException();
         getHostKeySpecificReplyData(replyData, hostKeyAlgo, replyData.k_s.mid(k_sOffset));
 
-        if (kexAlgo == SshCapabilities::DiffieHellmanGroup1Sha1) {
+        if (kexAlgo == SshCapabilities::DiffieHellmanGroup1Sha1
+                || kexAlgo == SshCapabilities::DiffieHellmanGroup14Sha1) {
             replyData.f = SshPacketParser::asBigInt(m_data, &topLevelOffset);
         } else {
-            QSSH_ASSERT_AND_RETURN_VALUE(kexAlgo.startsWith(SshCapabilities::EcdhKexNamePrefix),
+            QSSH_ASSERT_AND_RETURN_VALUE(kexAlgo.startsWith(SshCapabilities::EcdhKexNamePrefix)
+                                         || SshCapabilities::isCurve25519KexAlgo(kexAlgo),
                                          SshKeyExchangeReply());
             replyData.q_s = SshPacketParser::asString(m_data, &topLevelOffset);
         }
@@ -556,6 +600,11 @@ QByteArray SshIncomingPacket::extractChannelRequestType() const
 void SshIncomingPacket::calculateLength() const
 {
     Q_ASSERT(currentDataSize() >= minPacketSize());
+    if (m_decrypter.isAead()) {
+        m_length = m_decrypter.aeadPacketLength(m_data, m_serverSeqNr);
+        qCDebug(sshLog, "decrypted length is %u", m_length);
+        return;
+    }
     qCDebug(sshLog, "Length field before decryption: %d-%d-%d-%d", m_data.at(0) & 0xff,
         m_data.at(1) & 0xff, m_data.at(2) & 0xff, m_data.at(3) & 0xff);
     m_decrypter.decrypt(m_data, 0, cipherBlockSize());
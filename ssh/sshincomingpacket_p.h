@@ -27,7 +27,9 @@
 
 #include "sshpacket_p.h"
 
+#include "sshcompressionfacility_p.h"
 #include "sshcryptofacility_p.h"
+#include "sshincomingbuffer_p.h"
 #include "sshpacketparser_p.h"
 
 #include <QStringList>
@@ -57,9 +59,9 @@ struct SshKeyExchangeReply
 {
     QByteArray k_s;
     QList<Botan::BigInt> hostKeyParameters; // DSS: p, q, g, y. RSA: e, n.
-    QByteArray q; // For ECDSA host keys only.
+    QByteArray q; // For ECDSA and Ed25519 host keys only.
     Botan::BigInt f; // For DH only.
-    QByteArray q_s; // For ECDH only.
+    QByteArray q_s; // For ECDH and Curve25519 only.
     QByteArray signatureBlob;
 };
 
@@ -172,8 +174,9 @@ class SshIncomingPacket : public AbstractSshPacket
 public:
     SshIncomingPacket();
 
-    void consumeData(QByteArray &data);
+    void consumeData(SshIncomingBuffer &data);
     void recreateKeys(const SshKeyExchange &keyExchange);
+    void enableDelayedCompression();
     void reset();
 
     SshKeyExchangeInit extractKeyExchangeInitData() const;
@@ -210,10 +213,12 @@ private:
     virtual void calculateLength() const;
 
     void decrypt();
-    void moveFirstBytes(QByteArray &target, QByteArray &source, int n);
+    void decompress();
+    void takeFirstBytes(SshIncomingBuffer &source, int n);
 
     quint32 m_serverSeqNr;
     SshDecryptionFacility m_decrypter;
+    SshDecompressor m_decompressor;
 };
 
 } // namespace Internal
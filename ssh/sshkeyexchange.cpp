@@ -34,18 +34,21 @@
 #include "sshincomingpacket_p.h"
 
 #include <botan/auto_rng.h>
+#include <botan/curve25519.h>
 #include <botan/dh.h>
 #include <botan/dl_group.h>
 #include <botan/dsa.h>
 #include <botan/ec_group.h>
 #include <botan/ecdh.h>
 #include <botan/ecdsa.h>
+#include <botan/ed25519.h>
 #include <botan/lookup.h>
 #include <botan/point_gfp.h>
 #include <botan/pubkey.h>
 #include <botan/rsa.h>
 #include <botan/types.h>
 
+#include <algorithm>
 #include <string>
 
 using namespace Botan;
@@ -82,7 +85,7 @@ SshKeyExchange::~SshKeyExchange() {}
 void SshKeyExchange::sendKexInitPacket(const QByteArray &serverId)
 {
     m_serverId = serverId;
-    m_clientKexInitPayload = m_sendFacility.sendKeyExchangeInitPacket();
+    m_clientKexInitPayload = m_sendFacility.sendKeyExchangeInitPacket(compressionAlgorithms());
 }
 
 bool SshKeyExchange::sendDhInitPacket(const SshIncomingPacket &serverKexInit)
@@ -99,7 +102,7 @@ bool SshKeyExchange::sendDhInitPacket(const SshIncomingPacket &serverKexInit)
     printNameList("MAC algorithms client to server", kexInitParams.macAlgorithmsClientToServer);
     printNameList("MAC algorithms server to client", kexInitParams.macAlgorithmsServerToClient);
     printNameList("Compression algorithms client to server", kexInitParams.compressionAlgorithmsClientToServer);
-    printNameList("Compression algorithms client to server", kexInitParams.compressionAlgorithmsClientToServer);
+    printNameList("Compression algorithms server to client", kexInitParams.compressionAlgorithmsServerToClient);
     printNameList("Languages client to server", kexInitParams.languagesClientToServer);
     printNameList("Languages server to client", kexInitParams.languagesServerToClient);
     qCDebug(sshLog, "First packet follows: %d", kexInitParams.firstKexPacketFollows);
@@ -108,8 +111,6 @@ bool SshKeyExchange::sendDhInitPacket(const SshIncomingPacket &serverKexInit)
                                                    kexInitParams.keyAlgorithms.names);
     m_serverHostKeyAlgo = SshCapabilities::findBestMatch(SshCapabilities::PublicKeyAlgorithms,
             kexInitParams.serverHostKeyAlgorithms.names);
-    determineHashingAlgorithm(kexInitParams, true);
-    determineHashingAlgorithm(kexInitParams, false);
 
     m_encryptionAlgo
         = SshCapabilities::findBestMatch(SshCapabilities::EncryptionAlgorithms,
@@ -117,13 +118,19 @@ bool SshKeyExchange::sendDhInitPacket(const SshIncomingPacket &serverKexInit)
     m_decryptionAlgo
         = SshCapabilities::findBestMatch(SshCapabilities::EncryptionAlgorithms,
               kexInitParams.encryptionAlgorithmsServerToClient.names);
-    SshCapabilities::findBestMatch(SshCapabilities::CompressionAlgorithms,
+    determineHashingAlgorithm(kexInitParams, true);
+    determineHashingAlgorithm(kexInitParams, false);
+    m_c2sCompressionAlgo = SshCapabilities::findBestMatch(compressionAlgorithms(),
         kexInitParams.compressionAlgorithmsClientToServer.names);
-    SshCapabilities::findBestMatch(SshCapabilities::CompressionAlgorithms,
+    m_s2cCompressionAlgo = SshCapabilities::findBestMatch(compressionAlgorithms(),
         kexInitParams.compressionAlgorithmsServerToClient.names);
 
     AutoSeeded_RNG rng;
-    if (m_kexAlgoName.startsWith(SshCapabilities::EcdhKexNamePrefix)) {
+    if (SshCapabilities::isCurve25519KexAlgo(m_kexAlgoName)) {
+        // RFC 8731: same message format as ECDH, Q_C is the raw 32 byte public value.
+        m_curve25519Key.reset(new Curve25519_PrivateKey(rng));
+        m_sendFacility.sendKeyEcdhInitPacket(convertByteArray(m_curve25519Key->public_value()));
+    } else if (m_kexAlgoName.startsWith(SshCapabilities::EcdhKexNamePrefix)) {
         m_ecdhKey.reset(new ECDH_PrivateKey(rng, EC_Group(botanKeyExchangeAlgoName(m_kexAlgoName))));
         m_sendFacility.sendKeyEcdhInitPacket(convertByteArray(m_ecdhKey->public_value()));
     } else {
@@ -135,12 +142,16 @@ bool SshKeyExchange::sendDhInitPacket(const SshIncomingPacket &serverKexInit)
     return kexInitParams.firstKexPacketFollows;
 }
 
-void SshKeyExchange::sendNewKeysPacket(const SshIncomingPacket &dhReply,
-    const QByteArray &clientId)
+void SshKeyExchange::readKeyExchangeReply(const SshIncomingPacket &dhReply)
 {
+    m_reply.reset(new SshKeyExchangeReply(
+                      dhReply.extractKeyExchangeReply(m_kexAlgoName, m_serverHostKeyAlgo)));
+}
 
-    const SshKeyExchangeReply &reply
-        = dhReply.extractKeyExchangeReply(m_kexAlgoName, m_serverHostKeyAlgo);
+void SshKeyExchange::computeSessionKeys(const QByteArray &clientId)
+{
+    QSSH_ASSERT_AND_RETURN(m_reply);
+    const SshKeyExchangeReply &reply = *m_reply;
     if (m_dhKey && (reply.f <= 0 || reply.f >= m_dhKey->group_p())) {
         throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_KEY_EXCHANGE_FAILED,
             "Server sent invalid f.");
@@ -169,6 +180,21 @@ void SshKeyExchange::sendNewKeysPacket(const SshIncomingPacket &dhReply,
         printData("y", AbstractSshPacket::encodeMpInt(m_dhKey->get_y()));
         printData("f", AbstractSshPacket::encodeMpInt(reply.f));
         m_dhKey.reset(nullptr);
+    } else if (m_curve25519Key) {
+        if (reply.q_s.size() != 32) {
+            throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_KEY_EXCHANGE_FAILED,
+                "Server sent invalid Curve25519 public value.");
+        }
+        concatenatedData // Q_C.
+                += AbstractSshPacket::encodeString(
+                    convertByteArray(m_curve25519Key->public_value()));
+        concatenatedData += AbstractSshPacket::encodeString(reply.q_s);
+        encodedK = m_curve25519Key->agree(convertByteArray(reply.q_s), reply.q_s.size());
+        m_curve25519Key.reset(nullptr);
+        if (std::all_of(encodedK.begin(), encodedK.end(), [](byte b) { return b == 0; })) {
+            throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_KEY_EXCHANGE_FAILED,
+                "Curve25519 key exchange produced an all-zero shared secret.");
+        }
     } else {
         Q_ASSERT(m_ecdhKey);
         concatenatedData // Q_C.
@@ -203,8 +229,18 @@ void SshKeyExchange::sendNewKeysPacket(const SshIncomingPacket &dhReply,
         RSA_PublicKey * const rsaKey
             = new RSA_PublicKey(reply.hostKeyParameters.at(1), reply.hostKeyParameters.at(0));
         sigKey.reset(rsaKey);
+    } else if (m_serverHostKeyAlgo == SshCapabilities::PubKeyEd25519) {
+        if (reply.q.size() != 32) {
+            throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_KEY_EXCHANGE_FAILED,
+                "Server sent invalid Ed25519 host key.");
+        }
+        sigKey.reset(new Ed25519_PublicKey(convertByteArray(reply.q), reply.q.size()));
     } else {
-        QSSH_ASSERT_AND_RETURN(m_serverHostKeyAlgo.startsWith(SshCapabilities::PubKeyEcdsaPrefix));
+        if (!m_serverHostKeyAlgo.startsWith(SshCapabilities::PubKeyEcdsaPrefix)) {
+            throw SshClientException(SshInternalError,
+                    SSH_TR("Unexpected host key algorithm \"%1\".")
+                    .arg(QString::fromLatin1(m_serverHostKeyAlgo)));
+        }
         const EC_Group domain(SshCapabilities::oid(m_serverHostKeyAlgo));
         const PointGFp point = domain.OS2ECP(convertByteArray(reply.q), reply.q.count());
         ECDSA_PublicKey * const ecdsaKey = new ECDSA_PublicKey(domain, point);
@@ -218,16 +254,35 @@ void SshKeyExchange::sendNewKeysPacket(const SshIncomingPacket &dhReply,
         throw SSH_SERVER_EXCEPTION(SSH_DISCONNECT_KEY_EXCHANGE_FAILED,
             "Invalid signature in key exchange reply packet.");
     }
+}
 
-    checkHostKey(reply.k_s);
+void SshKeyExchange::sendNewKeysPacket()
+{
+    QSSH_ASSERT_AND_RETURN(m_reply && !m_h.isEmpty());
+    checkHostKey(m_reply->k_s);
+    m_reply.reset();
 
     m_sendFacility.sendNewKeysPacket();
 }
 
+void SshKeyExchange::setNegotiatedState(const QByteArray &kexAlgo, const QByteArray &cryptAlgo,
+                                        const QByteArray &hMacAlgo, const QByteArray &k)
+{
+    m_kexAlgoName = kexAlgo;
+    m_encryptionAlgo = m_decryptionAlgo = cryptAlgo;
+    m_c2sHMacAlgo = m_s2cHMacAlgo = hMacAlgo;
+    m_c2sCompressionAlgo = m_s2cCompressionAlgo = compressionAlgorithms().first();
+    m_k = k;
+    m_hash = HashFunction::create_or_throw(botanHMacAlgoName(hashAlgoForKexAlgo()));
+    m_h = convertByteArray(m_hash->process(convertByteArray(m_k), m_k.size()));
+}
+
 QByteArray SshKeyExchange::hashAlgoForKexAlgo() const
 {
-    if (m_kexAlgoName == SshCapabilities::EcdhNistp256)
+    if (m_kexAlgoName == SshCapabilities::EcdhNistp256
+            || SshCapabilities::isCurve25519KexAlgo(m_kexAlgoName)) {
         return SshCapabilities::HMacSha256;
+    }
     if (m_kexAlgoName == SshCapabilities::EcdhNistp384)
         return SshCapabilities::HMacSha384;
     if (m_kexAlgoName == SshCapabilities::EcdhNistp521)
@@ -235,10 +290,22 @@ QByteArray SshKeyExchange::hashAlgoForKexAlgo() const
     return SshCapabilities::HMacSha1;
 }
 
+const QList<QByteArray> &SshKeyExchange::compressionAlgorithms() const
+{
+    return m_connParams.options & SshEnableCompression
+            ? SshCapabilities::CompressionAlgorithms
+            : SshCapabilities::NoCompressionAlgorithms;
+}
+
 void SshKeyExchange::determineHashingAlgorithm(const SshKeyExchangeInit &kexInit,
                                                bool serverToClient)
 {
     QByteArray * const algo = serverToClient ? &m_s2cHMacAlgo : &m_c2sHMacAlgo;
+    // The MAC is implied by AEAD ciphers, the negotiated one is not used.
+    if (SshCapabilities::isAeadCryptAlgo(serverToClient ? m_decryptionAlgo : m_encryptionAlgo)) {
+        algo->clear();
+        return;
+    }
     const QList<QByteArray> &serverCapabilities = serverToClient
             ? kexInit.macAlgorithmsServerToClient.names
             : kexInit.macAlgorithmsClientToServer.names;
@@ -33,6 +33,7 @@
 #include <memory>
 
 namespace Botan {
+class Curve25519_PrivateKey;
 class DH_PrivateKey;
 class ECDH_PrivateKey;
 class HashFunction;
@@ -42,6 +43,7 @@ namespace QSsh {
 namespace Internal {
 
 struct SshKeyExchangeInit;
+struct SshKeyExchangeReply;
 class SshSendFacility;
 class SshIncomingPacket;
 
@@ -56,8 +58,16 @@ public:
     // Returns true <=> the server sends a guessed package.
     bool sendDhInitPacket(const SshIncomingPacket &serverKexInit);
 
-    void sendNewKeysPacket(const SshIncomingPacket &dhReply,
-        const QByteArray &clientId);
+    // The reply to the DH init packet is handled in three steps, so that the expensive
+    // middle one can run on a worker thread: it only touches state owned by this object.
+    void readKeyExchangeReply(const SshIncomingPacket &dhReply);
+    void computeSessionKeys(const QByteArray &clientId);
+    void sendNewKeysPacket();
+
+    // Takes the algorithms and the shared secret as if they had been negotiated, so that the
+    // packet layer can be driven without a server (benchmarks). Both directions use the same ones.
+    void setNegotiatedState(const QByteArray &kexAlgo, const QByteArray &cryptAlgo,
+                            const QByteArray &hMacAlgo, const QByteArray &k);
 
     QByteArray k() const { return m_k; }
     QByteArray h() const { return m_h; }
@@ -66,9 +76,12 @@ public:
     QByteArray decryptionAlgo() const { return m_decryptionAlgo; }
     QByteArray hMacAlgoClientToServer() const { return m_c2sHMacAlgo; }
     QByteArray hMacAlgoServerToClient() const { return m_s2cHMacAlgo; }
+    QByteArray compressionAlgoClientToServer() const { return m_c2sCompressionAlgo; }
+    QByteArray compressionAlgoServerToClient() const { return m_s2cCompressionAlgo; }
 
 private:
     QByteArray hashAlgoForKexAlgo() const;
+    const QList<QByteArray> &compressionAlgorithms() const;
     void determineHashingAlgorithm(const SshKeyExchangeInit &kexInit, bool serverToClient);
     void checkHostKey(const QByteArray &hostKey);
     Q_NORETURN void throwHostKeyException();
@@ -78,6 +91,8 @@ private:
     QByteArray m_serverKexInitPayload;
     QScopedPointer<Botan::DH_PrivateKey> m_dhKey;
     QScopedPointer<Botan::ECDH_PrivateKey> m_ecdhKey;
+    QScopedPointer<Botan::Curve25519_PrivateKey> m_curve25519Key;
+    QScopedPointer<SshKeyExchangeReply> m_reply;
     QByteArray m_kexAlgoName;
     QByteArray m_k;
     QByteArray m_h;
@@ -86,6 +101,8 @@ private:
     QByteArray m_decryptionAlgo;
     QByteArray m_c2sHMacAlgo;
     QByteArray m_s2cHMacAlgo;
+    QByteArray m_c2sCompressionAlgo;
+    QByteArray m_s2cCompressionAlgo;
     std::unique_ptr<Botan::HashFunction> m_hash;
     const SshConnectionParameters m_connParams;
     SshSendFacility &m_sendFacility;
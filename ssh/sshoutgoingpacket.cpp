@@ -27,6 +27,7 @@
 
 #include "sshagent_p.h"
 #include "sshcapabilities_p.h"
+#include "sshcompressionfacility_p.h"
 #include "sshcryptofacility_p.h"
 #include "sshlogging_p.h"
 #include "sshpacketparser_p.h"
@@ -37,7 +38,8 @@ namespace QSsh {
 namespace Internal {
 
 SshOutgoingPacket::SshOutgoingPacket(const SshEncryptionFacility &encrypter,
-    const quint32 &seqNr) : m_encrypter(encrypter), m_seqNr(seqNr)
+    SshCompressor &compressor, const quint32 &seqNr)
+    : m_encrypter(encrypter), m_compressor(compressor), m_seqNr(seqNr)
 {
 }
 
@@ -51,7 +53,8 @@ quint32 SshOutgoingPacket::macLength() const
     return m_encrypter.macLength();
 }
 
-QByteArray SshOutgoingPacket::generateKeyExchangeInitPacket()
+QByteArray SshOutgoingPacket::generateKeyExchangeInitPacket(
+        const QList<QByteArray> &compressionAlgorithms)
 {
     const QByteArray &supportedkeyExchangeMethods
         = encodeNameList(SshCapabilities::KeyExchangeMethods);
@@ -62,7 +65,7 @@ QByteArray SshOutgoingPacket::generateKeyExchangeInitPacket()
     const QByteArray &supportedMacAlgorithms
         = encodeNameList(SshCapabilities::MacAlgorithms);
     const QByteArray &supportedCompressionAlgorithms
-        = encodeNameList(SshCapabilities::CompressionAlgorithms);
+        = encodeNameList(compressionAlgorithms);
     const QByteArray &supportedLanguages = encodeNameList(QList<QByteArray>());
 
     init(SSH_MSG_KEXINIT);
@@ -136,13 +139,25 @@ void SshOutgoingPacket::generateUserAuthByPublicKeyRequestPacket(const QByteArra
     finalize();
 }
 
+std::function<QByteArray()> SshOutgoingPacket::userAuthByPublicKeySigner(const QByteArray &user,
+    const QByteArray &service) const
+{
+    // Same payload as the signed part of generateUserAuthByPublicKeyRequestPacket().
+    SshOutgoingPacket packetToSign(m_encrypter, m_compressor, m_seqNr);
+    packetToSign.init(SSH_MSG_USERAUTH_REQUEST).appendString(user).appendString(service)
+            .appendString("publickey").appendBool(true)
+            .appendString(m_encrypter.authenticationAlgorithmName())
+            .appendString(m_encrypter.authenticationPublicKey());
+    return m_encrypter.authenticationKeySigner(packetToSign.m_data.mid(PayloadOffset));
+}
+
 void SshOutgoingPacket::generateQueryPublicKeyPacket(const QByteArray &user,
         const QByteArray &service, const QByteArray &publicKey)
 {
     // Name extraction cannot fail, we already verified this when receiving the key
     // from the agent.
     const QByteArray algoName = SshPacketParser::asString(publicKey, quint32(0));
-    SshOutgoingPacket packetToSign(m_encrypter, m_seqNr);
+    SshOutgoingPacket packetToSign(m_encrypter, m_compressor, m_seqNr);
     packetToSign.init(SSH_MSG_USERAUTH_REQUEST).appendString(user).appendString(service)
             .appendString("publickey").appendBool(true).appendString(algoName)
             .appendString(publicKey);
@@ -269,11 +284,19 @@ void SshOutgoingPacket::generateWindowAdjustPacket(quint32 remoteChannel,
         .appendInt(bytesToAdd).finalize();
 }
 
+// Copies size bytes, starting at offset in the first chunk, straight into the packet buffer.
 void SshOutgoingPacket::generateChannelDataPacket(quint32 remoteChannel,
-    const QByteArray &data)
-{
-    init(SSH_MSG_CHANNEL_DATA).appendInt(remoteChannel).appendString(data)
-        .finalize();
+    const QList<QByteArray> &chunks, int offset, quint32 size)
+{
+    init(SSH_MSG_CHANNEL_DATA).appendInt(remoteChannel).appendInt(size);
+    for (int i = 0; size > 0; ++i) {
+        const QByteArray &chunk = chunks.at(i);
+        const int bytes = qMin<quint32>(chunk.size() - offset, size);
+        m_data.append(chunk.constData() + offset, bytes);
+        size -= bytes;
+        offset = 0;
+    }
+    finalize();
 }
 
 void SshOutgoingPacket::generateChannelSignalPacket(quint32 remoteChannel,
@@ -358,7 +381,9 @@ SshOutgoingPacket &SshOutgoingPacket::setPadding()
     m_data += m_encrypter.getRandomNumbers(MinPaddingLength);
     int padLength = MinPaddingLength;
     const int divisor = sizeDivisor();
-    const int mod = m_data.size() % divisor;
+    // With AEAD ciphers the length field is not encrypted and does not count.
+    const int encryptedSize = m_encrypter.isAead() ? m_data.size() - 4 : m_data.size();
+    const int mod = encryptedSize % divisor;
     padLength += divisor - mod;
     m_data += m_encrypter.getRandomNumbers(padLength - MinPaddingLength);
     m_data[PaddingLengthOffset] = padLength;
@@ -367,6 +392,10 @@ SshOutgoingPacket &SshOutgoingPacket::setPadding()
 
 SshOutgoingPacket &SshOutgoingPacket::encrypt()
 {
+    if (m_encrypter.isAead()) {
+        m_encrypter.encryptAead(m_data, m_seqNr);
+        return *this;
+    }
     const QByteArray &mac
         = generateMac(m_encrypter, m_seqNr);
     m_encrypter.encrypt(m_data);
@@ -376,6 +405,8 @@ SshOutgoingPacket &SshOutgoingPacket::encrypt()
 
 void SshOutgoingPacket::finalize()
 {
+    if (m_compressor.isActive())
+        m_compressor.compress(m_data, PayloadOffset);
     setPadding();
     setLengthField(m_data);
     m_length = m_data.size() - 4;
@@ -31,18 +31,22 @@
 
 #include <QStringList>
 
+#include <functional>
+
 namespace QSsh {
 namespace Internal {
 
+class SshCompressor;
 class SshEncryptionFacility;
 
 class SshOutgoingPacket : public AbstractSshPacket
 {
 public:
-    SshOutgoingPacket(const SshEncryptionFacility &encrypter,
+    SshOutgoingPacket(const SshEncryptionFacility &encrypter, SshCompressor &compressor,
         const quint32 &seqNr);
 
-    QByteArray generateKeyExchangeInitPacket(); // Returns payload.
+    QByteArray generateKeyExchangeInitPacket(
+        const QList<QByteArray> &compressionAlgorithms); // Returns payload.
     void generateKeyDhInitPacket(const Botan::BigInt &e);
     void generateKeyEcdhInitPacket(const QByteArray &clientQ);
     void generateNewKeysPacket();
@@ -54,6 +58,8 @@ public:
         const QByteArray &service, const QByteArray &pwd);
     void generateUserAuthByPublicKeyRequestPacket(const QByteArray &user,
         const QByteArray &service, const QByteArray &key, const QByteArray &signature);
+    std::function<QByteArray()> userAuthByPublicKeySigner(const QByteArray &user,
+        const QByteArray &service) const;
     void generateQueryPublicKeyPacket(const QByteArray &user, const QByteArray &service,
                                       const QByteArray &publicKey);
     void generateUserAuthByKeyboardInteractiveRequestPacket(const QByteArray &user,
@@ -77,8 +83,8 @@ public:
     void generateShellPacket(quint32 remoteChannel);
     void generateSftpPacket(quint32 remoteChannel);
     void generateWindowAdjustPacket(quint32 remoteChannel, quint32 bytesToAdd);
-    void generateChannelDataPacket(quint32 remoteChannel,
-        const QByteArray &data);
+    void generateChannelDataPacket(quint32 remoteChannel, const QList<QByteArray> &chunks,
+        int offset, quint32 size);
     void generateChannelSignalPacket(quint32 remoteChannel,
         const QByteArray &signalName);
     void generateChannelEofPacket(quint32 remoteChannel);
@@ -108,6 +114,7 @@ private:
     int sizeDivisor() const;
 
     const SshEncryptionFacility &m_encrypter;
+    SshCompressor &m_compressor;
     const quint32 &m_seqNr;
 };
 
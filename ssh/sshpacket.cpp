@@ -61,7 +61,8 @@ bool AbstractSshPacket::isComplete() const
 
 void AbstractSshPacket::clear()
 {
-    m_data.clear();
+    // Keeps a reserved allocation for the next packet.
+    m_data.resize(0);
     m_length = 0;
 }
 
@@ -132,10 +133,7 @@ void AbstractSshPacket::calculateLength() const
 QByteArray AbstractSshPacket::generateMac(const SshAbstractCryptoFacility &crypt,
     quint32 seqNr) const
 {
-    const quint32 seqNrBe = qToBigEndian(seqNr);
-    QByteArray data(reinterpret_cast<const char *>(&seqNrBe), sizeof seqNrBe);
-    data += QByteArray(m_data.constData(), length() + 4);
-    return crypt.generateMac(data, data.size());
+    return crypt.generateMac(seqNr, m_data, length() + 4);
 }
 
 quint32 AbstractSshPacket::minPacketSize() const
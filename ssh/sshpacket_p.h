@@ -36,6 +36,9 @@ namespace Botan { class BigInt; }
 namespace QSsh {
 namespace Internal {
 
+// Largest packet_length accepted from the server, the same limit as OpenSSH's (RFC 4253, 6.1).
+const quint32 MaxIncomingPacketLength = 256 * 1024;
+
 enum SshPacketType {
     SSH_MSG_DISCONNECT = 1,
     SSH_MSG_IGNORE = 2,
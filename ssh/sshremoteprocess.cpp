@@ -110,6 +110,28 @@ QByteArray SshRemoteProcess::readAllStandardError()
     return readAllFromChannel(QProcess::StandardError);
 }
 
+QByteArray SshRemoteProcess::takeStandardOutput()
+{
+    return takeFromChannel(QProcess::StandardOutput);
+}
+
+QByteArray SshRemoteProcess::takeStandardError()
+{
+    return takeFromChannel(QProcess::StandardError);
+}
+
+quint64 SshRemoteProcess::copiedBytes() const
+{
+    return d->m_copiedBytes;
+}
+
+QByteArray SshRemoteProcess::takeFromChannel(QProcess::ProcessChannel channel)
+{
+    QByteArray data;
+    data.swap(channel == QProcess::StandardOutput ? d->m_stdout : d->m_stderr);
+    return data;
+}
+
 QByteArray SshRemoteProcess::readAllFromChannel(QProcess::ProcessChannel channel)
 {
     const QProcess::ProcessChannel currentReadChannel = readChannel();
@@ -130,6 +152,7 @@ qint64 SshRemoteProcess::readData(char *data, qint64 maxlen)
     const qint64 bytesRead = qMin(qint64(d->data().count()), maxlen);
     memcpy(data, d->data().constData(), bytesRead);
     d->data().remove(0, bytesRead);
+    d->m_copiedBytes += bytesRead;
     return bytesRead;
 }
 
@@ -255,6 +278,7 @@ void SshRemoteProcessPrivate::init()
     m_exitCode = 0;
     m_readChannel = QProcess::StandardOutput;
     m_signal = SshRemoteProcess::NoSignal;
+    m_copiedBytes = 0;
 }
 
 void SshRemoteProcessPrivate::setProcState(ProcessState newState)
@@ -274,6 +298,17 @@ QByteArray &SshRemoteProcessPrivate::data()
     return m_readChannel == QProcess::StandardOutput ? m_stdout : m_stderr;
 }
 
+void SshRemoteProcessPrivate::appendData(QByteArray &buffer, const QByteArray &data)
+{
+    // The payload itself was copied once out of the decrypted packet.
+    m_copiedBytes += data.size();
+    // Appending to an empty buffer only shares the data; a copy is made
+    // only if the previous chunk has not been taken yet.
+    if (!buffer.isEmpty())
+        m_copiedBytes += data.size();
+    buffer += data;
+}
+
 void SshRemoteProcessPrivate::closeHook()
 {
     if (m_wasRunning) {
@@ -331,7 +366,7 @@ void SshRemoteProcessPrivate::handleChannelFailure()
 
 void SshRemoteProcessPrivate::handleChannelDataInternal(const QByteArray &data)
 {
-    m_stdout += data;
+    appendData(m_stdout, data);
     emit readyReadStandardOutput();
     if (m_readChannel == QProcess::StandardOutput)
         emit readyRead();
@@ -343,7 +378,7 @@ void SshRemoteProcessPrivate::handleChannelExtendedDataInternal(quint32 type,
     if (type != SSH_EXTENDED_DATA_STDERR) {
         qCWarning(sshLog, "Unknown extended data type %u", type);
     } else {
-        m_stderr += data;
+        appendData(m_stderr, data);
         emit readyReadStandardError();
         if (m_readChannel == QProcess::StandardError)
             emit readyRead();
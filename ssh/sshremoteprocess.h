@@ -87,6 +87,17 @@ public:
     QByteArray readAllStandardOutput();
     QByteArray readAllStandardError();
 
+    /*
+     * Hand over the buffered channel payload without copying it. The returned
+     * QByteArray shares the data extracted from the incoming packet. Do not
+     * mix with the QIODevice read functions for the same channel.
+     */
+    QByteArray takeStandardOutput();
+    QByteArray takeStandardError();
+
+    // Number of payload bytes copied on the way from the channel to the caller.
+    quint64 copiedBytes() const;
+
     // Note: This is ignored by the OpenSSH server.
     void sendSignal(Signal signal);
     void kill() { sendSignal(KillSignal); }
@@ -114,6 +125,7 @@ private:
 
     void init();
     QByteArray readAllFromChannel(QProcess::ProcessChannel channel);
+    QByteArray takeFromChannel(QProcess::ProcessChannel channel);
 
     Internal::SshRemoteProcessPrivate *d;
 };
@@ -77,6 +77,7 @@ private:
     void init();
     void setProcState(ProcessState newState);
     QByteArray &data();
+    void appendData(QByteArray &buffer, const QByteArray &data);
 
     QProcess::ProcessChannel m_readChannel;
 
@@ -95,6 +96,7 @@ private:
 
     QByteArray m_stdout;
     QByteArray m_stderr;
+    quint64 m_copiedBytes;
 
     SshRemoteProcess *m_proc;
 };
@@ -30,14 +30,21 @@
 #include "sshoutgoingpacket_p.h"
 
 #include <QTcpSocket>
+#include <QTimer>
 
 namespace QSsh {
 namespace Internal {
 
 SshSendFacility::SshSendFacility(QTcpSocket *socket)
     : m_clientSeqNr(0), m_socket(socket),
-      m_outgoingPacket(m_encrypter, m_clientSeqNr)
+      m_outgoingPacket(m_encrypter, m_compressor, m_clientSeqNr), m_coalesceWrites(false),
+      m_flushTimer(new QTimer(socket)) // Follows the socket when the connection changes threads.
 {
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(0);
+    QObject::connect(m_flushTimer, &QTimer::timeout, m_socket, [this] { flush(); });
+    QObject::connect(m_socket, &QTcpSocket::bytesWritten, m_socket,
+                     [this] { ++m_statistics.socketFlushes; });
 }
 
 void SshSendFacility::sendPacket()
@@ -45,20 +52,64 @@ void SshSendFacility::sendPacket()
     qCDebug(sshLog, "Sending packet, client seq nr is %u", m_clientSeqNr);
     if (m_socket->isValid()
         && m_socket->state() == QAbstractSocket::ConnectedState) {
-        m_socket->write(m_outgoingPacket.rawData());
+        ++m_statistics.packets;
+        if (m_coalesceWrites) {
+            m_writeBuffer += m_outgoingPacket.rawData();
+            if (!m_flushTimer->isActive())
+                m_flushTimer->start();
+        } else {
+            writeToSocket(m_outgoingPacket.rawData());
+        }
         ++m_clientSeqNr;
     }
 }
 
+void SshSendFacility::writeToSocket(const QByteArray &data)
+{
+    m_socket->write(data);
+    ++m_statistics.socketWrites;
+    m_statistics.bytes += data.size();
+}
+
+void SshSendFacility::flush()
+{
+    m_flushTimer->stop();
+    if (m_writeBuffer.isEmpty())
+        return;
+    if (m_socket->isValid() && m_socket->state() == QAbstractSocket::ConnectedState)
+        writeToSocket(m_writeBuffer);
+    m_writeBuffer.resize(0); // The socket has copied the data, keep the capacity.
+}
+
+void SshSendFacility::setCoalesceWrites(bool coalesce)
+{
+    if (!coalesce)
+        flush();
+    m_coalesceWrites = coalesce;
+}
+
+SshWriteStatistics SshSendFacility::statistics() const
+{
+    SshWriteStatistics result = m_statistics;
+    result.elapsedMs = m_statisticsTimer.isValid() ? m_statisticsTimer.elapsed() : 0;
+    return result;
+}
+
 void SshSendFacility::reset()
 {
     m_clientSeqNr = 0;
     m_encrypter.clearKeys();
+    m_compressor.reset();
+    m_flushTimer->stop();
+    m_writeBuffer.clear();
+    m_statistics = SshWriteStatistics();
+    m_statisticsTimer.start();
 }
 
 void SshSendFacility::recreateKeys(const SshKeyExchange &keyExchange)
 {
     m_encrypter.recreateKeys(keyExchange);
+    m_compressor.recreate(keyExchange.compressionAlgoClientToServer());
 }
 
 void SshSendFacility::createAuthenticationKey(const QByteArray &privKeyFileContents)
@@ -66,9 +117,16 @@ void SshSendFacility::createAuthenticationKey(const QByteArray &privKeyFileConte
     m_encrypter.createAuthenticationKey(privKeyFileContents);
 }
 
-QByteArray SshSendFacility::sendKeyExchangeInitPacket()
+void SshSendFacility::enableDelayedCompression()
+{
+    m_compressor.enableDelayedCompression();
+}
+
+QByteArray SshSendFacility::sendKeyExchangeInitPacket(
+        const QList<QByteArray> &compressionAlgorithms)
 {
-    const QByteArray &payLoad = m_outgoingPacket.generateKeyExchangeInitPacket();
+    const QByteArray &payLoad
+            = m_outgoingPacket.generateKeyExchangeInitPacket(compressionAlgorithms);
     sendPacket();
     return payLoad;
 }
@@ -96,7 +154,8 @@ void SshSendFacility::sendDisconnectPacket(SshErrorCode reason,
 {
     m_outgoingPacket.generateDisconnectPacket(reason, reasonString);
     sendPacket();
-    }
+    flush(); // The socket is closed right after this packet.
+}
 
 void SshSendFacility::sendMsgUnimplementedPacket(quint32 serverSeqNr)
 {
@@ -124,6 +183,12 @@ void SshSendFacility::sendUserAuthByPublicKeyRequestPacket(const QByteArray &use
     sendPacket();
 }
 
+std::function<QByteArray()> SshSendFacility::userAuthByPublicKeySigner(const QByteArray &user,
+    const QByteArray &service) const
+{
+    return m_outgoingPacket.userAuthByPublicKeySigner(user, service);
+}
+
 void SshSendFacility::sendQueryPublicKeyPacket(const QByteArray &user, const QByteArray &service,
                                                const QByteArray &publicKey)
 {
@@ -232,9 +297,9 @@ void SshSendFacility::sendWindowAdjustPacket(quint32 remoteChannel,
 }
 
 void SshSendFacility::sendChannelDataPacket(quint32 remoteChannel,
-    const QByteArray &data)
+    const QList<QByteArray> &chunks, int offset, quint32 size)
 {
-    m_outgoingPacket.generateChannelDataPacket(remoteChannel, data);
+    m_outgoingPacket.generateChannelDataPacket(remoteChannel, chunks, offset, size);
     sendPacket();
 }
 
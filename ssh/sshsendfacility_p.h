@@ -25,13 +25,17 @@
 
 #pragma once
 
+#include "sshcompressionfacility_p.h"
 #include "sshcryptofacility_p.h"
 #include "sshoutgoingpacket_p.h"
+#include "sshconnection.h"
 
+#include <QElapsedTimer>
 #include <QStringList>
 
 QT_BEGIN_NAMESPACE
 class QTcpSocket;
+class QTimer;
 QT_END_NAMESPACE
 
 
@@ -48,10 +52,17 @@ public:
     void reset();
     void recreateKeys(const SshKeyExchange &keyExchange);
     void createAuthenticationKey(const QByteArray &privKeyFileContents);
+    void enableDelayedCompression();
+
+    // Gathers packets and writes them with one socket write per event loop iteration.
+    void setCoalesceWrites(bool coalesce);
+    void flush();
+    SshWriteStatistics statistics() const;
 
     QByteArray sessionId() const { return m_encrypter.sessionId(); }
+    QByteArray authenticationPublicKey() const { return m_encrypter.authenticationPublicKey(); }
 
-    QByteArray sendKeyExchangeInitPacket();
+    QByteArray sendKeyExchangeInitPacket(const QList<QByteArray> &compressionAlgorithms);
     void sendKeyDhInitPacket(const Botan::BigInt &e);
     void sendKeyEcdhInitPacket(const QByteArray &clientQ);
     void sendNewKeysPacket();
@@ -63,6 +74,8 @@ public:
         const QByteArray &service, const QByteArray &pwd);
     void sendUserAuthByPublicKeyRequestPacket(const QByteArray &user,
         const QByteArray &service, const QByteArray &key, const QByteArray &signature);
+    std::function<QByteArray()> userAuthByPublicKeySigner(const QByteArray &user,
+        const QByteArray &service) const;
     void sendQueryPublicKeyPacket(const QByteArray &user, const QByteArray &service,
                                   const QByteArray &publicKey);
     void sendUserAuthByKeyboardInteractiveRequestPacket(const QByteArray &user,
@@ -86,7 +99,8 @@ public:
     void sendShellPacket(quint32 remoteChannel);
     void sendSftpPacket(quint32 remoteChannel);
     void sendWindowAdjustPacket(quint32 remoteChannel, quint32 bytesToAdd);
-    void sendChannelDataPacket(quint32 remoteChannel, const QByteArray &data);
+    void sendChannelDataPacket(quint32 remoteChannel, const QList<QByteArray> &chunks,
+        int offset, quint32 size);
     void sendChannelSignalPacket(quint32 remoteChannel,
         const QByteArray &signalName);
     void sendChannelEofPacket(quint32 remoteChannel);
@@ -99,11 +113,18 @@ public:
 
 private:
     void sendPacket();
+    void writeToSocket(const QByteArray &data);
 
     quint32 m_clientSeqNr;
     SshEncryptionFacility m_encrypter;
+    SshCompressor m_compressor;
     QTcpSocket *m_socket;
     SshOutgoingPacket m_outgoingPacket;
+    bool m_coalesceWrites;
+    QByteArray m_writeBuffer;
+    QTimer *m_flushTimer;
+    SshWriteStatistics m_statistics;
+    QElapsedTimer m_statisticsTimer;
 };
 
 } // namespace Internal
@@ -0,0 +1,185 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#include "sshtrace.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
+#include <array>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+namespace QSsh {
+namespace {
+
+struct TraceEvent
+{
+    // Atomic, because a dump reads the buffer while its thread keeps writing
+    std::atomic<const char *> name{nullptr};
+    std::atomic<qint64> begin{0};
+    std::atomic<qint64> duration{0};
+};
+
+struct ThreadBuffer
+{
+    int threadId = 0;
+    QString threadName;
+    std::array<TraceEvent, SshTrace::threadEvents> events;
+    // Number of events ever written; only the owning thread writes
+    std::atomic<quint64> written{0};
+};
+
+struct TraceRegistry
+{
+    QMutex mutex;
+    // Buffers outlive their threads, so that a dump still has their events
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Q_GLOBAL_STATIC(TraceRegistry, traceRegistry)
+
+ThreadBuffer *currentThreadBuffer()
+{
+    static thread_local ThreadBuffer *buffer = nullptr;
+    if (!buffer) {
+        const std::shared_ptr<ThreadBuffer> newBuffer = std::make_shared<ThreadBuffer>();
+        QThread * const thread = QThread::currentThread();
+        TraceRegistry * const registry = traceRegistry();
+        QMutexLocker locker(&registry->mutex);
+        newBuffer->threadId = static_cast<int>(registry->buffers.size()) + 1;
+        newBuffer->threadName = thread && !thread->objectName().isEmpty()
+                ? thread->objectName()
+                : QString::fromLatin1("Thread %1").arg(newBuffer->threadId);
+        registry->buffers.push_back(newBuffer);
+        buffer = newBuffer.get();
+    }
+    return buffer;
+}
+
+QByteArray jsonString(const QString &value)
+{
+    QByteArray result = value.toUtf8();
+    result.replace('\\', "\\\\");
+    result.replace('"', "\\\"");
+    return '"' + result + '"';
+}
+
+QByteArray microseconds(qint64 nanoseconds)
+{
+    return QByteArray::number(nanoseconds / 1000.0, 'f', 3);
+}
+
+} // anonymous namespace
+
+std::atomic<bool> SshTrace::m_enabled{false};
+
+void SshTrace::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+qint64 SshTrace::nanoseconds()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SshTrace::record(const char *name, qint64 begin, qint64 duration)
+{
+    ThreadBuffer * const buffer = currentThreadBuffer();
+    const quint64 written = buffer->written.load(std::memory_order_relaxed);
+    TraceEvent &event = buffer->events[written % threadEvents];
+    event.name.store(name, std::memory_order_relaxed);
+    event.begin.store(begin, std::memory_order_relaxed);
+    event.duration.store(duration, std::memory_order_relaxed);
+    buffer->written.store(written + 1, std::memory_order_release);
+}
+
+QByteArray SshTrace::chromeTrace()
+{
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+    {
+        TraceRegistry * const registry = traceRegistry();
+        QMutexLocker locker(&registry->mutex);
+        buffers = registry->buffers;
+    }
+
+    const QByteArray pid = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray result = "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    bool first = true;
+    const auto append = [&result, &first](const QByteArray &event) {
+        if (!first)
+            result += ",\n";
+        result += event;
+        first = false;
+    };
+
+    for (const std::shared_ptr<ThreadBuffer> &buffer : buffers) {
+        const QByteArray tid = QByteArray::number(buffer->threadId);
+        append("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"tid\":" + tid
+               + ",\"args\":{\"name\":" + jsonString(buffer->threadName) + "}}");
+
+        const quint64 end = buffer->written.load(std::memory_order_acquire);
+        const quint64 begin = end > threadEvents ? end - threadEvents : 0;
+        std::vector<QByteArray> events;
+        events.reserve(end - begin);
+        for (quint64 index = begin; index < end; ++index) {
+            const TraceEvent &event = buffer->events[index % threadEvents];
+            events.push_back("{\"name\":\"" + QByteArray(event.name.load(std::memory_order_relaxed)) + "\",\"ph\":\"X\",\"pid\":" + pid
+                             + ",\"tid\":" + tid
+                             + ",\"ts\":" + microseconds(event.begin.load(std::memory_order_relaxed))
+                             + ",\"dur\":" + microseconds(event.duration.load(std::memory_order_relaxed))
+                             + '}');
+        }
+
+        // The thread kept writing while its buffer was read: drop the slots it has overwritten since
+        const quint64 endAfterRead = buffer->written.load(std::memory_order_acquire);
+        const quint64 overwritten = endAfterRead > begin + threadEvents
+                ? qMin<quint64>(endAfterRead - begin - threadEvents, events.size()) : 0;
+        for (size_t index = overwritten; index < events.size(); ++index)
+            append(events[index]);
+    }
+
+    result += "\n]}\n";
+    return result;
+}
+
+bool SshTrace::writeChromeTrace(const QString &filePath, QString *errorString)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(chromeTrace()) < 0) {
+        if (errorString)
+            *errorString = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+} // namespace QSsh
@@ -0,0 +1,84 @@
+/****************************************************************************
+**
+** Copyright (C) 2016 The Qt Company Ltd.
+** Contact: https://www.qt.io/licensing/
+**
+** This file is part of Qt Creator.
+**
+** Commercial License Usage
+** Licensees holding valid commercial Qt licenses may use this file in
+** accordance with the commercial license agreement provided with the
+** Software or, alternatively, in accordance with the terms contained in
+** a written agreement between you and The Qt Company. For licensing terms
+** and conditions see https://www.qt.io/terms-conditions. For further
+** information use the contact form at https://www.qt.io/contact-us.
+**
+** GNU General Public License Usage
+** Alternatively, this file may be used under the terms of the GNU
+** General Public License version 3 as published by the Free Software
+** Foundation with exceptions as appearing in the file LICENSE.GPL3-EXCEPT
+** included in the packaging of this file. Please review the following
+** information to ensure the GNU General Public License requirements will
+** be met: https://www.gnu.org/licenses/gpl-3.0.html.
+**
+****************************************************************************/
+
+#pragma once
+
+#include "ssh_global.h"
+
+#include <QByteArray>
+#include <QString>
+
+#include <atomic>
+
+namespace QSsh {
+
+// Scoped trace points recorded into a ring buffer per thread and written as a Chrome trace
+// (chrome://tracing, ui.perfetto.dev). While tracing is disabled a trace point costs one relaxed load.
+class QSSH_EXPORT SshTrace
+{
+public:
+    // Older events of a thread are overwritten
+    static constexpr int threadEvents = 64 * 1024;
+
+    static void setEnabled(bool enabled);
+    static bool isEnabled() { return m_enabled.load(std::memory_order_relaxed); }
+
+    static qint64 nanoseconds();
+    // name must be a string literal, only the pointer is stored
+    static void record(const char *name, qint64 begin, qint64 duration);
+
+    // Chrome trace JSON of the events in all ring buffers
+    static QByteArray chromeTrace();
+    static bool writeChromeTrace(const QString &filePath, QString *errorString = nullptr);
+
+private:
+    static std::atomic<bool> m_enabled;
+};
+
+class SshTraceScope
+{
+public:
+    explicit SshTraceScope(const char *name)
+        : m_name(SshTrace::isEnabled() ? name : nullptr), m_begin(m_name ? SshTrace::nanoseconds() : 0)
+    { }
+    ~SshTraceScope()
+    {
+        if (m_name)
+            SshTrace::record(m_name, m_begin, SshTrace::nanoseconds() - m_begin);
+    }
+
+private:
+    SshTraceScope(const SshTraceScope &) = delete;
+    SshTraceScope &operator=(const SshTraceScope &) = delete;
+
+    const char * const m_name;
+    const qint64 m_begin;
+};
+
+} // namespace QSsh
+
+#define QSSH_TRACE_CONCAT_IMPL(a, b) a##b
+#define QSSH_TRACE_CONCAT(a, b) QSSH_TRACE_CONCAT_IMPL(a, b)
+#define QSSH_TRACE_SCOPE(name) const QSsh::SshTraceScope QSSH_TRACE_CONCAT(sshTraceScope, __LINE__)(name)